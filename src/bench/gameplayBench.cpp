@@ -0,0 +1,302 @@
+#include "gameplayBench.h"
+
+
+/**
+ * @brief GameplayBench class constructor
+ * @details Generates the maze, writes it to a temporary file and starts
+ * playtesting it. The Gameplay is given no window, since it only draws in
+ * render(), which is not benchmarked; the grid is drawn into m_target
+ * instead, which is the size of the game window.
+ * @throw SFML exceptions may be thrown during fatal errors, especially if
+ * assets fail to load. Like the game, it must be run from a directory next
+ * to assets.
+ * @param size - the width and height of the maze in tiles.
+ * @param sampleSeconds - the shortest time a timed batch of calls takes.
+ */
+GameplayBench::GameplayBench(unsigned int size, double sampleSeconds) :
+m_size(size),
+m_sampleSeconds(sampleSeconds),
+m_maze(makeMaze(size)),
+m_settings(std::make_shared<Settings>()),
+m_jobs(std::make_shared<JobSystem>()),
+m_spawn(1, 1),
+m_sink(0)
+{
+    m_mazeFile = (std::filesystem::temp_directory_path() / ("bench_" + std::to_string(size) + ".maze")).string();
+    m_maze.saveToFile(m_mazeFile);
+
+    m_settings->playMusic = false;
+    m_settings->playAudio = false;
+    m_settings->difficulty = 0;
+    m_settings->frameRate = 60;
+    m_settings->showFps = false;
+    m_gameplay = std::make_unique<Gameplay>(nullptr, m_settings, m_jobs, nullptr, 1000, 600, m_maze, m_spawn);
+    m_spawnUpperLeft = m_gameplay->upperLeftSquare;
+    m_target.create(1000, 600);
+
+    std::mt19937 random(SEED);
+    while (m_positions.size() < POSITIONS)
+    {
+        unsigned int x = random() % size;
+        unsigned int y = random() % size; // drawn one at a time, argument order is unspecified
+        sf::Vector2i tile(x, y);
+        if (m_maze.get(tile.x, tile.y) != TileGrid::WALL)
+        {
+            m_positions.push_back(tile);
+        }
+    }
+}
+
+
+/**
+ * @brief Destructor for the GameplayBench class.
+ * @details Deletes the temporary maze file.
+ */
+GameplayBench::~GameplayBench()
+{
+    std::error_code error;
+    std::filesystem::remove(m_mazeFile, error);
+}
+
+
+/**
+ * @brief Times every benchmark once.
+ * @details Each benchmark is named after the function it times. Collision is
+ * checked with the player walking right, with full health and no lasting
+ * damage, so every call does the same work for the tiles it is on.
+ * @throw SFML exceptions may be thrown during fatal errors.
+ * @param None
+ * @return std::vector<Result> - one result per benchmark
+ */
+std::vector<GameplayBench::Result> GameplayBench::run()
+{
+    std::vector<Result> results;
+    results.push_back(measure("loadFromFile", [this](std::size_t)
+    {
+        TileGrid level;
+        level.loadFromFile(m_mazeFile);
+        m_sink += level.size();
+    }));
+    results.push_back(measure("saveToFile", [this](std::size_t)
+    {
+        m_sink += m_maze.saveToFile(m_mazeFile);
+    }));
+    results.push_back(measure("populateGrid", [this](std::size_t)
+    {
+        m_gameplay->populateGrid();
+    }));
+    results.push_back(measure("blocksPlayerIsOn", [this](std::size_t index)
+    {
+        placePlayer(index);
+        m_sink += m_gameplay->blocksPlayerIsOn().size();
+        FrameArena::reset();
+    }));
+    results.push_back(measure("calculateCollision", [this](std::size_t index)
+    {
+        placePlayer(index);
+        Player& player = m_gameplay->player;
+        player.healthPercent = 100;
+        player.status = Player::Alive;
+        player.burning = false;
+        player.poisoned = false;
+        player.burnLength = 0;
+        player.poisonedLength = 0;
+        player.velocity = sf::Vector2f(1, 0);
+        m_gameplay->calculateCollision();
+        m_gameplay->m_simState.changedTiles.clear(); // nothing takes the states here
+        m_gameplay->m_simState.revealed.clear();
+        FrameArena::reset();
+    }));
+    GameplayState state; // kept between calls like the game's, so the mask is only copied once
+    results.push_back(measure("renderGrid", [this, &state](std::size_t index)
+    {
+        placePlayer(index);
+        m_gameplay->captureState(state);
+        m_target.clear();
+        m_gameplay->renderGrid(m_target, state.scroll);
+        m_target.display();
+    }));
+    return results;
+}
+
+
+/**
+ * @brief Generates the same random maze of a size on every platform.
+ * @details The maze is walled in, with the start in the top left corner and
+ * the end in the bottom right. Inside, about a third of the tiles are walls
+ * and a few percent each are traps, fire, blood and disease. The raw output of
+ * std::mt19937 is used rather than a distribution, since only the engine is
+ * required to give the same numbers in every standard library.
+ * @throw std::bad_alloc if the maze cannot be allocated.
+ * @param size - the width and height of the maze, at least 3.
+ * @return TileGrid - the maze
+ */
+TileGrid GameplayBench::makeMaze(unsigned int size)
+{
+    std::mt19937 random(SEED + size);
+    std::vector<unsigned char> tiles(static_cast<std::size_t>(size) * size, static_cast<unsigned char>(TileGrid::WALL));
+    for (unsigned int x = 1; x + 1 < size; ++x)
+    {
+        for (unsigned int y = 1; y + 1 < size; ++y)
+        {
+            unsigned int roll = random() % 100;
+            unsigned char type = 0;
+            if (roll < 33)
+            {
+                type = TileGrid::WALL;
+            }
+            else if (roll < 36)
+            {
+                type = 1;
+            }
+            else if (roll < 39)
+            {
+                type = 2;
+            }
+            else if (roll < 41)
+            {
+                type = 3;
+            }
+            else if (roll < 44)
+            {
+                type = 5;
+            }
+            tiles[static_cast<std::size_t>(x) * size + y] = type;
+        }
+    }
+    tiles[static_cast<std::size_t>(1) * size + 1] = 6;
+    tiles[static_cast<std::size_t>(size - 2) * size + size - 2] = 7;
+
+    TileGrid maze;
+    maze.assign(size, tiles.data());
+    return maze;
+}
+
+
+/**
+ * @brief Writes results as JSON.
+ * @details Every result is written on a line of its own, which readJson()
+ * relies on.
+ * @throw None
+ * @param out - the stream to write to.
+ * @param results - the results to write.
+ * @return None
+ */
+void GameplayBench::writeJson(std::ostream& out, const std::vector<Result>& results)
+{
+    out << std::fixed << std::setprecision(1) << "{\n  \"benchmarks\": [\n";
+    for (std::size_t i = 0; i < results.size(); ++i)
+    {
+        const Result& result = results[i];
+        out << "    {\"name\": \"" << result.name << "\", \"size\": " << result.size
+            << ", \"iterations\": " << result.iterations << ", \"ns_per_op\": " << result.nsPerOp
+            << ", \"min_ns_per_op\": " << result.minNsPerOp << "}" << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    out << "  ]\n}\n";
+}
+
+
+/**
+ * @brief Reads results written by writeJson().
+ * @details Only understands the layout writeJson() produces, with one result
+ * per line; lines without a name are skipped.
+ * @throw None
+ * @param fileName - the JSON file to read.
+ * @return std::vector<Result> - the results, empty if the file cannot be read
+ */
+std::vector<GameplayBench::Result> GameplayBench::readJson(const std::string& fileName)
+{
+    std::vector<Result> results;
+    std::ifstream file(fileName);
+    std::string line;
+    while (std::getline(file, line))
+    {
+        auto field = [&line](const std::string& key) -> std::string
+        {
+            std::size_t start = line.find("\"" + key + "\": ");
+            if (start == std::string::npos)
+            {
+                return "";
+            }
+            start += key.size() + 4;
+            std::size_t end = line.find_first_of(",}", start);
+            std::string value = line.substr(start, end - start);
+            value.erase(std::remove(value.begin(), value.end(), '"'), value.end());
+            return value;
+        };
+
+        Result result;
+        result.name = field("name");
+        if (result.name.empty())
+        {
+            continue;
+        }
+        result.size = std::stoul("0" + field("size"));
+        result.iterations = std::stoull("0" + field("iterations"));
+        result.nsPerOp = std::stod("0" + field("ns_per_op"));
+        result.minNsPerOp = std::stod("0" + field("min_ns_per_op"));
+        results.push_back(result);
+    }
+    return results;
+}
+
+
+/**
+ * @brief Times a function called with an increasing index.
+ * @details The number of calls per batch is doubled until a batch takes at
+ * least m_sampleSeconds, which also warms up the caches and anything done
+ * lazily on the first calls. SAMPLES batches of that many calls are then
+ * timed.
+ * @throw Whatever the function throws.
+ * @param name - the name of the benchmark.
+ * @param function - called with the index of the call.
+ * @return Result - the timing of the function
+ */
+template <typename Function>
+GameplayBench::Result GameplayBench::measure(const std::string& name, Function function)
+{
+    std::size_t index = 0;
+    auto batch = [&](std::uint64_t iterations)
+    {
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        for (std::uint64_t i = 0; i < iterations; ++i)
+        {
+            function(index++);
+        }
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    };
+
+    Result result;
+    result.name = name;
+    result.size = m_size;
+    result.iterations = 1;
+    while (batch(result.iterations) < m_sampleSeconds)
+    {
+        result.iterations *= 2;
+    }
+
+    std::vector<double> samples;
+    for (int i = 0; i < SAMPLES; ++i)
+    {
+        samples.push_back(batch(result.iterations) * 1e9 / result.iterations);
+    }
+    std::sort(samples.begin(), samples.end());
+    result.nsPerOp = samples[samples.size() / 2];
+    result.minNsPerOp = samples.front();
+    return result;
+}
+
+
+/**
+ * @brief Moves the player onto one of m_positions.
+ * @details The player stays in the middle of the screen like in the game,
+ * and the grid is scrolled under them instead.
+ * @throw None
+ * @param index - any index, wrapped around m_positions.
+ * @return None
+ */
+void GameplayBench::placePlayer(std::size_t index)
+{
+    sf::Vector2i tile = m_positions[index % m_positions.size()];
+    m_gameplay->upperLeftSquare = m_spawnUpperLeft + tile - m_spawn;
+}
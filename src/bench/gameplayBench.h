@@ -0,0 +1,93 @@
+#pragma once
+
+
+// Included C++11 Libraries
+#include <vector>
+#include <string>
+#include <memory>
+#include <chrono>
+#include <cstdint>
+#include <random>
+#include <fstream>
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <filesystem>
+
+
+// Included Graphics Library Dependencies
+#include <SFML/Graphics.hpp>
+
+
+// Included Local Dependencies
+#include "gameplay.h"
+#include "tileGrid.h"
+
+
+/**
+ * Class Name: GameplayBench
+ * Brief: Microbenchmarks of maze I/O and the per-frame Gameplay functions.
+ * Description:
+ *  Builds a synthetic maze of a given size, plays it in a Gameplay with no
+ *  window, and times reading and writing it as a .maze file, populateGrid(),
+ *  blocksPlayerIsOn(), calculateCollision() and renderGrid(). The player is
+ *  moved to a different walkable tile before every call, so the timings are
+ *  not of a single spot of the maze that stays in the cache. The grid is
+ *  drawn into an offscreen sf::RenderTexture, so no display is needed beyond
+ *  an OpenGL context, which a software renderer can provide.
+ *  Results are written and read as JSON, one benchmark per line, so a run
+ *  can be compared against a stored baseline.
+ */
+class GameplayBench
+{
+public:
+    // The timing of one function at one maze size
+    struct Result
+    {
+        std::string name;
+        unsigned int size = 0;          // Width and height of the maze.
+        std::uint64_t iterations = 0;   // Calls per sample.
+        double nsPerOp = 0;             // Median over the samples.
+        double minNsPerOp = 0;          // Fastest sample.
+    };
+
+    // Constructor and Destructor
+    GameplayBench(unsigned int size, double sampleSeconds);
+    ~GameplayBench();
+    GameplayBench(const GameplayBench&) = delete;            // copy constructor
+    GameplayBench(GameplayBench&&) = delete;                 // move constructor
+    GameplayBench& operator=(const GameplayBench&) = delete; // copy assignment
+    GameplayBench& operator=(GameplayBench&&) = delete;      // move assignment
+
+    // Public Member Functions for GameplayBench Processes
+    std::vector<Result> run();          // Times every benchmark once.
+    static TileGrid makeMaze(unsigned int size);    // Generates the same random maze of a size on every platform.
+    static void writeJson(std::ostream& out, const std::vector<Result>& results);
+    static std::vector<Result> readJson(const std::string& fileName);   // Reads results written by writeJson().
+
+
+private:
+    // Private Member Functions for GameplayBench Processes
+    template <typename Function>
+    Result measure(const std::string& name, Function function);    // Times a function called with an increasing index.
+    void placePlayer(std::size_t index);    // Moves the player onto one of m_positions.
+
+    // Private Member Constants
+    static constexpr int SAMPLES = 5;           // Timed batches per benchmark.
+    static constexpr int POSITIONS = 1024;      // Walkable tiles the player is moved between.
+    static constexpr unsigned int SEED = 20220;
+
+    // Private Member Variables
+    unsigned int m_size;
+    double m_sampleSeconds;         // Shortest time a batch is calibrated to take.
+    std::string m_mazeFile;         // Temporary file for the maze I/O benchmarks.
+    TileGrid m_maze;
+    std::shared_ptr<Settings> m_settings;
+    std::shared_ptr<JobSystem> m_jobs;
+    std::unique_ptr<Gameplay> m_gameplay;
+    sf::RenderTexture m_target;
+    std::vector<sf::Vector2i> m_positions;
+    sf::Vector2i m_spawn;
+    sf::Vector2i m_spawnUpperLeft;  // Gameplay::upperLeftSquare with the player on m_spawn.
+    std::uint64_t m_sink;           // Keeps results from being optimized away.
+};
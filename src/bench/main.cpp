@@ -0,0 +1,127 @@
+// Included C++11 Libraries
+#include <vector>
+#include <string>
+#include <fstream>
+#include <iostream>
+#include <cstdio>
+
+
+// Included Local Dependencies
+#include "gameplayBench.h"
+
+
+/**
+ * @brief Runs the microbenchmarks and compares them against a baseline.
+ * @details Every benchmark is run on mazes of 64 to 8192 tiles a side, and
+ * the results are written as JSON to standard output or to a file. Given a
+ * baseline written by an earlier run, the change of every benchmark found in
+ * both is printed to standard error, and the exit code is 1 if any got slower
+ * than the tolerance allows. Must be run from a directory next to assets, like
+ * the game, with an OpenGL context available (xvfb-run with Mesa is enough).
+ * Usage:
+ * bench [--sizes 64,256,...] [--out results.json] [--baseline baseline.json]
+ *       [--tolerance 0.1] [--min-time 0.05]
+ * @throw SFML exceptions may be thrown during fatal errors.
+ * @param argc - the number of arguments.
+ * @param argv - the arguments.
+ * @return int - 0 on success, 1 on a regression, 2 on bad arguments
+ */
+int main(int argc, char* argv[])
+{
+    std::vector<unsigned int> sizes = {64, 128, 256, 512, 1024, 2048, 4096, 8192};
+    std::string outFile;
+    std::string baselineFile;
+    double tolerance = 0.1;
+    double sampleSeconds = 0.05;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string argument = argv[i];
+        if (i + 1 == argc)
+        {
+            std::cerr << "bench: missing value for '" << argument << "'\n";
+            return 2;
+        }
+        std::string value = argv[++i];
+        if (argument == "--sizes")
+        {
+            sizes.clear();
+            for (std::size_t start = 0; start < value.size(); )
+            {
+                std::size_t end = std::min(value.find(',', start), value.size());
+                sizes.push_back(std::stoul(value.substr(start, end - start)));
+                start = end + 1;
+            }
+        }
+        else if (argument == "--out")
+        {
+            outFile = value;
+        }
+        else if (argument == "--baseline")
+        {
+            baselineFile = value;
+        }
+        else if (argument == "--tolerance")
+        {
+            tolerance = std::stod(value);
+        }
+        else if (argument == "--min-time")
+        {
+            sampleSeconds = std::stod(value);
+        }
+        else
+        {
+            std::cerr << "bench: unknown argument '" << argument << "'\n";
+            return 2;
+        }
+    }
+
+    std::vector<GameplayBench::Result> results;
+    for (unsigned int size : sizes)
+    {
+        if (size < 3)
+        {
+            std::cerr << "bench: mazes must be at least 3 tiles a side\n";
+            return 2;
+        }
+        std::cerr << "bench: " << size << "x" << size << "\n";
+        GameplayBench bench(size, sampleSeconds);
+        std::vector<GameplayBench::Result> sizeResults = bench.run();
+        results.insert(results.end(), sizeResults.begin(), sizeResults.end());
+    }
+
+    if (outFile.empty())
+    {
+        GameplayBench::writeJson(std::cout, results);
+    }
+    else
+    {
+        std::ofstream file(outFile);
+        GameplayBench::writeJson(file, results);
+    }
+
+    if (baselineFile.empty())
+    {
+        return 0;
+    }
+    bool regressed = false;
+    std::vector<GameplayBench::Result> baseline = GameplayBench::readJson(baselineFile);
+    for (const GameplayBench::Result& result : results)
+    {
+        for (const GameplayBench::Result& previous : baseline)
+        {
+            if (previous.name != result.name || previous.size != result.size || previous.nsPerOp <= 0)
+            {
+                continue;
+            }
+            double change = result.nsPerOp / previous.nsPerOp - 1;
+            bool slower = change > tolerance;
+            regressed = regressed || slower;
+            char line[128];
+            std::snprintf(line, sizeof(line), "%-20s %6u %14.1f ns %14.1f ns %+8.1f%%%s\n", result.name.c_str(),
+                          result.size, previous.nsPerOp, result.nsPerOp, change * 100, slower ? "  SLOWER" : "");
+            std::cerr << line;
+        }
+    }
+    return regressed ? 1 : 0;
+}
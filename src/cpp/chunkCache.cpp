@@ -0,0 +1,227 @@
+#include "chunkCache.h"
+
+
+/**
+ * @brief ChunkCache class constructor
+ * @details The cache is empty until reset() is called with the grid size.
+ * @throw None
+ * @param textures - the tile textures, indexed by tile type. They must outlive
+ * the cache.
+ */
+ChunkCache::ChunkCache(const std::vector<std::unique_ptr<sf::Texture>>& textures) :
+m_textures(textures),
+m_chunksPerSide(0),
+m_chunkMemory(MemoryTag::Textures)
+{
+}
+
+
+/**
+ * @brief Drops every chunk and marks them all for re-rendering.
+ * @details Used when the whole grid changes, for example after loading a file.
+ * @throw std::bad_alloc if the chunk table cannot be allocated.
+ * @param gridSize - the width and height of the grid in tiles.
+ * @return None
+ */
+void ChunkCache::reset(unsigned int gridSize)
+{
+    m_chunksPerSide = (gridSize + CHUNK_TILES - 1) / CHUNK_TILES;
+    m_chunks.clear();
+    m_chunks.resize(static_cast<std::size_t>(m_chunksPerSide) * m_chunksPerSide);
+    m_chunkMemory.set(m_wallChunk ? CHUNK_BYTES : 0);
+    m_dirty.assign(m_chunks.size(), true);
+}
+
+
+/**
+ * @brief Marks the chunk containing a tile for re-rendering.
+ * @throw None
+ * @param x - the x index of the changed tile.
+ * @param y - the y index of the changed tile.
+ * @return None
+ */
+void ChunkCache::markDirty(unsigned int x, unsigned int y)
+{
+    std::size_t index = static_cast<std::size_t>(y / CHUNK_TILES) * m_chunksPerSide + x / CHUNK_TILES;
+    if (index < m_dirty.size())
+    {
+        m_dirty[index] = true;
+    }
+}
+
+
+/**
+ * @brief Marks every chunk overlapping a block of tiles for re-rendering.
+ * @details Used when many tiles change at once, so the chunks are found once
+ * per block instead of once per tile.
+ * @throw None
+ * @param tiles - the changed tiles. Parts outside of the grid are ignored.
+ * @return None
+ */
+void ChunkCache::markDirty(const sf::IntRect& tiles)
+{
+    if (tiles.width <= 0 || tiles.height <= 0 || tiles.left + tiles.width <= 0 || tiles.top + tiles.height <= 0)
+    {
+        return;
+    }
+    int chunksPerSide = m_chunksPerSide;
+    int left = std::max(tiles.left, 0) / static_cast<int>(CHUNK_TILES);
+    int top = std::max(tiles.top, 0) / static_cast<int>(CHUNK_TILES);
+    int right = std::min((tiles.left + tiles.width - 1) / static_cast<int>(CHUNK_TILES), chunksPerSide - 1);
+    int bottom = std::min((tiles.top + tiles.height - 1) / static_cast<int>(CHUNK_TILES), chunksPerSide - 1);
+    for (int chunkY = top; chunkY <= bottom; ++chunkY)
+    {
+        for (int chunkX = left; chunkX <= right; ++chunkX)
+        {
+            m_dirty[static_cast<std::size_t>(chunkY) * m_chunksPerSide + chunkX] = true;
+        }
+    }
+}
+
+/**
+ * @brief Draws the chunks covering the visible tiles.
+ * @details Every chunk overlapping the visible tiles is drawn as a single
+ * sprite, cut down to the part of the chunk that lies inside the grid. Dirty
+ * chunks are re-rendered just before they are drawn, so chunks that are never
+ * looked at are never rendered. Chunks may stick out of the visible area, so
+ * the caller is expected to clip the target with a view.
+ * @throw SFML exceptions may be thrown during fatal errors.
+ * @param target - the target to draw on.
+ * @param grid - the grid the chunks are rendered from.
+ * @param origin - the pixel position of the top left corner of the grid area.
+ * @param firstTile - the tile coordinates shown at origin (may be fractional).
+ * @param visibleTiles - the tiles that need to be covered.
+ * @param squareSize - the width and height of a tile on the screen in pixels.
+ * @return None
+ */
+void ChunkCache::draw(sf::RenderTarget& target, const TileGrid& grid, sf::Vector2f origin, sf::Vector2f firstTile,
+                      const sf::IntRect& visibleTiles, float squareSize)
+{
+    int gridSize = grid.size();
+    int left = std::max(visibleTiles.left, 0);
+    int top = std::max(visibleTiles.top, 0);
+    int right = std::min(visibleTiles.left + visibleTiles.width, gridSize);
+    int bottom = std::min(visibleTiles.top + visibleTiles.height, gridSize);
+    if (left >= right || top >= bottom)
+    {
+        return;
+    }
+
+    float scale = squareSize / TILE_PIXELS;
+    m_sprite.setScale(scale, scale);
+    for (int chunkY = top / CHUNK_TILES; chunkY <= (bottom - 1) / static_cast<int>(CHUNK_TILES); ++chunkY)
+    {
+        for (int chunkX = left / CHUNK_TILES; chunkX <= (right - 1) / static_cast<int>(CHUNK_TILES); ++chunkX)
+        {
+            std::size_t index = static_cast<std::size_t>(chunkY) * m_chunksPerSide + chunkX;
+            if (m_dirty[index])
+            {
+                renderChunk(chunkX, chunkY, grid);
+            }
+
+            int tilesWide = std::min<int>(CHUNK_TILES, gridSize - chunkX * CHUNK_TILES);
+            int tilesHigh = std::min<int>(CHUNK_TILES, gridSize - chunkY * CHUNK_TILES);
+            m_sprite.setTexture(chunkTexture(index));
+            m_sprite.setTextureRect(sf::IntRect(0, 0, tilesWide * TILE_PIXELS, tilesHigh * TILE_PIXELS));
+            m_sprite.setPosition(origin.x + (chunkX * static_cast<float>(CHUNK_TILES) - firstTile.x) * squareSize,
+                                 origin.y + (chunkY * static_cast<float>(CHUNK_TILES) - firstTile.y) * squareSize);
+            FrameStats::draw(target, m_sprite);
+        }
+    }
+}
+
+
+/**
+ * @brief Re-renders a single chunk.
+ * @details The tiles of the chunk are batched into one vertex array per tile
+ * type, so a chunk takes at most one draw call per tile type to render. A
+ * chunk made up entirely of walls frees its texture and uses the shared wall
+ * chunk instead.
+ * @throw SFML exceptions may be thrown during fatal errors.
+ * @param chunkX - the x index of the chunk.
+ * @param chunkY - the y index of the chunk.
+ * @param grid - the grid the chunk is rendered from.
+ * @return None
+ */
+void ChunkCache::renderChunk(unsigned int chunkX, unsigned int chunkY, const TileGrid& grid)
+{
+    MemoryScope memoryScope(MemoryTag::Textures);
+    std::size_t index = static_cast<std::size_t>(chunkY) * m_chunksPerSide + chunkX;
+    m_dirty[index] = false;
+    m_tileQuads.resize(m_textures.size(), sf::VertexArray(sf::Quads));
+    for (std::size_t i = 0; i < m_tileQuads.size(); ++i)
+    {
+        m_tileQuads[i].clear();
+    }
+
+    // chunks cut off by the edge of the grid never use the shared wall chunk
+    unsigned int firstX = chunkX * CHUNK_TILES;
+    unsigned int firstY = chunkY * CHUNK_TILES;
+    bool allWalls = firstX + CHUNK_TILES <= grid.size() && firstY + CHUNK_TILES <= grid.size();
+    for (unsigned int x = firstX; x < std::min(firstX + CHUNK_TILES, grid.size()); ++x)
+    {
+        for (unsigned int y = firstY; y < std::min(firstY + CHUNK_TILES, grid.size()); ++y)
+        {
+            unsigned char type = grid.get(x, y);
+            allWalls = allWalls && type == TileGrid::WALL;
+
+            float left = (x - firstX) * TILE_PIXELS;
+            float top = (y - firstY) * TILE_PIXELS;
+            sf::Vector2f textureSize(m_textures[type]->getSize());
+            sf::VertexArray& quads = m_tileQuads[type];
+            quads.append(sf::Vertex(sf::Vector2f(left, top), sf::Vector2f(0, 0)));
+            quads.append(sf::Vertex(sf::Vector2f(left + TILE_PIXELS, top), sf::Vector2f(textureSize.x, 0)));
+            quads.append(sf::Vertex(sf::Vector2f(left + TILE_PIXELS, top + TILE_PIXELS), textureSize));
+            quads.append(sf::Vertex(sf::Vector2f(left, top + TILE_PIXELS), sf::Vector2f(0, textureSize.y)));
+        }
+    }
+
+    std::unique_ptr<sf::RenderTexture>& chunk = allWalls ? m_wallChunk : m_chunks[index];
+    if (allWalls)
+    {
+        if (m_chunks[index])
+        {
+            m_chunks[index].reset();
+            m_chunkMemory.set(m_chunkMemory.bytes() - CHUNK_BYTES);
+        }
+        if (m_wallChunk)
+        {
+            return; // the shared wall chunk only needs to be rendered once
+        }
+    }
+    if (!chunk)
+    {
+        chunk = std::make_unique<sf::RenderTexture>();
+        chunk->create(CHUNK_TILES * TILE_PIXELS, CHUNK_TILES * TILE_PIXELS);
+        chunk->setSmooth(true);
+        m_chunkMemory.set(m_chunkMemory.bytes() + CHUNK_BYTES);
+    }
+
+    chunk->clear(sf::Color::Black);
+    for (std::size_t i = 0; i < m_tileQuads.size(); ++i)
+    {
+        if (m_tileQuads[i].getVertexCount() != 0)
+        {
+            FrameStats::draw(*chunk, m_tileQuads[i], sf::RenderStates(m_textures[i].get()));
+        }
+    }
+    chunk->display();
+    chunk->generateMipmap();
+}
+
+
+/**
+ * @brief Returns the texture a chunk is drawn with.
+ * @throw None
+ * @param index - the index of the chunk.
+ * @return const sf::Texture& - the chunk's own texture, or the shared wall
+ * chunk texture if the chunk is entirely wall
+ */
+const sf::Texture& ChunkCache::chunkTexture(std::size_t index) const
+{
+    if (m_chunks[index])
+    {
+        return m_chunks[index]->getTexture();
+    }
+    return m_wallChunk->getTexture();
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+
+// Included C++11 Libraries
+#include <vector>
+#include <memory>
+#include <algorithm>
+
+
+// Included Graphics Library Dependencies
+#include <SFML/Graphics.hpp>
+
+
+// Included Local Dependencies
+#include "tileGrid.h"
+#include "frameStats.h"
+#include "memoryTracker.h"
+
+
+/**
+ * Class Name: ChunkCache
+ * Brief: Pre-rendered textures of square blocks of a TileGrid.
+ * Description:
+ *  Splits the grid into CHUNK_TILES x CHUNK_TILES chunks and renders each one
+ *  into its own mipmapped sf::RenderTexture at TILE_PIXELS pixels per tile, so
+ *  it stays smooth when drawn at a fraction of that size. A chunk is
+ *  only re-rendered when a tile inside it has changed, and only when it is
+ *  about to be drawn, so a zoomed out view of the grid costs one draw call per
+ *  chunk instead of one per tile. Chunks that are entirely wall share a single
+ *  texture instead of allocating their own.
+ */
+class ChunkCache
+{
+public:
+    static const unsigned int CHUNK_TILES = 32;     // Width and height of a chunk in tiles.
+    static const unsigned int TILE_PIXELS = 8;      // Width and height of a tile in the chunk textures.
+    static constexpr std::size_t CHUNK_BYTES = CHUNK_TILES * TILE_PIXELS * CHUNK_TILES * TILE_PIXELS * 4 * 4 / 3;    // Video memory of a mipmapped chunk.
+
+    // Constructor
+    ChunkCache(const std::vector<std::unique_ptr<sf::Texture>>& textures);
+
+    // Public Member Functions for ChunkCache Processes
+    void reset(unsigned int gridSize);              // Drops every chunk and marks them all for re-rendering.
+    void markDirty(unsigned int x, unsigned int y); // Marks the chunk containing a tile for re-rendering.
+    void markDirty(const sf::IntRect& tiles);       // Marks every chunk overlapping a block of tiles for re-rendering.
+    void draw(sf::RenderTarget& target, const TileGrid& grid, sf::Vector2f origin, sf::Vector2f firstTile,
+              const sf::IntRect& visibleTiles, float squareSize);   // Draws the chunks covering the visible tiles.
+
+
+private:
+    // Private Member Functions for ChunkCache Processes
+    void renderChunk(unsigned int chunkX, unsigned int chunkY, const TileGrid& grid);   // Re-renders a single chunk.
+    const sf::Texture& chunkTexture(std::size_t index) const;   // Returns the texture a chunk is drawn with.
+
+    // Private Member Variables
+    const std::vector<std::unique_ptr<sf::Texture>>& m_textures;    // Tile textures, indexed by tile type.
+    std::vector<std::unique_ptr<sf::RenderTexture>> m_chunks;       // nullptr for chunks that are entirely wall.
+    std::vector<bool> m_dirty;
+    std::unique_ptr<sf::RenderTexture> m_wallChunk;                 // Shared texture of a chunk that is entirely wall.
+    std::vector<sf::VertexArray> m_tileQuads;                       // Reused quads, one array per tile type.
+    sf::Sprite m_sprite;
+    unsigned int m_chunksPerSide;
+    TrackedBytes m_chunkMemory;     // Video memory of the chunk textures.
+};
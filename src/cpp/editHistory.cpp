@@ -0,0 +1,187 @@
+#include "editHistory.h"
+
+
+/**
+ * @brief EditHistory class constructor
+ * @details Creates an empty history.
+ * @throw None
+ * @param memoryLimit - the number of bytes of history to keep.
+ */
+EditHistory::EditHistory(std::size_t memoryLimit) :
+m_strokeOpen(false),
+m_bytes(0),
+m_memoryLimit(memoryLimit)
+{
+}
+
+
+/**
+ * @brief Adds a tile change to the current stroke.
+ * @details The first change after endStroke() starts a new stroke and
+ * forgets everything that could be redone. A change that continues the last
+ * run (the next index with the same old and new types) only extends it.
+ * @throw std::bad_alloc if the stroke cannot grow.
+ * @param index - the index of the tile in the grid.
+ * @param oldType - the type the tile had before the change.
+ * @param newType - the type the tile has after the change.
+ * @return None
+ */
+void EditHistory::record(std::size_t index, unsigned char oldType, unsigned char newType)
+{
+    MemoryScope memoryScope(MemoryTag::Grid);
+    if (!m_strokeOpen)
+    {
+        for (std::size_t i = 0; i < m_redo.size(); ++i)
+        {
+            m_bytes -= strokeBytes(m_redo[i]);
+        }
+        m_redo.clear();
+        m_undo.emplace_back();
+        m_bytes += sizeof(Stroke);
+        m_strokeOpen = true;
+    }
+
+    Stroke& stroke = m_undo.back();
+    if (!stroke.empty())
+    {
+        Run& last = stroke.back();
+        if (last.oldType == oldType && last.newType == newType &&
+            last.first + last.length == index && last.length < UINT16_MAX)
+        {
+            ++last.length;
+            return;
+        }
+    }
+    stroke.push_back(Run{static_cast<std::uint32_t>(index), 1, oldType, newType});
+    m_bytes += sizeof(Run);
+}
+
+
+/**
+ * @brief Closes the current stroke, so the next change starts a new one.
+ * @details Old strokes are forgotten here if the history has grown past its
+ * memory limit.
+ * @throw None
+ * @param None
+ * @return None
+ */
+void EditHistory::endStroke()
+{
+    if (m_strokeOpen)
+    {
+        m_undo.back().shrink_to_fit();
+        m_strokeOpen = false;
+        trim();
+    }
+}
+
+
+/**
+ * @brief Reverts the latest stroke.
+ * @details The runs are applied in reverse, so a tile changed twice in one
+ * stroke ends up with the type it had before the stroke.
+ * @throw None
+ * @param apply - called with the index and the old type of every changed tile.
+ * @return bool - true if a stroke was reverted, false if there was none
+ */
+bool EditHistory::undo(const std::function<void(std::size_t, unsigned char)>& apply)
+{
+    endStroke();
+    if (m_undo.empty())
+    {
+        return false;
+    }
+
+    const Stroke& stroke = m_undo.back();
+    for (auto run = stroke.rbegin(); run != stroke.rend(); ++run)
+    {
+        for (std::size_t i = run->length; i > 0; --i)
+        {
+            apply(run->first + i - 1, run->oldType);
+        }
+    }
+    m_redo.push_back(std::move(m_undo.back()));
+    m_undo.pop_back();
+    return true;
+}
+
+
+/**
+ * @brief Reapplies the latest undone stroke.
+ * @throw None
+ * @param apply - called with the index and the new type of every changed tile.
+ * @return bool - true if a stroke was reapplied, false if there was none
+ */
+bool EditHistory::redo(const std::function<void(std::size_t, unsigned char)>& apply)
+{
+    endStroke();
+    if (m_redo.empty())
+    {
+        return false;
+    }
+
+    const Stroke& stroke = m_redo.back();
+    for (const Run& run : stroke)
+    {
+        for (std::size_t i = 0; i < run.length; ++i)
+        {
+            apply(run.first + i, run.newType);
+        }
+    }
+    m_undo.push_back(std::move(m_redo.back()));
+    m_redo.pop_back();
+    return true;
+}
+
+
+/**
+ * @brief Forgets every stroke.
+ * @details Used when the whole grid is replaced, for example after loading a file.
+ * @throw None
+ * @param None
+ * @return None
+ */
+void EditHistory::clear()
+{
+    m_undo.clear();
+    m_redo.clear();
+    m_strokeOpen = false;
+    m_bytes = 0;
+}
+
+
+/**
+ * @brief Changes the memory limit, forgetting old strokes if needed.
+ * @throw None
+ * @param memoryLimit - the number of bytes of history to keep.
+ * @return None
+ */
+void EditHistory::setMemoryLimit(std::size_t memoryLimit)
+{
+    m_memoryLimit = memoryLimit;
+    trim();
+}
+
+
+/**
+ * @brief Forgets the oldest strokes until the history fits its memory limit.
+ * @details Strokes that could be redone go first, starting with the one
+ * furthest from the present. The latest stroke is always kept so that a
+ * single huge stroke can still be undone.
+ * @throw None
+ * @param None
+ * @return None
+ */
+void EditHistory::trim()
+{
+    while (m_bytes > m_memoryLimit && !m_redo.empty())
+    {
+        m_bytes -= strokeBytes(m_redo.front());
+        m_redo.pop_front();
+    }
+    while (m_bytes > m_memoryLimit && m_undo.size() > 1)
+    {
+        m_bytes -= strokeBytes(m_undo.front());
+        m_undo.pop_front();
+    }
+}
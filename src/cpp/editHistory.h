@@ -0,0 +1,66 @@
+#pragma once
+
+
+// Included C++11 Libraries
+#include <vector>
+#include <deque>
+#include <cstdint>
+#include <functional>
+
+
+// Included Local Dependencies
+#include "memoryTracker.h"
+
+
+/**
+ * Class Name: EditHistory
+ * Brief: Undo and redo history of the tiles changed in the maze builder.
+ * Description:
+ *  Every brush stroke is stored as a list of runs of consecutive tile
+ *  indices that went from the same old type to the same new type. Dragging
+ *  a brush along a column of the grid therefore becomes a single run, and
+ *  undoing or redoing a stroke only touches the tiles it changed. When the
+ *  history grows past its memory limit the oldest strokes are forgotten.
+ */
+class EditHistory
+{
+public:
+    static const std::size_t DEFAULT_MEMORY_LIMIT = 16 * 1024 * 1024;  // Bytes of history kept by default.
+
+    // Constructor
+    EditHistory(std::size_t memoryLimit = DEFAULT_MEMORY_LIMIT);
+
+    // Public Member Functions for EditHistory Processes
+    void record(std::size_t index, unsigned char oldType, unsigned char newType);  // Adds a tile change to the current stroke.
+    void endStroke();       // Closes the current stroke, so the next change starts a new one.
+    bool undo(const std::function<void(std::size_t, unsigned char)>& apply);   // Reverts the latest stroke.
+    bool redo(const std::function<void(std::size_t, unsigned char)>& apply);   // Reapplies the latest undone stroke.
+    void clear();           // Forgets every stroke.
+    void setMemoryLimit(std::size_t memoryLimit);   // Changes the memory limit, forgetting old strokes if needed.
+    bool canUndo() const {return !m_undo.empty();}
+    bool canRedo() const {return !m_redo.empty();}
+    std::size_t memoryUsage() const {return m_bytes;}
+
+
+private:
+    // A run of consecutive tile indices that all changed from oldType to newType
+    struct Run
+    {
+        std::uint32_t first;
+        std::uint16_t length;
+        unsigned char oldType;
+        unsigned char newType;
+    };
+    typedef std::vector<Run> Stroke;
+
+    // Private Member Functions for EditHistory Processes
+    void trim();            // Forgets the oldest strokes until the history fits its memory limit.
+    static std::size_t strokeBytes(const Stroke& stroke) {return sizeof(Stroke) + stroke.size() * sizeof(Run);}
+
+    // Private Member Variables
+    std::deque<Stroke> m_undo;  // Oldest stroke at the front.
+    std::deque<Stroke> m_redo;  // Most recently undone stroke at the back.
+    bool m_strokeOpen;          // Whether the back of m_undo is still being recorded.
+    std::size_t m_bytes;
+    std::size_t m_memoryLimit;
+};
@@ -0,0 +1,337 @@
+#include "editJournal.h"
+
+
+namespace
+{
+    const char SNAPSHOT_MAGIC[4] = {'S', 'N', 'P', '1'};
+    const char JOURNAL_MAGIC[4] = {'J', 'R', 'N', '1'};
+    const std::size_t RECORD_BYTES = sizeof(std::uint32_t) + 1;
+    const std::size_t SNAPSHOT_HEADER_BYTES = sizeof(SNAPSHOT_MAGIC) + 3 * sizeof(std::uint32_t);
+    const std::uint32_t MAX_PATH_LENGTH = 4096;
+}
+
+
+constexpr std::chrono::milliseconds EditJournal::FLUSH_INTERVAL;
+
+
+/**
+ * @brief EditJournal class constructor
+ * @details Checks for an autosave left behind by an earlier session and
+ * starts the background thread. Nothing is journaled until start() is called.
+ * @throw std::system_error if the background thread cannot be started.
+ * @param snapshotFileName - the file the grid snapshot is written to.
+ * @param journalFileName - the file changes since the snapshot are appended to.
+ */
+EditJournal::EditJournal(const std::string& snapshotFileName, const std::string& journalFileName) :
+m_snapshotFileName(snapshotFileName),
+m_journalFileName(journalFileName),
+m_started(false),
+m_hasRecovery(false),
+m_recordsSinceSnapshot(0),
+m_generation(0),
+m_snapshotSize(0),
+m_snapshotGeneration(0),
+m_snapshotPending(false),
+m_discardPending(false),
+m_stopping(false)
+{
+    std::fstream file(m_snapshotFileName, std::ios::in | std::ios::binary);
+    char magic[4];
+    file.read(magic, sizeof(magic));
+    file.read(reinterpret_cast<char*>(&m_generation), sizeof(m_generation));
+    m_hasRecovery = file && std::equal(magic, magic + 4, SNAPSHOT_MAGIC);
+    if (!m_hasRecovery)
+    {
+        m_generation = 0;
+    }
+
+    m_thread = std::thread(&EditJournal::run, this);
+}
+
+
+/**
+ * @brief Destructor for the EditJournal class.
+ * @details Waits for the background thread to write everything still queued.
+ * The autosave is kept, so unsaved work can be recovered next time.
+ * @throw None
+ */
+EditJournal::~EditJournal()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_wake.notify_one();
+    m_thread.join();
+}
+
+
+/**
+ * @brief Rebuilds the autosaved grid from the snapshot and journal.
+ * @details The autosave may have been damaged by the crash it is meant to
+ * recover from, so the snapshot is only read if its header adds up to the
+ * length of the file, and tiles of an unknown type become walls, as in
+ * TileGrid::loadFromFile(). The journal is only replayed if it belongs to
+ * the snapshot. A record cut short by a crash at the end of the journal is
+ * ignored.
+ * @throw std::bad_alloc if the grid cannot be allocated.
+ * @param grid - receives the recovered grid.
+ * @param levelFileName - receives the .maze file the autosave was editing.
+ * @return bool - true if the autosave could be read, false if not
+ */
+bool EditJournal::recover(TileGrid& grid, std::string& levelFileName)
+{
+    PROFILE_ZONE("EditJournal::recover");
+    std::fstream snapshot(m_snapshotFileName, std::ios::in | std::ios::binary);
+    char magic[4];
+    std::uint32_t generation = 0, size = 0, pathLength = 0;
+    snapshot.read(magic, sizeof(magic));
+    snapshot.read(reinterpret_cast<char*>(&generation), sizeof(generation));
+    snapshot.read(reinterpret_cast<char*>(&size), sizeof(size));
+    snapshot.read(reinterpret_cast<char*>(&pathLength), sizeof(pathLength));
+    std::error_code error;
+    std::uintmax_t fileSize = std::filesystem::file_size(m_snapshotFileName, error);
+    std::size_t tileCount = static_cast<std::size_t>(size) * size;
+    if (!snapshot || !std::equal(magic, magic + 4, SNAPSHOT_MAGIC) || error || pathLength > MAX_PATH_LENGTH ||
+        fileSize != SNAPSHOT_HEADER_BYTES + pathLength + tileCount)
+    {
+        return false;
+    }
+
+    std::string level(pathLength, '\0');
+    snapshot.read(&level[0], pathLength);
+    std::vector<unsigned char> tiles(tileCount);
+    snapshot.read(reinterpret_cast<char*>(tiles.data()), tiles.size());
+    if (!snapshot)
+    {
+        return false;
+    }
+    for (unsigned char& type : tiles)
+    {
+        type = type < TileGrid::TYPE_COUNT ? type : TileGrid::WALL;
+    }
+
+    std::fstream journal(m_journalFileName, std::ios::in | std::ios::binary);
+    std::uint32_t journalGeneration = 0;
+    journal.read(magic, sizeof(magic));
+    journal.read(reinterpret_cast<char*>(&journalGeneration), sizeof(journalGeneration));
+    if (journal && std::equal(magic, magic + 4, JOURNAL_MAGIC) && journalGeneration == generation)
+    {
+        char record[RECORD_BYTES];
+        while (journal.read(record, RECORD_BYTES))
+        {
+            std::uint32_t index;
+            std::copy(record, record + sizeof(index), reinterpret_cast<char*>(&index));
+            if (index < tiles.size() && static_cast<unsigned char>(record[sizeof(index)]) < TileGrid::TYPE_COUNT)
+            {
+                tiles[index] = record[sizeof(index)];
+            }
+        }
+    }
+
+    grid.assign(size, tiles.data());
+    levelFileName = level;
+    return true;
+}
+
+
+/**
+ * @brief Writes a new snapshot that later changes are journaled against.
+ * @details Used both to begin journaling and to compact a long journal. The
+ * background thread writes the tiles from a TileGrid::snapshot(), so they
+ * are not copied here and the lock is only held to hand the snapshot over.
+ * Anything still queued is dropped, since the snapshot already contains it.
+ * @throw None
+ * @param grid - the current grid.
+ * @param levelFileName - the .maze file being edited, empty if there is none.
+ * @return None
+ */
+void EditJournal::start(const TileGrid& grid, const std::string& levelFileName)
+{
+    TileGrid::Snapshot tiles = grid.snapshot();
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_snapshot.swap(tiles);
+        m_snapshotSize = grid.size();
+        m_snapshotLevel = levelFileName;
+        m_snapshotGeneration = ++m_generation;
+        m_snapshotPending = true;
+        m_pending.clear();
+    }
+    tiles.reset(); // an older snapshot that was never written, let go of outside the lock
+    m_wake.notify_one();
+    m_started = true;
+    m_hasRecovery = false;
+    m_recordsSinceSnapshot = 0;
+}
+
+
+/**
+ * @brief Queues a changed tile to be appended to the journal.
+ * @details Only takes the lock long enough to add the record to the batch.
+ * @throw std::bad_alloc if the batch cannot grow.
+ * @param index - the index of the tile in the grid.
+ * @param type - the new type of the tile.
+ * @return None
+ */
+void EditJournal::record(std::size_t index, unsigned char type)
+{
+    if (!m_started)
+    {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_pending.push_back(Record{static_cast<std::uint32_t>(index), type});
+    ++m_recordsSinceSnapshot;
+}
+
+
+/**
+ * @brief Queues consecutive tiles changed to the same type.
+ * @details Used by the fill tools, so a long run of tiles takes the lock
+ * once instead of once per tile.
+ * @throw std::bad_alloc if the batch cannot grow.
+ * @param first - the index of the first tile in the grid.
+ * @param length - the number of tiles.
+ * @param type - the new type of the tiles.
+ * @return None
+ */
+void EditJournal::recordRun(std::size_t first, std::size_t length, unsigned char type)
+{
+    if (!m_started)
+    {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (std::size_t i = 0; i < length; ++i)
+    {
+        m_pending.push_back(Record{static_cast<std::uint32_t>(first + i), type});
+    }
+    m_recordsSinceSnapshot += length;
+}
+
+
+/**
+ * @brief Deletes the autosave and stops journaling until start() is called.
+ * @details Used once the maze has been saved or loaded, when there is
+ * nothing left to recover. A snapshot that was not written yet is let go of
+ * after the lock is released, so the grid stops sharing its tiles with it.
+ * @throw None
+ * @param None
+ * @return None
+ */
+void EditJournal::discard()
+{
+    TileGrid::Snapshot tiles;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_pending.clear();
+        m_snapshot.swap(tiles);
+        m_snapshotPending = false;
+        m_discardPending = true;
+    }
+    m_wake.notify_one();
+    m_started = false;
+    m_hasRecovery = false;
+    m_recordsSinceSnapshot = 0;
+}
+
+
+/**
+ * @brief Body of the background thread.
+ * @details Wakes up every FLUSH_INTERVAL to append the queued changes, or
+ * straight away for a snapshot, a discard or shutting down.
+ * @throw None
+ * @param None
+ * @return None
+ */
+void EditJournal::run()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (!m_stopping)
+    {
+        m_wake.wait_for(lock, FLUSH_INTERVAL, [this]
+        {
+            return m_stopping || m_snapshotPending || m_discardPending;
+        });
+        write(lock);
+    }
+}
+
+
+/**
+ * @brief Writes everything queued so far, unlocking during the I/O.
+ * @details A discard is handled before a snapshot, and a snapshot before the
+ * changes queued after it, which is the order they were requested in.
+ * @throw None
+ * @param lock - the held lock on m_mutex.
+ * @return None
+ */
+void EditJournal::write(std::unique_lock<std::mutex>& lock)
+{
+    PROFILE_ZONE("EditJournal::write");
+    bool discard = m_discardPending;
+    bool snapshot = m_snapshotPending;
+    m_discardPending = m_snapshotPending = false;
+    if (snapshot)
+    {
+        m_writingSnapshot = std::move(m_snapshot);
+    }
+    m_writing.swap(m_pending);
+    std::string level = m_snapshotLevel;
+    unsigned int size = m_snapshotSize;
+    std::uint32_t generation = m_snapshotGeneration;
+    lock.unlock();
+
+    if (discard)
+    {
+        m_journal.close();
+        std::remove(m_snapshotFileName.c_str());
+        std::remove(m_journalFileName.c_str());
+    }
+    if (snapshot)
+    {
+        std::string tempFileName = m_snapshotFileName + ".tmp";
+        std::fstream file(tempFileName, std::ios::out | std::ios::binary | std::ios::trunc);
+        std::uint32_t gridSize = size;
+        std::uint32_t pathLength = level.size();
+        file.write(SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC));
+        file.write(reinterpret_cast<const char*>(&generation), sizeof(generation));
+        file.write(reinterpret_cast<const char*>(&gridSize), sizeof(gridSize));
+        file.write(reinterpret_cast<const char*>(&pathLength), sizeof(pathLength));
+        file.write(level.data(), pathLength);
+        file.write(reinterpret_cast<const char*>(m_writingSnapshot->data()), m_writingSnapshot->size());
+        file.close();
+        m_writingSnapshot.reset(); // lets the grid change its tiles in place again
+
+        m_journal.close();
+        std::error_code error;
+        if (file)
+        {
+            std::filesystem::rename(tempFileName, m_snapshotFileName, error); // replaces the old snapshot, on Windows too
+        }
+        if (file && !error)
+        {
+            m_journal.open(m_journalFileName, std::ios::out | std::ios::binary | std::ios::trunc);
+            m_journal.write(JOURNAL_MAGIC, sizeof(JOURNAL_MAGIC));
+            m_journal.write(reinterpret_cast<const char*>(&generation), sizeof(generation));
+        }
+        else
+        {
+            std::remove(tempFileName.c_str());
+        }
+    }
+
+    if (m_journal.is_open() && !m_writing.empty())
+    {
+        for (const Record& record : m_writing)
+        {
+            m_journal.write(reinterpret_cast<const char*>(&record.index), sizeof(record.index));
+            m_journal.write(reinterpret_cast<const char*>(&record.type), 1);
+        }
+        m_journal.flush();
+    }
+    m_writing.clear();
+
+    lock.lock();
+}
@@ -0,0 +1,98 @@
+#pragma once
+
+
+// Included C++11 Libraries
+#include <vector>
+#include <string>
+#include <fstream>
+#include <filesystem>
+#include <cstdint>
+#include <cstdio>
+#include <algorithm>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+
+
+// Included Local Dependencies
+#include "tileGrid.h"
+#include "profiler.h"
+
+
+/**
+ * Class Name: EditJournal
+ * Brief: Crash-safe autosave of the maze being edited.
+ * Description:
+ *  Keeps a snapshot of the grid on disk plus an append-only journal of every
+ *  tile changed since the snapshot. Painting only pushes the change onto an
+ *  in-memory batch; a background thread appends the batches to the journal
+ *  a few times a second, so the editor never waits for the disk. Once the
+ *  journal grows long enough it is compacted into a fresh snapshot. Both
+ *  files carry a generation number, so a crash half way through compaction
+ *  never replays an old journal over a newer snapshot.
+ */
+class EditJournal
+{
+public:
+    // Constructor and Destructor
+    EditJournal(const std::string& snapshotFileName, const std::string& journalFileName);
+    ~EditJournal();
+    EditJournal(const EditJournal&) = delete;            // copy constructor
+    EditJournal(EditJournal&&) = delete;                 // move constructor
+    EditJournal& operator=(const EditJournal&) = delete; // copy assignment
+    EditJournal& operator=(EditJournal&&) = delete;      // move assignment
+
+    // Public Member Functions for EditJournal Processes
+    bool hasRecovery() const {return m_hasRecovery;}
+    bool recover(TileGrid& grid, std::string& levelFileName);   // Rebuilds the autosaved grid from the snapshot and journal.
+    void start(const TileGrid& grid, const std::string& levelFileName);     // Writes a new snapshot that later changes are journaled against.
+    void record(std::size_t index, unsigned char type);     // Queues a changed tile to be appended to the journal.
+    void recordRun(std::size_t first, std::size_t length, unsigned char type);  // Queues consecutive tiles changed to the same type.
+    void discard();         // Deletes the autosave and stops journaling until start() is called.
+    bool isStarted() const {return m_started;}
+    bool needsCompaction() const {return m_recordsSinceSnapshot >= COMPACT_RECORDS;}
+
+
+private:
+    static const std::size_t COMPACT_RECORDS = 1 << 18;     // Journal length that triggers a new snapshot.
+    static constexpr std::chrono::milliseconds FLUSH_INTERVAL{500};    // How often queued changes are written.
+
+    // A changed tile as it is written to the journal
+    struct Record
+    {
+        std::uint32_t index;
+        unsigned char type;
+    };
+
+    // Private Member Functions for EditJournal Processes
+    void run();             // Body of the background thread.
+    void write(std::unique_lock<std::mutex>& lock);     // Writes everything queued so far, unlocking during the I/O.
+    void writeSnapshot();   // Writes m_writingSnapshot and starts a new journal (background thread only).
+
+    // Private Member Variables
+    std::string m_snapshotFileName;
+    std::string m_journalFileName;
+    bool m_started;
+    bool m_hasRecovery;
+    std::size_t m_recordsSinceSnapshot;
+    std::uint32_t m_generation;
+
+    // Shared with the background thread, guarded by m_mutex
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::vector<Record> m_pending;
+    TileGrid::Snapshot m_snapshot;      // Tiles shared with the grid, not copied.
+    std::string m_snapshotLevel;
+    unsigned int m_snapshotSize;
+    std::uint32_t m_snapshotGeneration;
+    bool m_snapshotPending;
+    bool m_discardPending;
+    bool m_stopping;
+
+    // Only used by the background thread
+    std::vector<Record> m_writing;
+    TileGrid::Snapshot m_writingSnapshot;
+    std::fstream m_journal;
+    std::thread m_thread;
+};
@@ -0,0 +1,42 @@
+#include "eventScript.h"
+
+
+/**
+ * @brief EventScript class constructor
+ * @details Starts with no events and the mouse in the top left corner.
+ * @throw None
+ */
+EventScript::EventScript() :
+m_mousePosition(0, 0)
+{
+}
+
+
+/**
+ * @brief Queues an event for the next poll.
+ * @throw std::bad_alloc if the event cannot be queued.
+ * @param event - the event to queue.
+ * @return None
+ */
+void EventScript::push(const sf::Event& event)
+{
+    m_events.push_back(event);
+}
+
+
+/**
+ * @brief Takes the oldest queued event, like sf::Window::pollEvent().
+ * @throw None
+ * @param event - receives the event.
+ * @return bool - true if there was an event, false if the queue is empty
+ */
+bool EventScript::poll(sf::Event& event)
+{
+    if (m_events.empty())
+    {
+        return false;
+    }
+    event = m_events.front();
+    m_events.pop_front();
+    return true;
+}
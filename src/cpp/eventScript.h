@@ -0,0 +1,38 @@
+#pragma once
+
+
+// Included C++11 Libraries
+#include <deque>
+
+
+// Included Graphics Library Dependencies
+#include <SFML/Graphics.hpp>
+
+
+/**
+ * Class Name: EventScript
+ * Brief: Synthetic input that replaces the window's events and mouse.
+ * Description:
+ *  Holds the events a Section polls and the mouse position it reads while
+ *  the game is driven by a script instead of a user, as in a soak test. The
+ *  script pushes the events of a frame before the frame's input is handled,
+ *  and every Section given the script reads from it instead of the window.
+ */
+class EventScript
+{
+public:
+    // Constructor
+    EventScript();
+
+    // Public Member Functions for EventScript Processes
+    void push(const sf::Event& event);  // Queues an event for the next poll.
+    bool poll(sf::Event& event);        // Takes the oldest queued event, like sf::Window::pollEvent().
+    void setMousePosition(sf::Vector2i position) {m_mousePosition = position;}
+    sf::Vector2i mousePosition() const {return m_mousePosition;}
+
+
+private:
+    // Private Member Variables
+    std::deque<sf::Event> m_events;
+    sf::Vector2i m_mousePosition;   // In window pixels, like sf::Mouse::getPosition(window).
+};
@@ -0,0 +1,287 @@
+#include "explorationMap.h"
+
+
+namespace
+{
+    const char FOG_MAGIC[4] = {'F', 'O', 'G', '1'};
+}
+
+
+/**
+ * @brief ExplorationMap class constructor
+ * @details Creates an empty map. open() must be called before it is used.
+ * @throw None
+ */
+ExplorationMap::ExplorationMap() :
+m_gridSize(0),
+m_chunksPerSide(0)
+{
+}
+
+
+/**
+ * @brief Destructor for the ExplorationMap class.
+ * @details The save file is closed automatically. Saving is left to the owner
+ * so that it happens at a well defined time.
+ * @throw None
+ */
+ExplorationMap::~ExplorationMap()
+{
+}
+
+
+/**
+ * @brief Prepares the map of a level, reading the chunk table of an existing save.
+ * @details The save file starts with a header (magic, grid size and the path of
+ * the level it belongs to) followed by one 32 bit offset per chunk. Only the
+ * header and the table are read here; chunk data is read by chunkAt() the
+ * first time it is needed. If the save belongs to a different level or grid
+ * size it is ignored and the level starts unexplored.
+ * @throw std::bad_alloc if the chunk tables cannot be allocated.
+ * @param saveFileName - the file the map is read from and saved to.
+ * @param levelFileName - the .maze file the map belongs to.
+ * @param gridSize - the width and height of the level in tiles.
+ * @return None
+ */
+void ExplorationMap::open(const std::string& saveFileName, const std::string& levelFileName, unsigned int gridSize)
+{
+    PROFILE_ZONE("ExplorationMap::open");
+    MemoryScope memoryScope(MemoryTag::Grid);
+    m_saveFileName = saveFileName;
+    m_levelFileName = levelFileName;
+    m_gridSize = gridSize;
+    m_chunksPerSide = (gridSize + CHUNK_SIZE - 1) / CHUNK_SIZE;
+
+    std::size_t chunkCount = static_cast<std::size_t>(m_chunksPerSide) * m_chunksPerSide;
+    m_chunks.clear();
+    m_chunks.resize(chunkCount);
+    m_fileOffsets.assign(chunkCount, 0);
+
+    if (m_file.is_open())
+    {
+        m_file.close();
+    }
+    m_file.open(m_saveFileName, std::ios::in | std::ios::binary);
+    if (!m_file)
+    {
+        return;
+    }
+
+    char magic[4];
+    std::uint32_t savedGridSize = 0;
+    std::uint32_t pathLength = 0;
+    m_file.read(magic, sizeof(magic));
+    m_file.read(reinterpret_cast<char*>(&savedGridSize), sizeof(savedGridSize));
+    m_file.read(reinterpret_cast<char*>(&pathLength), sizeof(pathLength));
+    std::string savedLevel;
+    if (m_file && pathLength == levelFileName.size()) // any other length belongs to another level, or is damaged
+    {
+        savedLevel.resize(pathLength);
+        m_file.read(&savedLevel[0], pathLength);
+    }
+
+    if (!m_file || !std::equal(magic, magic + 4, FOG_MAGIC) ||
+        savedGridSize != gridSize || savedLevel != levelFileName)
+    {
+        m_file.close();
+        return;
+    }
+
+    m_file.read(reinterpret_cast<char*>(m_fileOffsets.data()), chunkCount * sizeof(std::uint32_t));
+    if (!m_file)
+    {
+        m_fileOffsets.assign(chunkCount, 0);
+        m_file.close();
+    }
+}
+
+
+/**
+ * @brief Writes every explored chunk to the save file.
+ * @details Chunks that were never loaded are read from the old save first, so
+ * nothing is lost. The new file is written next to the old one and renamed
+ * over it, so a failed save never corrupts the previous one, and the chunk
+ * table is only replaced once the rename succeeded. Chunks that were never
+ * explored are not written at all.
+ * @throw None
+ * @param None
+ * @return None
+ */
+void ExplorationMap::save()
+{
+    PROFILE_ZONE("ExplorationMap::save");
+    if (m_saveFileName.empty())
+    {
+        return;
+    }
+
+    std::vector<std::uint32_t> offsets(m_chunks.size(), 0);
+    std::uint32_t offset = sizeof(FOG_MAGIC) + 2 * sizeof(std::uint32_t) + m_levelFileName.size()
+                           + offsets.size() * sizeof(std::uint32_t);
+    for (unsigned int chunkY = 0; chunkY < m_chunksPerSide; ++chunkY)
+    {
+        for (unsigned int chunkX = 0; chunkX < m_chunksPerSide; ++chunkX)
+        {
+            if (chunkAt(chunkX, chunkY, false))
+            {
+                offsets[chunkY * m_chunksPerSide + chunkX] = offset;
+                offset += sizeof(Chunk);
+            }
+        }
+    }
+    m_file.close();
+
+    std::string tempFileName = m_saveFileName + ".tmp";
+    std::fstream file(tempFileName, std::ios::out | std::ios::binary | std::ios::trunc);
+    std::uint32_t gridSize = m_gridSize;
+    std::uint32_t pathLength = m_levelFileName.size();
+    file.write(FOG_MAGIC, sizeof(FOG_MAGIC));
+    file.write(reinterpret_cast<const char*>(&gridSize), sizeof(gridSize));
+    file.write(reinterpret_cast<const char*>(&pathLength), sizeof(pathLength));
+    file.write(m_levelFileName.data(), pathLength);
+    file.write(reinterpret_cast<const char*>(offsets.data()), offsets.size() * sizeof(std::uint32_t));
+    for (std::size_t i = 0; i < m_chunks.size(); ++i)
+    {
+        if (m_chunks[i])
+        {
+            file.write(reinterpret_cast<const char*>(m_chunks[i]->rows), sizeof(Chunk));
+        }
+    }
+    file.close();
+
+    std::error_code error;
+    if (file)
+    {
+        std::filesystem::rename(tempFileName, m_saveFileName, error); // replaces the old save, on Windows too
+    }
+    if (file && !error)
+    {
+        m_fileOffsets = offsets;
+    }
+    else
+    {
+        std::filesystem::remove(tempFileName, error);
+    }
+}
+
+
+/**
+ * @brief Returns whether a tile has been seen, loading its chunk if needed.
+ * @throw None
+ * @param x - the x index of the tile.
+ * @param y - the y index of the tile.
+ * @return bool - true if the tile has been explored, false if not
+ */
+bool ExplorationMap::isExplored(int x, int y)
+{
+    if (x < 0 || y < 0 || x >= static_cast<int>(m_gridSize) || y >= static_cast<int>(m_gridSize))
+    {
+        return false;
+    }
+    const Chunk* chunk = chunkAt(x / CHUNK_SIZE, y / CHUNK_SIZE, false);
+    return chunk && ((chunk->rows[y % CHUNK_SIZE] >> (x % CHUNK_SIZE)) & 1);
+}
+
+
+/**
+ * @brief Returns the explored bits of one row of a chunk.
+ * @details Bit 0 is the tile at chunkX * CHUNK_SIZE. Chunks that were never
+ * explored are not allocated.
+ * @throw None
+ * @param chunkX - the x index of the chunk.
+ * @param y - the y index of the maze row.
+ * @return std::uint64_t - the explored bits of the chunk row
+ */
+std::uint64_t ExplorationMap::exploredBits(unsigned int chunkX, unsigned int y)
+{
+    if (chunkX >= m_chunksPerSide || y >= m_gridSize)
+    {
+        return 0;
+    }
+    const Chunk* chunk = chunkAt(chunkX, y / CHUNK_SIZE, false);
+    return chunk ? chunk->rows[y % CHUNK_SIZE] : 0;
+}
+
+
+/**
+ * @brief Marks every currently visible tile as explored.
+ * @details Each row of the visibility window is a single word, which is
+ * shifted into the (at most two) chunk words it overlaps. Bits that fall
+ * outside of the maze are masked off first.
+ * @throw std::bad_alloc if a new chunk cannot be allocated.
+ * @param visibility - the result of the latest visibility computation.
+ * @return bool - true if any tile was explored for the first time
+ */
+bool ExplorationMap::markVisible(const Visibility& visibility)
+{
+    bool changed = false;
+    for (int y = visibility.originY() - visibility.radius(); y <= visibility.originY() + visibility.radius(); ++y)
+    {
+        std::uint64_t bits = visibility.visibleRow(y);
+        if (bits == 0 || y < 0 || y >= static_cast<int>(m_gridSize))
+        {
+            continue;
+        }
+
+        // clip the row to the maze, so that the first bit lands on a valid tile
+        int x = visibility.originX() - Visibility::MAX_RADIUS;
+        if (x < 0)
+        {
+            bits >>= -x;
+            x = 0;
+        }
+        int tilesLeft = static_cast<int>(m_gridSize) - x;
+        if (tilesLeft <= 0)
+        {
+            continue;
+        }
+        if (tilesLeft < 64)
+        {
+            bits &= (std::uint64_t(1) << tilesLeft) - 1;
+        }
+
+        while (bits)
+        {
+            int shift = x % CHUNK_SIZE;
+            std::uint64_t& word = chunkAt(x / CHUNK_SIZE, y / CHUNK_SIZE, true)->rows[y % CHUNK_SIZE];
+            std::uint64_t added = (bits << shift) & ~word;
+            word |= added;
+            changed = changed || added;
+
+            // the bits that did not fit continue in the next chunk
+            bits = (shift == 0) ? 0 : bits >> (CHUNK_SIZE - shift);
+            x += CHUNK_SIZE - shift;
+        }
+    }
+    return changed;
+}
+
+
+/**
+ * @brief Returns a chunk, loading or allocating it when necessary.
+ * @details Chunks that were saved are read from the save file on first use.
+ * Chunks that were never explored are only allocated if create is true.
+ * @throw std::bad_alloc if a chunk cannot be allocated.
+ * @param chunkX - the x index of the chunk.
+ * @param chunkY - the y index of the chunk.
+ * @param create - whether to allocate an empty chunk if none exists.
+ * @return Chunk* - the chunk, or nullptr if it does not exist
+ */
+ExplorationMap::Chunk* ExplorationMap::chunkAt(unsigned int chunkX, unsigned int chunkY, bool create)
+{
+    MemoryScope memoryScope(MemoryTag::Grid);
+    std::size_t index = static_cast<std::size_t>(chunkY) * m_chunksPerSide + chunkX;
+    std::unique_ptr<Chunk>& chunk = m_chunks[index];
+    if (!chunk && m_fileOffsets[index] != 0 && m_file.is_open())
+    {
+        chunk = std::make_unique<Chunk>();
+        m_file.clear();
+        m_file.seekg(m_fileOffsets[index]);
+        m_file.read(reinterpret_cast<char*>(chunk->rows), sizeof(Chunk));
+    }
+    if (!chunk && create)
+    {
+        chunk = std::make_unique<Chunk>();
+    }
+    return chunk.get();
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+
+// Included C++11 Libraries
+#include <vector>
+#include <string>
+#include <fstream>
+#include <filesystem>
+#include <memory>
+#include <cstdint>
+#include <cstdio>
+#include <algorithm>
+
+
+// Included Local Dependencies
+#include "visibility.h"
+#include "profiler.h"
+#include "memoryTracker.h"
+
+
+/**
+ * Class Name: ExplorationMap
+ * Brief: Remembers which tiles of a level the player has seen.
+ * Description:
+ *  Stores one bit per tile, split into CHUNK_SIZE x CHUNK_SIZE chunks that are
+ *  only allocated once something inside them has been explored. Each row of a
+ *  chunk is a single 64 bit word, so a row of the Visibility window can be
+ *  merged with at most two OR operations. The map is saved to a file next to
+ *  the save slot, and chunks are only read back from it when first accessed.
+ */
+class ExplorationMap
+{
+public:
+    static const int CHUNK_SIZE = 64;   // Width and height of a chunk in tiles (one 64 bit word per row).
+
+    // Constructor and Destructor
+    ExplorationMap();
+    ~ExplorationMap();
+    ExplorationMap(const ExplorationMap&) = delete;            // copy constructor
+    ExplorationMap(ExplorationMap&&) = delete;                 // move constructor
+    ExplorationMap& operator=(const ExplorationMap&) = delete; // copy assignment
+    ExplorationMap& operator=(ExplorationMap&&) = delete;      // move assignment
+
+    // Public Member Functions for Exploration Processes
+    void open(const std::string& saveFileName, const std::string& levelFileName, unsigned int gridSize);   // Prepares the map of a level, reading the chunk table of an existing save.
+    void save();                                    // Writes every explored chunk to the save file.
+    bool isExplored(int x, int y);                  // Returns whether a tile has been seen, loading its chunk if needed.
+    bool markVisible(const Visibility& visibility); // Marks every currently visible tile as explored.
+    std::uint64_t exploredBits(unsigned int chunkX, unsigned int y);   // Returns the explored bits of one row of a chunk.
+    unsigned int chunksPerSide() const {return m_chunksPerSide;}
+    const std::string& saveFileName() const {return m_saveFileName;}
+
+
+private:
+    struct Chunk
+    {
+        std::uint64_t rows[CHUNK_SIZE] = {};
+    };
+
+    // Private Member Functions for Exploration Processes
+    Chunk* chunkAt(unsigned int chunkX, unsigned int chunkY, bool create);    // Returns a chunk, loading or allocating it when necessary.
+
+    // Private Member Variables
+    std::vector<std::unique_ptr<Chunk>> m_chunks;   // Loaded chunks, nullptr if not loaded or never explored.
+    std::vector<std::uint32_t> m_fileOffsets;       // Offset of each chunk in the save file, 0 if it is not saved.
+    std::ifstream m_file;                           // Save file the unloaded chunks are read from.
+    std::string m_saveFileName;
+    std::string m_levelFileName;
+    unsigned int m_gridSize;
+    unsigned int m_chunksPerSide;
+};
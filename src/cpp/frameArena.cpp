@@ -0,0 +1,69 @@
+#include "frameArena.h"
+
+
+alignas(std::max_align_t) thread_local char FrameArena::s_buffer[FrameArena::CAPACITY];
+thread_local std::size_t FrameArena::s_used = 0;
+thread_local std::size_t FrameArena::s_peak = 0;
+
+
+/**
+ * @brief Returns memory that is valid until reset().
+ * @details Falls back to operator new when the buffer is full.
+ * @throw std::bad_alloc if the buffer is full and the heap cannot provide the
+ * memory either.
+ * @param bytes - the bytes to allocate.
+ * @param alignment - the alignment the memory needs, a power of two.
+ * @return void* - the memory
+ */
+void* FrameArena::allocate(std::size_t bytes, std::size_t alignment)
+{
+    std::size_t start = (s_used + alignment - 1) & ~(alignment - 1);
+    if (start + bytes > CAPACITY || alignment > alignof(std::max_align_t))
+    {
+        return ::operator new(bytes);
+    }
+    s_used = start + bytes;
+    if (s_used > s_peak)
+    {
+        s_peak = s_used;
+    }
+    return s_buffer + start;
+}
+
+
+/**
+ * @brief Frees memory from allocate().
+ * @details Memory from the buffer is only taken back if it is the most
+ * recent allocation; the rest waits for reset().
+ * @throw None
+ * @param memory - the memory.
+ * @param bytes - the bytes that were allocated.
+ * @return None
+ */
+void FrameArena::deallocate(void* memory, std::size_t bytes) noexcept
+{
+    char* block = static_cast<char*>(memory);
+    if (block < s_buffer || block >= s_buffer + CAPACITY)
+    {
+        ::operator delete(memory);
+    }
+    else if (block + bytes == s_buffer + s_used)
+    {
+        s_used = block - s_buffer;
+    }
+}
+
+
+/**
+ * @brief Takes back everything this thread allocated since its last reset.
+ * @details Called by Game at the end of every frame, by the gameplay
+ * simulation at the end of every tick, and by the job system workers after
+ * every job.
+ * @throw None
+ * @param None
+ * @return None
+ */
+void FrameArena::reset()
+{
+    s_used = 0;
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+
+// Included C++11 Libraries
+#include <vector>
+#include <string>
+#include <cstddef>
+#include <new>
+
+
+/**
+ * Class Name: FrameArena
+ * Brief: Bump allocator for data that only lives until the end of the frame.
+ * Description:
+ *  Hands out memory from a fixed buffer by moving a pointer forward, and
+ *  takes all of it back at once when the frame ends with reset(). The
+ *  buffer is static, so using the arena never touches the heap unless a
+ *  frame needs more than CAPACITY bytes, in which case the rest comes from
+ *  operator new and is freed as usual. Freeing the most recent allocation
+ *  gives its memory back straight away, so a growing vector reuses it.
+ *  Every thread has its own buffer, reset by the loop that thread runs: the
+ *  game loop resets it once per frame, the gameplay simulation once per
+ *  tick and the job system workers once per job. Nothing allocated from it may be kept past the frame or handed to
+ *  another thread; use FrameVector and FrameString for local variables and
+ *  return values.
+ */
+class FrameArena
+{
+public:
+    static constexpr std::size_t CAPACITY = 256 * 1024;
+
+    // Public Member Functions for FrameArena Processes
+    static void* allocate(std::size_t bytes, std::size_t alignment);   // Returns memory that is valid until reset().
+    static void deallocate(void* memory, std::size_t bytes) noexcept;
+    static void reset();        // Takes back everything this thread allocated since its last reset.
+    static std::size_t used() {return s_used;}
+    static std::size_t peak() {return s_peak;}      // Most bytes this thread used in a single frame.
+
+
+private:
+    // Private Member Variables
+    alignas(std::max_align_t) static thread_local char s_buffer[CAPACITY];
+    static thread_local std::size_t s_used;
+    static thread_local std::size_t s_peak;
+};
+
+
+/**
+ * Class Name: FrameAllocator
+ * Brief: Standard library allocator that allocates from the FrameArena.
+ */
+template <typename T>
+class FrameAllocator
+{
+public:
+    typedef T value_type;
+
+    FrameAllocator() noexcept {}
+    template <typename U>
+    FrameAllocator(const FrameAllocator<U>&) noexcept {}
+
+    T* allocate(std::size_t count) {return static_cast<T*>(FrameArena::allocate(count * sizeof(T), alignof(T)));}
+    void deallocate(T* memory, std::size_t count) noexcept {FrameArena::deallocate(memory, count * sizeof(T));}
+
+    template <typename U>
+    bool operator==(const FrameAllocator<U>&) const noexcept {return true;}
+    template <typename U>
+    bool operator!=(const FrameAllocator<U>&) const noexcept {return false;}
+};
+
+
+// Containers for values that do not outlive the frame
+template <typename T>
+using FrameVector = std::vector<T, FrameAllocator<T>>;
+typedef std::basic_string<char, std::char_traits<char>, FrameAllocator<char>> FrameString;
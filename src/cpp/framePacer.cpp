@@ -0,0 +1,191 @@
+#include "framePacer.h"
+
+
+/**
+ * @brief FramePacer class constructor
+ * @details Starts without a frame rate limit, so frames are not waited for
+ * until setRate() is called.
+ * @throw std::bad_alloc if the interval ring cannot be allocated.
+ */
+FramePacer::FramePacer() :
+m_rate(0),
+m_period(Clock::duration::zero()),
+m_spin(std::chrono::milliseconds(1)),
+m_skipLateFrames(false),
+m_skippedInRow(0),
+m_restarted(true),
+m_intervals(HISTORY, 0.0f),
+m_next(0),
+m_intervalCount(0),
+m_lateFrames(0),
+m_skippedFrames(0)
+{
+    restart();
+}
+
+
+/**
+ * @brief Sets the frames per second, 0 for no limit.
+ * @details Changing the rate starts the timeline and the stats over. Setting
+ * the rate it already has does nothing, so it can be set every frame.
+ * @throw None
+ * @param framesPerSecond - the frames per second to pace to.
+ * @return None
+ */
+void FramePacer::setRate(unsigned int framesPerSecond)
+{
+    if (framesPerSecond == m_rate)
+    {
+        return;
+    }
+    m_rate = framesPerSecond;
+    m_period = Clock::duration::zero();
+    if (m_rate != 0)
+    {
+        m_period = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / m_rate));
+    }
+    m_intervalCount = 0;
+    restart();
+}
+
+
+/**
+ * @brief Waits until the next frame is due, returning false if it should not
+ * be drawn.
+ * @details Each frame is due one period after the previous one was due, not
+ * after it started. A frame that is due already starts straight away. If it
+ * is more than a whole period late it is skipped when skipping is on, up to
+ * MAX_SKIPPED frames in a row; otherwise the timeline starts over from now,
+ * since the frames in between cannot be caught up. A skipped frame still
+ * counts as the start of a frame, so the interval kept for the next drawn
+ * frame covers one period rather than two, and skips only show up in the
+ * skipped frame count.
+ * @throw None
+ * @param None
+ * @return bool - true if the frame should be drawn, false if it should only
+ * be updated
+ */
+bool FramePacer::waitForFrame()
+{
+    bool draw = true;
+    if (m_period != Clock::duration::zero())
+    {
+        m_due += m_period;
+        Clock::time_point now = Clock::now();
+        if (now < m_due)
+        {
+            sleepUntil(m_due);
+        }
+        else
+        {
+            m_lateFrames += !m_restarted; // the first frame after a restart is due straight away
+            if (now - m_due >= m_period && m_skipLateFrames && m_skippedInRow < MAX_SKIPPED)
+            {
+                draw = false;
+            }
+            else if (now - m_due >= m_period)
+            {
+                m_due = now;
+            }
+        }
+    }
+
+    if (!draw)
+    {
+        ++m_skippedInRow;
+        ++m_skippedFrames;
+        m_lastStart = Clock::now();
+        return false;
+    }
+    m_skippedInRow = 0;
+    Clock::time_point start = Clock::now();
+    if (!m_restarted)
+    {
+        m_intervals[m_next] = std::chrono::duration<float, std::milli>(start - m_lastStart).count();
+        m_next = (m_next + 1) % HISTORY;
+        m_intervalCount = std::min(m_intervalCount + 1, HISTORY);
+    }
+    m_restarted = false;
+    m_lastStart = start;
+    return true;
+}
+
+
+/**
+ * @brief Starts the timeline over from now.
+ * @details The next frame is due straight away, and the time since the
+ * previous frame is not kept. Called after the game was idle.
+ * @throw None
+ * @param None
+ * @return None
+ */
+void FramePacer::restart()
+{
+    m_due = Clock::now() - m_period;
+    m_skippedInRow = 0;
+    m_restarted = true;
+}
+
+
+/**
+ * @brief Returns the pacing of the last HISTORY frames.
+ * @throw None
+ * @param None
+ * @return FramePacer::Stats - the pacing, with zero times if no frames were
+ * kept yet
+ */
+FramePacer::Stats FramePacer::stats() const
+{
+    Stats stats{};
+    stats.targetMs = m_rate != 0 ? 1000.0f / m_rate : 0.0f;
+    stats.spinMs = std::chrono::duration<float, std::milli>(m_spin).count();
+    stats.lateFrames = m_lateFrames;
+    stats.skippedFrames = m_skippedFrames;
+    if (m_intervalCount == 0)
+    {
+        return stats;
+    }
+
+    double sum = 0.0;
+    for (std::size_t i = 0; i < m_intervalCount; ++i)
+    {
+        sum += m_intervals[i];
+        stats.worstMs = std::max(stats.worstMs, m_intervals[i]);
+    }
+    double mean = sum / m_intervalCount;
+    double squares = 0.0;
+    for (std::size_t i = 0; i < m_intervalCount; ++i)
+    {
+        squares += (m_intervals[i] - mean) * (m_intervals[i] - mean);
+    }
+    stats.meanMs = mean;
+    stats.jitterMs = std::sqrt(squares / m_intervalCount);
+    return stats;
+}
+
+
+/**
+ * @brief Sleeps, then spins, until time.
+ * @details The sleep ends m_spin early. When a sleep overshoots by more than
+ * that, m_spin grows to cover it straight away; otherwise it shrinks back a
+ * little every frame, so a rare slow wake-up does not cost CPU for long.
+ * @throw None
+ * @param time - when to return.
+ * @return None
+ */
+void FramePacer::sleepUntil(Clock::time_point time)
+{
+    Clock::time_point wake = time - m_spin;
+    Clock::time_point now = Clock::now();
+    if (wake > now)
+    {
+        sf::sleep(sf::microseconds(std::chrono::duration_cast<std::chrono::microseconds>(wake - now).count()));
+        Clock::duration overshoot = Clock::now() - wake;
+        m_spin = std::clamp<Clock::duration>(std::max<Clock::duration>(overshoot + overshoot / 4, m_spin - m_spin / 16),
+                                             MIN_SPIN, MAX_SPIN);
+    }
+    while (Clock::now() < time)
+    {
+        std::this_thread::yield();
+    }
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+
+// Included C++11 Libraries
+#include <vector>
+#include <chrono>
+#include <thread>
+#include <cstdint>
+#include <cmath>
+#include <algorithm>
+
+
+// Included Graphics Library Dependencies
+#include <SFML/System.hpp>
+
+
+/**
+ * Class Name: FramePacer
+ * Brief: Starts frames at a steady rate, replacing setFramerateLimit().
+ * Description:
+ *  sf::Window::setFramerateLimit() sleeps for whatever is left of the frame
+ *  inside display(), after the input of the frame was read, and the sleep
+ *  can overshoot by a millisecond or more. FramePacer instead waits at the
+ *  start of the frame, before the input is polled, so what is shown is as
+ *  fresh as possible. Frames are scheduled on a fixed timeline from a
+ *  steady clock, so an early or late frame does not shift the ones after
+ *  it. The wait sleeps until shortly before the frame is due and spins for
+ *  the rest; how early it wakes adapts to how much the sleeps overshoot.
+ *  A frame that starts more than a whole frame late can optionally be
+ *  skipped, running its update without drawing, so the game catches up
+ *  instead of slowing down. The intervals between the last HISTORY frames
+ *  are kept for the performance overlay.
+ */
+class FramePacer
+{
+public:
+    // Pacing of the last HISTORY frames, in milliseconds
+    struct Stats
+    {
+        float targetMs;         // 0 when the frame rate is not limited.
+        float meanMs;           // Average time between the starts of frames.
+        float jitterMs;         // Standard deviation of the time between the starts of frames.
+        float worstMs;
+        float spinMs;           // How early the sleeps end, to spin for the rest.
+        std::uint64_t lateFrames;       // Since the program started.
+        std::uint64_t skippedFrames;
+    };
+
+    // Constructor
+    FramePacer();
+
+    // Public Member Functions for FramePacer Processes
+    void setRate(unsigned int framesPerSecond);   // Sets the frames per second, 0 for no limit.
+    void setSkipLateFrames(bool skip) {m_skipLateFrames = skip;}
+    bool waitForFrame();        // Waits until the next frame is due, returning false if it should not be drawn.
+    void restart();             // Starts the timeline over from now.
+    Stats stats() const;        // Returns the pacing of the last HISTORY frames.
+
+
+private:
+    typedef std::chrono::steady_clock Clock;
+
+    // Private Member Functions for FramePacer Processes
+    void sleepUntil(Clock::time_point time);    // Sleeps, then spins, until time.
+
+    // Private Member Constants
+    static constexpr std::size_t HISTORY = 120;     // Frames the stats are taken over.
+    static constexpr int MAX_SKIPPED = 2;           // Most frames in a row that are not drawn.
+    static constexpr std::chrono::microseconds MIN_SPIN{200};
+    static constexpr std::chrono::microseconds MAX_SPIN{4000};
+
+    // Private Member Variables
+    unsigned int m_rate;            // Frames per second, 0 for no limit.
+    Clock::duration m_period;       // Time between frames, zero for no limit.
+    Clock::time_point m_due;        // When the current frame was due to start.
+    Clock::time_point m_lastStart;  // When the current frame started.
+    Clock::duration m_spin;         // How long before a frame is due the sleep ends.
+    bool m_skipLateFrames;
+    int m_skippedInRow;
+    bool m_restarted;               // The next interval spans a restart and is not kept.
+    std::vector<float> m_intervals; // Ring of the last HISTORY intervals between frames, in milliseconds.
+    std::size_t m_next;             // Where the next interval goes in m_intervals.
+    std::size_t m_intervalCount;    // Intervals in m_intervals, up to HISTORY.
+    std::uint64_t m_lateFrames;
+    std::uint64_t m_skippedFrames;
+};
@@ -0,0 +1,46 @@
+#include "frameStats.h"
+
+
+unsigned int FrameStats::s_drawCalls = 0;
+unsigned int FrameStats::s_textureBinds = 0;
+const sf::RenderTarget* FrameStats::s_lastTarget = nullptr;
+const void* FrameStats::s_lastTexture = nullptr;
+std::atomic<std::uint64_t> FrameStats::s_allocations(0);
+std::atomic<std::uint64_t> FrameStats::s_allocatedBytes(0);
+std::atomic<std::uint64_t> FrameStats::s_tickAllocations(0);
+
+
+/**
+ * @brief Zeroes the draw call and texture bind counters.
+ * @details The allocation counters keep running, so they can be read from
+ * any thread; whoever reads them subtracts the previous reading.
+ * @throw None
+ * @param None
+ * @return None
+ */
+void FrameStats::startFrame()
+{
+    s_drawCalls = 0;
+    s_textureBinds = 0;
+}
+
+
+/**
+ * @brief Counts a draw call, and a texture bind if the texture changed.
+ * @details Switching to another target counts as a bind if the draw uses a
+ * texture, since the target's own context may have anything bound.
+ * @throw None
+ * @param target - the target being drawn on.
+ * @param texture - the texture of the draw, nullptr if it has none.
+ * @return None
+ */
+void FrameStats::countDraw(const sf::RenderTarget& target, const void* texture)
+{
+    ++s_drawCalls;
+    if (texture != s_lastTexture || (&target != s_lastTarget && texture))
+    {
+        ++s_textureBinds;
+    }
+    s_lastTarget = &target;
+    s_lastTexture = texture;
+}
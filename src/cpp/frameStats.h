@@ -0,0 +1,75 @@
+#pragma once
+
+
+// Included C++11 Libraries
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+
+
+// Included Graphics Library Dependencies
+#include <SFML/Graphics.hpp>
+
+
+/**
+ * Class Name: FrameStats
+ * Brief: Counts the draw calls, texture binds and heap allocations of a frame.
+ * Description:
+ *  SFML does not report what it sends to OpenGL, so every draw in the game
+ *  goes through FrameStats::draw(), which counts it as a draw call and counts
+ *  a texture bind whenever the texture differs from the one the previous draw
+ *  on the same target used, the same test SFML makes before binding one.
+ *  Heap allocations are counted by the global operator new in
+ *  memoryTracker.cpp, on every thread, with a relaxed atomic increment each.
+ *  The gameplay simulation adds up the allocations of its ticks separately,
+ *  so they can be checked along with the frames they happened during.
+ *  The draw counters are only touched by the thread that renders. Game
+ *  reads the counters at the end of each frame and starts the next one with
+ *  startFrame().
+ */
+class FrameStats
+{
+public:
+    // Public Member Functions for FrameStats Processes
+    template <typename Drawable>
+    static void draw(sf::RenderTarget& target, const Drawable& drawable, const sf::RenderStates& states = sf::RenderStates::Default)
+    {
+        countDraw(target, textureOf(drawable, states));
+        target.draw(drawable, states);
+    }
+    static void startFrame();   // Zeroes the draw call and texture bind counters.
+    static unsigned int drawCalls() {return s_drawCalls;}
+    static unsigned int textureBinds() {return s_textureBinds;}
+    static std::uint64_t allocations() {return s_allocations.load(std::memory_order_relaxed);}     // Since the program started.
+    static std::uint64_t allocatedBytes() {return s_allocatedBytes.load(std::memory_order_relaxed);}
+    static std::uint64_t threadAllocations() {return t_threadAllocations;}    // Made by the calling thread.
+    static std::uint64_t tickAllocations() {return s_tickAllocations.load(std::memory_order_relaxed);}  // Made by gameplay ticks since the program started.
+    static void countTickAllocations(std::uint64_t count) {s_tickAllocations.fetch_add(count, std::memory_order_relaxed);}
+    static void countAllocation(std::size_t bytes)
+    {
+        s_allocations.fetch_add(1, std::memory_order_relaxed);
+        s_allocatedBytes.fetch_add(bytes, std::memory_order_relaxed);
+        ++t_threadAllocations;
+    }
+
+
+private:
+    // Private Member Functions for FrameStats Processes
+    static void countDraw(const sf::RenderTarget& target, const void* texture);
+
+    // The texture a drawable is drawn with. Text draws with the glyph page of its font, which stands in for it here.
+    static const void* textureOf(const sf::Sprite& sprite, const sf::RenderStates&) {return sprite.getTexture();}
+    static const void* textureOf(const sf::Shape& shape, const sf::RenderStates&) {return shape.getTexture();}
+    static const void* textureOf(const sf::Text& text, const sf::RenderStates&) {return text.getFont();}
+    static const void* textureOf(const sf::Drawable&, const sf::RenderStates& states) {return states.texture;}
+
+    // Private Member Variables
+    static unsigned int s_drawCalls;
+    static unsigned int s_textureBinds;
+    static const sf::RenderTarget* s_lastTarget;
+    static const void* s_lastTexture;
+    static std::atomic<std::uint64_t> s_allocations;
+    static std::atomic<std::uint64_t> s_allocatedBytes;
+    static std::atomic<std::uint64_t> s_tickAllocations;
+    static inline thread_local std::uint64_t t_threadAllocations = 0;
+};
@@ -11,15 +11,16 @@
  */
 Game::Game(std::shared_ptr<sf::RenderWindow> window) : 
 m_window(window),
-m_width(m_window->getSize().x),
-m_height(m_window->getSize().y),
-m_settings(std::make_shared<Settings>()),
 m_music(std::make_shared<sf::Music>()),
-m_sectionName(SectionName::Menu)
+m_settings(std::make_shared<Settings>()),
+m_jobs(std::make_shared<JobSystem>()),
+m_sectionName(SectionName::Menu),
+m_width(m_window->getSize().x),
+m_height(m_window->getSize().y)
 {
-    m_section = std::make_unique<Menu>(m_window, m_settings, m_music, m_width, m_height);
+    m_section = std::make_unique<Menu>(m_window, m_settings, m_jobs, m_music, m_width, m_height);
     load();
-    m_window->setFramerateLimit(m_settings->frameRate);
+    m_pacer.setRate(m_settings->frameRate);
 }
 
 
@@ -45,12 +46,20 @@ Game::~Game()
  */
 void Game::load()
 {
+    PROFILE_ZONE("Game::load");
+    MemoryScope memoryScope(MemoryTag::UI);
     loadSettingsStruct();
     if (!m_font.loadFromFile("../assets/rm_typerighter.ttf"))
     {
         std::cout << "Game: Failed to load asset 'rm_typerighter.ttf'\n";
         std::exit(1);
     }
+    m_fpsText.setFont(m_font);
+    m_fpsString = sf::String(std::string(FPS_DIGITS, ' '));
+    m_fpsText.setPosition(15, -15); // position fps at top left of screen
+    m_perfOverlay.setFont(m_font);
+    m_perfOverlay.setPacer(m_pacer);
+    MemoryScope audioScope(MemoryTag::Audio);
     if (!m_music->openFromFile("../assets/2nd_Sonata_Malign_Chords.ogg"))
     {
         std::cout << "Game: Failed to load asset '2nd_Sonata_Malign_Chords.ogg'\n";
@@ -70,45 +79,76 @@ void Game::load()
 
 /**
  * @brief Updates the game based on the current state.
- * @details The update function of the current section is called. If the
+ * @details The completions of finished background jobs are run, then the
+ * update function of the current section is called. If the
  * section name does not match the child's section name, then update the parent
- * section name. The previous section is deleted and replaced with the new
- * section.
+ * section name. The previous section is deleted before the new section is
+ * built, so its background jobs are out of the way, except for a MazeBuilder
+ * starting a playtest, which is kept aside and resumed as it was when the
+ * playtest ends. A new section is given the
+ * event script, if there is one. The time the update took and the time since
+ * the previous update are kept for the performance overlay. Memory allocated
+ * while updating counts as transient, except for new sections, which count
+ * as UI.
  * @throw SFML exceptions may be thrown during fatal errors.
  * @param None
  * @return None
  */
 void Game::update()
 {
+    PROFILE_ZONE("Game::update");
+    MemoryScope memoryScope(MemoryTag::Transient);
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    m_jobs->runCompletions();
     m_section->update();
     if (m_sectionName != m_section->getSectionName() && m_section->soundStatus() != sf::Sound::Status::Playing)
     {
+        MemoryScope sectionScope(MemoryTag::UI);
         m_sectionName = m_section->getSectionName();
+        if (m_sectionName != SectionName::Playtest && !(m_sectionName == SectionName::MazeBuilder && m_suspendedSection))
+        {
+            m_section.reset(); // cancels its background jobs before the next section queues any
+        }
         if (m_sectionName == SectionName::Menu)
         {
-            m_section = std::make_unique<Menu>(m_window, m_settings, m_music, m_width, m_height);
+            m_section = std::make_unique<Menu>(m_window, m_settings, m_jobs, m_music, m_width, m_height);
+        }
+        else if (m_sectionName == SectionName::MazeBuilder && m_suspendedSection)
+        {
+            m_section = std::move(m_suspendedSection); // back from a playtest
+            static_cast<MazeBuilder&>(*m_section).resume();
         }
         else if (m_sectionName == SectionName::MazeBuilder)
         {
-            m_section = std::make_unique<MazeBuilder>(m_window, m_settings, m_width, m_height);
+            m_section = std::make_unique<MazeBuilder>(m_window, m_settings, m_jobs, m_width, m_height);
+        }
+        else if (m_sectionName == SectionName::Playtest)
+        {
+            // the builder is kept as it is, and the playtest shares its grid
+            MazeBuilder& builder = static_cast<MazeBuilder&>(*m_section);
+            std::unique_ptr<Section> playtest = std::make_unique<Gameplay>(m_window, m_settings, m_jobs, m_music, m_width, m_height,
+                                                                                     builder.grid(), builder.playtestSpawn());
+            m_suspendedSection = std::move(m_section);
+            m_section = std::move(playtest);
         }
         else if (m_sectionName == SectionName::SaveSlot1)
         {
-            m_section = std::make_unique<Gameplay>(m_window, m_settings, m_music, m_width, m_height, m_settings->saveSlot1, 1);
+            m_section = std::make_unique<Gameplay>(m_window, m_settings, m_jobs, m_music, m_width, m_height, m_settings->saveSlot1, 1);
         }
         else if (m_sectionName == SectionName::SaveSlot2)
         {
-            m_section = std::make_unique<Gameplay>(m_window, m_settings, m_music, m_width, m_height, m_settings->saveSlot2, 2);
+            m_section = std::make_unique<Gameplay>(m_window, m_settings, m_jobs, m_music, m_width, m_height, m_settings->saveSlot2, 2);
         }
         else if (m_sectionName == SectionName::SaveSlot3)
         {
-            m_section = std::make_unique<Gameplay>(m_window, m_settings, m_music, m_width, m_height, m_settings->saveSlot3, 3);
+            m_section = std::make_unique<Gameplay>(m_window, m_settings, m_jobs, m_music, m_width, m_height, m_settings->saveSlot3, 3);
         }
+        m_section->setEventScript(m_eventScript);
     }
 
-    // Calculate FPS and reset clock
-    m_fps = 1.0f / m_clock.getElapsedTime().asSeconds();
-    m_clock.restart();
+    // Frame time since the previous update, and reset clock
+    m_frameMs = m_clock.restart().asSeconds() * 1000.0f;
+    m_updateMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
 }
 
 
@@ -123,6 +163,8 @@ void Game::update()
  */
 void Game::handleInput()
 {
+    PROFILE_ZONE("Game::handleInput");
+    MemoryScope memoryScope(MemoryTag::Transient);
     m_section->handleInput();
 }
 
@@ -131,37 +173,123 @@ void Game::handleInput()
  * @brief Displays all Game assets to the screen.
  * @details The render function of the current section is called to display all
  * game assets (backgrounds, sprites, etc.). FPS is then displayed if display
- * FPS is true.
+ * FPS is true, as the average over the last quarter second, which is not
+ * capped at the frame rate setting so stalls and headroom both show. The
+ * performance overlay is drawn last if it is shown. Nothing is drawn if the
+ * frame pacer skipped the frame. This is the end of the frame, so the draw
+ * counters and the FrameArena are reset for the next one.
  * @throw SFML exceptions may be thrown during fatal errors.
  * @param None
  * @return None
  */
 void Game::render()
 {
+    PROFILE_ZONE("Game::render");
+    MemoryScope memoryScope(MemoryTag::Transient);
+    if (!m_drawFrame)
+    {
+        FrameStats::startFrame();
+        FrameArena::reset();
+        return;
+    }
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
     m_section->render();
+    float renderMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
 
+    m_frameCount++;
     if (m_settings->showFps)
     {
         // Updates the displayed FPS every quarter second
-        if (m_frameCount % (m_settings->frameRate / 4) == 0)
+        float elapsed = m_fpsClock.getElapsedTime().asSeconds();
+        if (elapsed >= 0.25f)
         {
-            m_displayedFps = m_fps;
-            if (m_displayedFps > m_settings->frameRate)
-            {
-                m_displayedFps = m_settings->frameRate;
-            }
+            setFpsDigits(static_cast<unsigned int>(m_frameCount / elapsed + 0.5f));
+            m_fpsText.setString(m_fpsString);
+            m_fpsClock.restart();
+            m_frameCount = 0;
         }
-        sf::Text text;
-        text.setFont(m_font);
+        FrameStats::draw(*m_window, m_fpsText);
+    }
+
+    if (m_settings->showPerfOverlay)
+    {
+        m_perfOverlay.addFrame(m_frameMs, m_updateMs, renderMs, m_section->gridMemory());
+        m_perfOverlay.draw(*m_window);
+    }
+    FrameStats::startFrame();
+    FrameArena::reset();
+}
 
-        std::string fpsString;
-        fpsString = std::to_string(m_displayedFps);
-        text.setString(fpsString);
 
-        text.setPosition(15, -15); // position fps at top left of screen
-        m_window->draw(text);
+/**
+ * @brief Writes the FPS into m_fpsString without changing its length.
+ * @details The digits are followed by spaces, so the string never has to
+ * grow and updating it does not allocate. FPS above MAX_SHOWN_FPS are shown
+ * as MAX_SHOWN_FPS.
+ * @throw None
+ * @param fps - the FPS to show.
+ * @return None
+ */
+void Game::setFpsDigits(unsigned int fps)
+{
+    char digits[FPS_DIGITS + 1];
+    std::snprintf(digits, sizeof(digits), "%u", std::min(fps, MAX_SHOWN_FPS));
+    std::size_t length = std::strlen(digits);
+    for (std::size_t i = 0; i < FPS_DIGITS; ++i)
+    {
+        m_fpsString[i] = i < length ? digits[i] : ' ';
     }
-    m_frameCount++;
+}
+
+
+/**
+ * @brief Returns whether the screen stays the same until the next input.
+ * @details The current section has to be idle, with no switch to another
+ * section waiting on its sound, and the performance overlay has to be
+ * hidden, since its graph moves every frame. No background job may have a
+ * completion waiting to run. A game driven by an event
+ * script is never idle. The FPS text may be shown; it keeps the last value
+ * until frames are drawn again.
+ * @throw None
+ * @param None
+ * @return bool - true if a frame would draw the same image as the last one
+ */
+bool Game::isIdle() const
+{
+    return m_section->isIdle() && m_sectionName == m_section->getSectionName()
+           && !m_settings->showPerfOverlay && !m_eventScript && !m_jobs->hasCompletions();
+}
+
+
+/**
+ * @brief Sleeps until an input event arrives or IDLE_TIMEOUT_MS passes.
+ * @details SFML 2.5 can only wait for an event without a timeout, so the
+ * window is polled every IDLE_POLL_MS instead, which costs next to nothing.
+ * An event that arrives is held by the current section, which polls it
+ * first in its next handleInput(). The frame clock is restarted, so the
+ * time spent waiting does not show up as a long frame, and the frame pacer
+ * starts the frame with the input straight away.
+ * @throw SFML exceptions may be thrown during fatal errors.
+ * @param None
+ * @return bool - true if there is input to handle, false if the time ran out
+ */
+bool Game::waitForInput()
+{
+    PROFILE_ZONE("Game::waitForInput");
+    sf::Clock waited;
+    sf::Event event;
+    while (!m_window->pollEvent(event))
+    {
+        if (waited.getElapsedTime().asMilliseconds() >= IDLE_TIMEOUT_MS)
+        {
+            return false;
+        }
+        sf::sleep(sf::milliseconds(IDLE_POLL_MS));
+    }
+    m_section->holdEvent(event);
+    m_clock.restart();
+    m_pacer.restart();
+    return true;
 }
 
 
@@ -179,6 +307,38 @@ void Game::clearScreen()
 }
 
 
+/**
+ * @brief Waits until the frame pacer starts the next frame.
+ * @details Called before the input of the frame is handled, so the input is
+ * as recent as possible when the frame is shown. The frame rate setting may
+ * have changed in a settings screen, so it is given to the pacer every frame.
+ * @throw None
+ * @param None
+ * @return None
+ */
+void Game::waitForFrame()
+{
+    PROFILE_ZONE("Game::waitForFrame");
+    m_pacer.setRate(m_settings->frameRate);
+    m_drawFrame = m_pacer.waitForFrame();
+}
+
+
+/**
+ * @brief Shows the frame, unless the frame pacer skipped it.
+ * @throw SFML exceptions may be thrown during fatal errors.
+ * @param None
+ * @return None
+ */
+void Game::display()
+{
+    if (m_drawFrame)
+    {
+        m_window->display();
+    }
+}
+
+
 /**
  * @brief Getter for the current status of the game.
  * @details A boolean is returned indicating whether the game is running.
@@ -202,6 +362,7 @@ bool Game::isDone() const
  */
 void Game::loadSettingsStruct()
 {
+    PROFILE_ZONE("Game::loadSettingsStruct");
     std::fstream file("../user_data/settings.csv", std::ios::in);
     char space;
     std::string parameterName;
@@ -222,3 +383,18 @@ void Game::loadSettingsStruct()
     getline(file, m_settings->saveSlot3);
 }
 
+
+/**
+ * @brief Drives every section with scripted input.
+ * @details The current section and every section created after it read
+ * their events and the mouse position from the script instead of the
+ * window. Used by the soak test.
+ * @throw None
+ * @param script - the script to read input from, or nullptr for the window.
+ * @return None
+ */
+void Game::setEventScript(std::shared_ptr<EventScript> script)
+{
+    m_eventScript = script;
+    m_section->setEventScript(script);
+}
@@ -9,6 +9,9 @@
 #include <cstdio>
 #include <iostream>
 #include <memory>
+#include <chrono>
+#include <cstring>
+#include <algorithm>
 
 
 // Included Graphics Library Dependencies
@@ -22,6 +25,10 @@
 #include "menu.h"
 #include "mazeBuilder.h"
 #include "gameplay.h"
+#include "perfOverlay.h"
+#include "frameStats.h"
+#include "frameArena.h"
+#include "framePacer.h"
 
 
 /**
@@ -52,24 +59,49 @@ public:
     void handleInput();             // Manages all game input.
     void render();                  // Displays all game assets to the screen.
     void clearScreen();             // Clears the game screen of all assets.
+    void waitForFrame();            // Waits until the frame pacer starts the next frame.
+    void display();                 // Shows the frame, unless the frame pacer skipped it.
+    void setSkipLateFrames(bool skip) {m_pacer.setSkipLateFrames(skip);}
     bool isDone() const;            // Getter for the current status of the game.
+    bool isIdle() const;            // Returns whether the screen stays the same until the next input.
+    bool waitForInput();            // Sleeps until an input event arrives or IDLE_TIMEOUT_MS passes.
     void loadSettingsStruct();      // Loads the settings from a .csv file.
+    void setEventScript(std::shared_ptr<EventScript> script);  // Drives every section with scripted input.
+    SectionName sectionName() const {return m_sectionName;}
 
 
 private:
+    // Private Member Functions for General Game Processes
+    void setFpsDigits(unsigned int fps);    // Writes the FPS into m_fpsString without changing its length.
+
+    // Private Member Constants
+    static constexpr std::size_t FPS_DIGITS = 5;
+    static constexpr unsigned int MAX_SHOWN_FPS = 99999;    // The most FPS_DIGITS digits can show.
+    static constexpr sf::Int32 IDLE_TIMEOUT_MS = 250;       // Longest waitForInput() sleeps before isIdle() is checked again.
+    static constexpr sf::Int32 IDLE_POLL_MS = 10;           // Time between looking for input while idle.
+
     // Private SFML Member Variables
     std::shared_ptr<sf::RenderWindow> m_window;     // SFML base frame for all graphics.
     sf::Font m_font;                // SFML instance of the game's generic font.
+    sf::Text m_fpsText;             // Shown when showFps is set, its string changes every quarter second.
+    sf::String m_fpsString;         // FPS_DIGITS characters, changed in place by setFpsDigits().
     std::shared_ptr<sf::Music> m_music;             // SFML instance of the current game music.
-    sf::Clock m_clock;
+    sf::Clock m_clock;              // Time since the previous frame's update.
+    sf::Clock m_fpsClock;           // Time since the displayed FPS changed.
 
     // Private Game Member Variables
     std::shared_ptr<Settings> m_settings;           // Pointer to the current settings configuration.
+    std::shared_ptr<JobSystem> m_jobs;              // Background workers shared by every section, outlives them.
     std::unique_ptr<Section> m_section;             // Pointer to the current section object.
+    std::unique_ptr<Section> m_suspendedSection;    // The MazeBuilder waiting for a playtest to end.
+    std::shared_ptr<EventScript> m_eventScript;     // Given to every new section, nullptr for user input.
     SectionName  m_sectionName;     // The name of the current section (ex: title_screen).
-    unsigned int m_fps = 0;         // The current FPS being experienced.
-    unsigned int m_displayedFps = 0;// The current FPS being displayed.
-    unsigned int m_frameCount = 0;  // The number of elapsed frames.
+    PerfOverlay m_perfOverlay;      // Shown when showPerfOverlay is set.
+    FramePacer m_pacer;             // Paces frames to the frame rate setting.
+    bool m_drawFrame = true;        // False when the frame pacer skipped the current frame.
+    float m_frameMs = 0.0f;         // The time between the last two updates.
+    float m_updateMs = 0.0f;        // The time the last update took.
+    unsigned int m_frameCount = 0;  // The number of frames since the displayed FPS changed.
     float m_width;                  // The width of the SFML window.
     float m_height;                 // The height of the SFML window.
 };
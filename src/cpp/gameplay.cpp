@@ -4,13 +4,14 @@
 /**
  * @brief Gameplay class constructor
  * @details Initializes the variables required for running ingame attributes,
- * including the player and ingame graphics.
+ * including the player and ingame graphics. The level is read from a .maze file.
  * @throw SFML exceptions may be thrown during fatal errors, especially if
  * assets fail to load.
  * @param window - a pointer to an instance of sf::RenderWindow. This is the
  * base frame of the game.
  * @param settings - a pointer to an instance of the Settings struct. It
  * contains all user preferences in relation to the game.
+ * @param jobs - a pointer to the game's JobSystem, used for loading assets.
  * @param music - a pointer to an instance of sf::Music. It holds the music that
  * is played throughout the game.
  * @param width - a float containing the starting width of the game window.
@@ -20,29 +21,16 @@
  * @param saveSlot - an integer that contains the current save slot being
  * played between 1-3.
  */
-Gameplay::Gameplay(std::shared_ptr<sf::RenderWindow> window, std::shared_ptr<Settings> settings, 
+Gameplay::Gameplay(std::shared_ptr<sf::RenderWindow> window, std::shared_ptr<Settings> settings, std::shared_ptr<JobSystem> jobs,
                    std::shared_ptr<sf::Music> music, float width, float height, std::string fileName, int saveSlot) : vectorOfTextures(8)
 {
     m_window = window;
     m_settings = settings;
+    m_jobs = jobs;
     m_music = music;
     m_width = width;
     m_height = height;
-    objectsToDisplay = 19; // draw 19 squares on a screen
-    TEXTURE_SIZE = 250.0f; // size of square in pixels
-    gridOffset.x = 0;
-    gridOffset.y = 0;
-    player.velocity.x = 0;
-    player.velocity.y = 0;
-    m_screenName = "game_screen";
-
-
-
-    deathScreenTexture = std::make_unique<sf::Texture>();
-    hardModeTexture = std::make_unique<sf::Texture>();
-    pausedScreenTexture = std::make_unique<sf::Texture>();
-    settingsScreenTexture = std::make_unique<sf::Texture>();;
-    winScreenTexture = std::make_unique<sf::Texture>();
+    m_exitSection = SectionName::Menu;
 
     if (saveSlot == 1)
     {
@@ -59,18 +47,96 @@ Gameplay::Gameplay(std::shared_ptr<sf::RenderWindow> window, std::shared_ptr<Set
 
 
     this->fileName = fileName;
+    m_level.loadFromFile(fileName);
+    unsigned int startX = 0, startY = 0;
+    m_level.find(6, startX, startY);
+    startingBlock = sf::Vector2i(startX, startY);
+    start("../user_data/save_slot_" + std::to_string(saveSlot) + ".fog");
+    m_watcher.watch(fileName, m_level);
+}
+
+
+/**
+ * @brief Gameplay class constructor for playtesting a level from the MazeBuilder
+ * @details The level shares its tiles with the MazeBuilder's grid instead of
+ * being saved and read back from a file, so nothing is copied unless a tile
+ * changes while playing. Nothing explored while playtesting is saved, and
+ * leaving goes back to the MazeBuilder instead of the menu.
+ * @throw SFML exceptions may be thrown during fatal errors, especially if
+ * assets fail to load.
+ * @param window - a pointer to an instance of sf::RenderWindow. This is the
+ * base frame of the game.
+ * @param settings - a pointer to an instance of the Settings struct. It
+ * contains all user preferences in relation to the game.
+ * @param jobs - a pointer to the game's JobSystem, used for loading assets.
+ * @param music - a pointer to an instance of sf::Music. It holds the music that
+ * is played throughout the game.
+ * @param width - a float containing the starting width of the game window.
+ * @param height - a float containing the starting height of the game window.
+ * @param level - the grid to play.
+ * @param spawn - the tile the player starts on.
+ */
+Gameplay::Gameplay(std::shared_ptr<sf::RenderWindow> window, std::shared_ptr<Settings> settings, std::shared_ptr<JobSystem> jobs,
+                   std::shared_ptr<sf::Music> music, float width, float height, const TileGrid& level, sf::Vector2i spawn) :
+vectorOfTextures(8),
+m_level(level)
+{
+    m_window = window;
+    m_settings = settings;
+    m_jobs = jobs;
+    m_music = music;
+    m_width = width;
+    m_height = height;
+    m_exitSection = SectionName::MazeBuilder;
+    m_sectionName = SectionName::Playtest;
+    startingBlock = spawn;
+    start("");
+}
+
+
+/**
+ * @brief Sets up everything that depends on the level and places the player.
+ * @details Shared by both constructors once m_level and startingBlock are
+ * known. Loads every asset, sets up the playing grid, opens the explored
+ * tiles of the level and positions the player on the starting block.
+ * @throw SFML exceptions may be thrown during fatal errors, especially if
+ * assets fail to load.
+ * @param saveFileName - the file the explored tiles are kept in, or an empty
+ * string to not keep them.
+ * @return None
+ */
+void Gameplay::start(const std::string& saveFileName)
+{
+    objectsToDisplay = 19; // draw 19 squares on a screen
+    TEXTURE_SIZE = 250.0f; // size of square in pixels
+    gridOffset.x = 0;
+    gridOffset.y = 0;
+    player.velocity.x = 0;
+    player.velocity.y = 0;
+    m_screenName = "game_screen";
+
+
+
+    deathScreenTexture = std::make_unique<sf::Texture>();
+    hardModeTexture = std::make_unique<sf::Texture>();
+    pausedScreenTexture = std::make_unique<sf::Texture>();
+    settingsScreenTexture = std::make_unique<sf::Texture>();;
+    winScreenTexture = std::make_unique<sf::Texture>();
+
     squareSize = static_cast<float>(std::max(m_width, m_height)) / objectsToDisplay;
 
-    healthBarBg.setSize(sf::Vector2f(0.15 * m_width, 0.01 * height));
+    healthBarBg.setSize(sf::Vector2f(0.15 * m_width, 0.01 * m_height));
     healthBarBg.setFillColor(sf::Color(255, 26, 26));
     healthBarBg.setPosition(squareSize, 0.93 * m_height);
 
-    healthBar.setSize(sf::Vector2f(0.15 * m_width, 0.01 * height));
+    healthBar.setSize(sf::Vector2f(0.15 * m_width, 0.01 * m_height));
     healthBar.setFillColor(sf::Color(0, 128, 0));
     healthBar.setPosition(squareSize, 0.93 * m_height);
 
 
     load();
+    populateGrid();
+    m_exploration.open(saveFileName, fileName, GRID_SIZE);
 
     upperLeftSquare.x = startingBlock.x - (objectsToDisplay - 1) / 2.0f;
     upperLeftSquare.y = startingBlock.y - ((objectsToDisplay / m_width) * m_height-1) / 2.0f;
@@ -85,24 +151,46 @@ Gameplay::Gameplay(std::shared_ptr<sf::RenderWindow> window, std::shared_ptr<Set
 
     m_squareToMoveTo.setSize(sf::Vector2f(squareSize, squareSize));
     m_squareToMoveTo.setFillColor(sf::Color(20, 20, 20, 200));
-    m_squareToMoveTo.setPosition(-1, -1);
+    m_moveTarget = sf::Vector2f(-1, -1);
+    m_playerSprite = player.sprite;
+
+    // minimap sits above the health bar
+    float minimapSize = 0.15 * m_width;
+    m_minimapFrame.setSize(sf::Vector2f(minimapSize, minimapSize));
+    m_minimapFrame.setFillColor(sf::Color(0, 0, 0, 160));
+    m_minimapFrame.setOutlineColor(sf::Color(230, 230, 220, 150));
+    m_minimapFrame.setOutlineThickness(2);
+    m_minimapFrame.setPosition(squareSize, 0.92 * m_height - minimapSize);
+    m_minimapSprite.setPosition(m_minimapFrame.getPosition());
+    m_minimapSprite.setScale(minimapSize / MINIMAP_TILES, minimapSize / MINIMAP_TILES);
+    m_minimapPlayer.setSize(sf::Vector2f(4, 4));
+    m_minimapPlayer.setOrigin(2, 2);
+    m_minimapPlayer.setFillColor(sf::Color::White);
+    buildMinimap();
+
+    m_visibilityOrigin = sf::Vector2i(-1, -1);
+    updateVisibility();
 }
 
 
 /**
  * @brief Destructor for the Gameplay class.
- * @details Deletes the allocated memory for all game textures.
+ * @details Stops the simulation, then saves the explored tiles of the level,
+ * unless it was being playtested. All game textures are deallocated
+ * automatically.
  */
 Gameplay::~Gameplay()
 {
+    stopSimulation();
+    m_exploration.save();
 }
 
 
 /**
  * @brief Manages the loading of all Gameplay assets.
  * @details Loads assets required for gameplay, including player sprite and
- * grid textures. This function is virtual and overrides the parent Section
- * load() function.
+ * grid textures. The image files are decoded in parallel on the job system.
+ * This function is virtual and overrides the parent Section load() function.
  * @throw SFML exceptions are thrown when assets fail to load. The program may
  * terminate when fatal errors occur. This function is called from a master
  * load() function in the Game class.
@@ -111,82 +199,41 @@ Gameplay::~Gameplay()
  */
 void Gameplay::load()
 {
+    PROFILE_ZONE("Gameplay::load");
 
     for (unsigned int i=0; i < vectorOfTextures.size(); ++i)
     {
         vectorOfTextures[i] = std::make_unique<sf::Texture>();
     }
 
-    if (!vectorOfTextures[0]->loadFromFile("../assets/blue_floor_texture.png"))
-    {
-        std::cout << "Gameplay: Failed to load asset 'blue_floor_texture.png'\n";
-        std::exit(1);
-    }
-    if (!vectorOfTextures[1]->loadFromFile("../assets/blue_floor_trapped_texture.png"))
-    {
-        std::cout << "Gameplay: Failed to load asset 'blue_floor_trapped_texture.png'\n";
-        std::exit(1);
-    }
-    if (!vectorOfTextures[2]->loadFromFile("../assets/blue_floor_fire_texture.png"))
-    {
-        std::cout << "Gameplay: Failed to load asset 'blue_floor_fire_texture.png'\n";
-        std::exit(1);
-    }
-    if (!vectorOfTextures[3]->loadFromFile("../assets/death_texture.png"))
-    {
-        std::cout << "Gameplay: Failed to load asset 'death_texture.png'\n";
-        std::exit(1);
-    }
-    if (!vectorOfTextures[4]->loadFromFile("../assets/wall_texture.png"))
-    {
-        std::cout << "Gameplay: Failed to load asset 'wall_texture.png'\n";
-        std::exit(1);
-    }
-    if (!vectorOfTextures[5]->loadFromFile("../assets/alien_texture.png"))
-    {
-        std::cout << "Gameplay: Failed to load asset 'alien_texture.png'\n";
-        std::exit(1);
-    }
-    if (!vectorOfTextures[6]->loadFromFile("../assets/start_texture.png"))
-    {
-        std::cout << "Gameplay: Failed to load asset 'start_texture.png'\n";
-        std::exit(1);
-    }
-    if (!vectorOfTextures[7]->loadFromFile("../assets/end_texture.png"))
-    {
-        std::cout << "Gameplay: Failed to load asset 'end_texture.png'\n";
-        std::exit(1);
-    }
-    if (!player.texturePtr->loadFromFile("../assets/player.png"))
-    {
-        std::cout << "Gameplay: Failed to load asset 'player.png'\n";
-        std::exit(1);
-    }
-    if (!deathScreenTexture->loadFromFile("../assets/death_background.png"))
-    {
-        std::cout << "Gameplay: Failed to load asset 'death_background.png'\n";
-        std::exit(1);
-    }
-    if (!hardModeTexture->loadFromFile("../assets/hard_mode_background.png"))
-    {
-        std::cout << "Gameplay: Failed to load asset 'hard_mode_background.png'\n";
-        std::exit(1);
-    }
-    if (!pausedScreenTexture->loadFromFile("../assets/paused_screen_background.png"))
-    {
-        std::cout << "Gameplay: Failed to load asset 'paused_screen_background.png'\n";
-        std::exit(1);
-    }
-    if (!settingsScreenTexture->loadFromFile("../assets/settings_screen_background.png"))
+    // the files are decoded in parallel, see Section::loadTextures()
+    const char* failed = loadTextures({{vectorOfTextures[0].get(), "blue_floor_texture.png"},
+                                       {vectorOfTextures[1].get(), "blue_floor_trapped_texture.png"},
+                                       {vectorOfTextures[2].get(), "blue_floor_fire_texture.png"},
+                                       {vectorOfTextures[3].get(), "death_texture.png"},
+                                       {vectorOfTextures[4].get(), "wall_texture.png"},
+                                       {vectorOfTextures[5].get(), "alien_texture.png"},
+                                       {vectorOfTextures[6].get(), "start_texture.png"},
+                                       {vectorOfTextures[7].get(), "end_texture.png"},
+                                       {player.texturePtr.get(), "player.png"},
+                                       {deathScreenTexture.get(), "death_background.png"},
+                                       {hardModeTexture.get(), "hard_mode_background.png"},
+                                       {pausedScreenTexture.get(), "paused_screen_background.png"},
+                                       {settingsScreenTexture.get(), "settings_screen_background.png"},
+                                       {winScreenTexture.get(), "win_background.png"}});
+    if (failed)
     {
-        std::cout << "Gameplay: Failed to load asset 'settings_screen_background.png'\n";
+        std::cout << "Gameplay: Failed to load asset '" << failed << "'\n";
         std::exit(1);
     }
-    if (!winScreenTexture->loadFromFile("../assets/win_background.png"))
+    std::size_t textureBytes = MemoryTracker::textureBytes(*player.texturePtr) + MemoryTracker::textureBytes(*deathScreenTexture)
+                             + MemoryTracker::textureBytes(*hardModeTexture) + MemoryTracker::textureBytes(*pausedScreenTexture)
+                             + MemoryTracker::textureBytes(*settingsScreenTexture) + MemoryTracker::textureBytes(*winScreenTexture);
+    for (const std::unique_ptr<sf::Texture>& texture : vectorOfTextures)
     {
-        std::cout << "Gameplay: Failed to load asset 'win_background.png'\n";
-        std::exit(1);
+        textureBytes += MemoryTracker::textureBytes(*texture);
     }
+    m_textureMemory.set(textureBytes);
     loadSound();
 
     player.sprite.setTexture(*player.texturePtr);
@@ -208,26 +255,35 @@ void Gameplay::load()
     winScreenSprite.setTexture(*winScreenTexture);
     winScreenSprite.setScale(m_width / winScreenSprite.getLocalBounds().width, m_height / winScreenSprite.getLocalBounds().height);
 
-    populateGrid();
+    // box drawn around the chosen settings
+    m_settingRect.setSize(sf::Vector2f(m_width * 0.09, m_height * 0.05));
+    m_settingRect.setFillColor(sf::Color(0, 0, 0, 0));
+    m_settingRect.setOutlineColor(sf::Color(255, 255, 255));
+    m_settingRect.setOutlineThickness(2);
+
+    m_tileSprites.resize(vectorOfTextures.size());
+    for (unsigned int i=0; i < m_tileSprites.size(); ++i)
+    {
+        m_tileSprites[i].setTexture(*vectorOfTextures[i]);
+        m_tileSprites[i].setScale(squareSize / TEXTURE_SIZE, squareSize / TEXTURE_SIZE);
+    }
 }
 
 
 /**
  * @brief Rotates the player sprite to look towards where the mouse is
  * @details changes the absolute rotation of the player sprite so it looks where
- *          the mouse currently is. This is called every frame in Gamplay::update().
+ *          the mouse currently is. This is called every tick in Gameplay::tick(),
+ *          with the mouse position the render thread last stored.
  * 
- * @throw SFML exceptions may be thrown during fatal errors.
+ * @throw None
  * @param None
  * @return None
  */
 void Gameplay::rotatePlayerToMouse()
 {
     const double pi = 3.14159265358979323846;
-    sf::Vector2i mouseCoordsInt = sf::Mouse::getPosition(*m_window);
-    sf::Vector2f mouseCoords(mouseCoordsInt.x, mouseCoordsInt.y);
-    mouseCoords.x /= m_window->getSize().x / m_width; 
-    mouseCoords.y /= m_window->getSize().y / m_height; 
+    sf::Vector2f mouseCoords = m_mouse.load(std::memory_order_relaxed);
     float rotation = std::atan2(mouseCoords.x - player.x,
                                 mouseCoords.y - player.y);
     player.sprite.setRotation(rotation*-180/pi);
@@ -236,61 +292,98 @@ void Gameplay::rotatePlayerToMouse()
 
 /**
  * @brief Updates all gameplay variables based on events that occur.
- * @details Handles checking for death, applying of damage, calculating new
- * player posistions, and other graphical updates. This function is called from
- * a master update() function in the Game class. This function is virtual and 
- * overrides the parent Section update() function.
- * @throw SFML exceptions may be thrown during fatal errors.
+ * @details Changes to the level file are swapped in first, so a tick never
+ * sees half of them. On the game screen, the simulation thread is started if
+ * it is not running, and the newest state it published is taken to be drawn.
+ * This function is called from a master update() function in the Game class.
+ * This function is virtual and overrides the parent Section update()
+ * function.
+ * @throw std::system_error if the simulation thread cannot be started.
  * @param None
  * @return None
  */
 void Gameplay::update()
 {
+    reloadLevel();
     if (m_screenName == "game_screen")
     {
-        rotatePlayerToMouse();
-        calculatePlayerVelocity();
-        calculateCollision();
-
-        if (playerWon())
+        if (!m_simulation.joinable())
         {
-            player.status = Player::Won;
+            startSimulation();
         }
+        takeState();
+    }
+}
 
 
-        m_squareToMoveTo.move(player.velocity.x, player.velocity.y);
-
-        std::optional<GameObject> blockMouseOn = blockMouseIsOn();
+/**
+ * @brief Advances the game by one frame.
+ * @details Handles the clicks sent by the render thread, checking for death,
+ * applying of damage, calculating new player posistions, and the lighting.
+ * Only ever runs on the simulation thread, or with it stopped. The state is
+ * captured at the end, along with where the screen and the player were
+ * before, so the render thread can interpolate between the two.
+ * @throw std::bad_alloc if the changed tiles outgrow their vector.
+ * @param None
+ * @return None
+ */
+void Gameplay::tick()
+{
+    sf::Vector2f previousScroll = scroll();
+    float previousRotation = player.sprite.getRotation();
 
-        if (blockMouseOn)
-        {
-            m_highlightedGridRect.setPosition((blockMouseOn->arrIndexX - upperLeftSquare.x)*squareSize + gridOffset.x,
-                                            (blockMouseOn->arrIndexY - upperLeftSquare.y)*squareSize + gridOffset.y);
-                                            
-        }
-        if (gridOffset.x >= squareSize)
-        {
-            gridOffset.x -= squareSize;
-            --upperLeftSquare.x;
-        }
-        if (gridOffset.x <= -1*squareSize)
-        {
-            gridOffset.x += squareSize;
-            ++upperLeftSquare.x;
-        }
-        if (gridOffset.y >= squareSize)
-        {
-            gridOffset.y -= squareSize;
-            --upperLeftSquare.y;
-        }
-        if (gridOffset.y <= -1*squareSize)
+    sf::Event event;
+    while (m_simulationInput.pop(event))
+    {
+        if (player.status == Player::Alive)
         {
-            gridOffset.y += squareSize;
-            ++upperLeftSquare.y;
+            std::optional<GameObject> blockMouseOn = blockMouseIsOn();
+            if (blockMouseOn)
+            {
+                m_moveTarget = indexToCoord(blockMouseOn->arrIndexX, blockMouseOn->arrIndexY);
+            }
         }
-        gridOffset.x += player.velocity.x;
-        gridOffset.y += player.velocity.y;
     }
+
+    rotatePlayerToMouse();
+    calculatePlayerVelocity();
+    calculateCollision();
+
+    if (playerWon())
+    {
+        player.status = Player::Won;
+    }
+
+
+    m_moveTarget += player.velocity;
+
+    if (gridOffset.x >= squareSize)
+    {
+        gridOffset.x -= squareSize;
+        --upperLeftSquare.x;
+    }
+    if (gridOffset.x <= -1*squareSize)
+    {
+        gridOffset.x += squareSize;
+        ++upperLeftSquare.x;
+    }
+    if (gridOffset.y >= squareSize)
+    {
+        gridOffset.y -= squareSize;
+        --upperLeftSquare.y;
+    }
+    if (gridOffset.y <= -1*squareSize)
+    {
+        gridOffset.y += squareSize;
+        ++upperLeftSquare.y;
+    }
+    gridOffset.x += player.velocity.x;
+    gridOffset.y += player.velocity.y;
+
+    updateVisibility();
+    captureState(m_simState);
+    m_simState.previousScroll = previousScroll;
+    m_simState.previousRotation = previousRotation;
 }
 
 
@@ -309,8 +402,9 @@ void Gameplay::handleInput()
 {
     if (m_screenName == "game_screen")
     {
+        m_mouse.store(mouseInView(), std::memory_order_relaxed);
         sf::Event event;
-        while(m_window->pollEvent(event))
+        while(pollEvent(event))
         {
             if (event.type == sf::Event::Closed)
             {
@@ -318,23 +412,20 @@ void Gameplay::handleInput()
             }
             else if (event.type == sf::Event::LostFocus)
             {
+                stopSimulation();
                 m_screenName = "paused_screen";
             }
             else if (event.type == sf::Event::MouseButtonPressed)
             {
                 if (event.mouseButton.button == sf::Mouse::Left)
                 {
-                    if (player.status == Player::Alive)
+                    if (m_shownState.status == Player::Alive)
                     {
-                        std::optional<GameObject> blockMouseOn = blockMouseIsOn();
-                        if (blockMouseOn)
-                        {
-                            m_squareToMoveTo.setPosition((blockMouseOn->arrIndexX - upperLeftSquare.x) * squareSize + gridOffset.x,
-                                                        (blockMouseOn->arrIndexY - upperLeftSquare.y) * squareSize + gridOffset.y);
-                        }
+                        m_simulationInput.push(event); // the simulation picks the tile under the mouse
                     }
-                    else if (player.status == Player::Dead || player.status == Player::Won)
+                    else if (m_shownState.status == Player::Dead || m_shownState.status == Player::Won)
                     {
+                        stopSimulation();
                         resetLevel();
                     }
                 }
@@ -343,8 +434,13 @@ void Gameplay::handleInput()
             {
                 if (event.key.code == sf::Keyboard::Escape)
                 {
+                    stopSimulation();
                     m_screenName = "paused_screen";
                 }
+                else if (event.key.code == sf::Keyboard::P && m_exitSection == SectionName::MazeBuilder)
+                {
+                    m_sectionName = m_exitSection; // back to editing the playtested level
+                }
             }
         }
     }
@@ -361,9 +457,13 @@ void Gameplay::handleInput()
 
 /**
  * @brief Displays all Gameplay assets to the screen.
- * @details The player sprite, grid textures, and overlays are displayed. This
- * function is called from a master render() function in the Game class.
- * This function is virtual and overrides the parent Section load() function.
+ * @details The player sprite, grid textures, and overlays are displayed. The
+ * game screen is drawn from the newest state the simulation published,
+ * interpolated between its previous tick and its last one by how far into
+ * the next tick the frame is, so scrolling stays smooth whenever frames and
+ * ticks do not line up. This function is called from a master render()
+ * function in the Game class. This function is virtual and overrides the
+ * parent Section load() function.
  * @throw SFML exceptions may be thrown during fatal errors.
  * @param None
  * @return None
@@ -372,43 +472,62 @@ void Gameplay::render()
 {
     if (m_screenName == "game_screen")
     {
-        renderGrid();
-        if (player.status == Player::Alive)
+        const GameplayState& state = m_shownState;
+        float alpha = std::chrono::duration<float>(std::chrono::steady_clock::now() - state.time).count() * m_settings->frameRate;
+        alpha = std::clamp(alpha, 0.0f, 1.0f);
+        sf::Vector2f scroll = state.previousScroll + (state.scroll - state.previousScroll) * alpha;
+        renderGrid(*m_window, scroll);
+
+        // The mask is built relative to its origin tile, so only its offset changes as the grid scrolls
+        if (state.darknessMask.getVertexCount() != 0)
+        {
+            sf::RenderStates maskStates;
+            maskStates.transform.translate(state.maskOrigin.x * squareSize - scroll.x, state.maskOrigin.y * squareSize - scroll.y);
+            draw(state.darknessMask, maskStates);
+        }
+
+        if (state.status == Player::Alive)
         {
-            if (m_squareToMoveTo.getPosition().x != -1)
+            if (state.moveTarget)
             {
-                m_window->draw(m_squareToMoveTo);
+                m_squareToMoveTo.setPosition(*state.moveTarget - scroll);
+                draw(m_squareToMoveTo);
             }
-            if (blockMouseIsOn())
+            if (state.highlighted)
             {
-                m_window->draw(m_highlightedGridRect);
+                m_highlightedGridRect.setPosition(state.highlighted->x * squareSize - scroll.x, state.highlighted->y * squareSize - scroll.y);
+                draw(m_highlightedGridRect);
             }
-            m_window->draw(player.sprite);
+            // turns the shorter way round when the angle wraps
+            m_playerSprite.setRotation(state.previousRotation + std::remainder(state.rotation - state.previousRotation, 360.0f) * alpha);
+            draw(m_playerSprite);
             if (m_settings->difficulty == 0)
             {
                 displayHealth();
             }
             else
             {
-                m_window->draw(hardModeSprite);
+                draw(hardModeSprite);
             }
+            displayMinimap(sf::Vector2i(std::floor((m_playerSprite.getPosition().x + scroll.x) / squareSize),
+                                        std::floor((m_playerSprite.getPosition().y + scroll.y) / squareSize)));
         }
-        else if (player.status == Player::Dead)
+        else if (state.status == Player::Dead)
         {
-            m_window->draw(deathScreenSprite);
+            draw(deathScreenSprite);
         }
-        else if (player.status == Player::Won)
+        else if (state.status == Player::Won)
         {
-            m_window->draw(winScreenSprite);
+            draw(winScreenSprite);
         }
     }
     else if (m_screenName == "paused_screen")
     {
-        m_window->draw(pausedScreenSprite);
+        draw(pausedScreenSprite);
     }
     else if (m_screenName == "settings_screen")
     {
-        m_window->draw(settingsScreenSprite);
+        draw(settingsScreenSprite);
         renderSettingsScreen();
     }
 }
@@ -425,9 +544,9 @@ void Gameplay::render()
  */
 void Gameplay::displayHealth()
 {
-    healthBar.setSize(sf::Vector2f((player.healthPercent * 0.15) / 100 * m_width, 0.01 * m_height));
-    m_window->draw(healthBarBg);
-    m_window->draw(healthBar);
+    healthBar.setSize(sf::Vector2f((m_shownState.healthPercent * 0.15) / 100 * m_width, 0.01 * m_height));
+    draw(healthBarBg);
+    draw(healthBar);
 }
 
 
@@ -443,7 +562,7 @@ void Gameplay::displayHealth()
  */
 void Gameplay::calculateCollision()
 {
-    std::vector<GameObject> objectsStandingOn = blocksPlayerIsOn();
+    FrameVector<GameObject> objectsStandingOn = blocksPlayerIsOn();
     for (int i = 0; i < objectsStandingOn.size(); ++i)
     {
         // If the texture is a trap
@@ -451,8 +570,9 @@ void Gameplay::calculateCollision()
         {
             player.healthPercent -= 40;
             // The trap has been set off, so reset the square to be a path with no trap.
-            m_maze[objectsStandingOn[i].arrIndexX][objectsStandingOn[i].arrIndexY].textureIndex = 0;
-            m_maze[objectsStandingOn[i].arrIndexX][objectsStandingOn[i].arrIndexY].sprite.setTexture(*vectorOfTextures[0]);
+            m_grid.set(objectsStandingOn[i].arrIndexX, objectsStandingOn[i].arrIndexY, 0);
+            m_simState.changedTiles.push_back({sf::Vector2i(objectsStandingOn[i].arrIndexX, objectsStandingOn[i].arrIndexY), 0});
+            m_simState.revealed.push_back(sf::Vector2i(objectsStandingOn[i].arrIndexX, objectsStandingOn[i].arrIndexY));
         }
         // Else if the texture is fire
         else if (objectsStandingOn[i].textureIndex == 2) // player standing on fire
@@ -533,60 +653,27 @@ void Gameplay::calculateCollision()
 
 
 /**
- * @brief Creates a 2d vector of GameObjects for the maze from a given file
- * @details Opens a fstream object with member variable fileName as the file name.
- * It reads in the grid size, and then uses a nested for loop to loop through
- * all grid squares. It assigns correct textures, indexes, scales, and walkable bools
- * to each square. If the current square is a starting block (red texture),
- * then startingBlock.x and y are set to the current square. It closes the file
- * after it is done.
- * @throw None
+ * @brief Sets up the playing grid and the tiles that block light from the level.
+ * @details The playing grid and the grid the render thread draws are copies
+ * of m_level that share its tiles, so nothing is copied unless the level has
+ * traps, see startSimulation(). Walls never change while playing, so the
+ * tiles that block light only have to be set once.
+ * @throw std::bad_alloc if the opacity map cannot be allocated.
  * @param None
  * @return None
  */
 void Gameplay::populateGrid()
 {
-    std::fstream file(fileName, std::ios::in);
-    file >> GRID_SIZE;
-    for (int x = 0; x < GRID_SIZE; ++x)
+    PROFILE_ZONE("Gameplay::populateGrid");
+    GRID_SIZE = m_level.size();
+    m_grid = m_level;
+    m_shownGrid = m_level;
+    m_visibility.setSize(GRID_SIZE);
+    for (unsigned int x = 0; x < GRID_SIZE; ++x)
     {
-        m_maze.push_back(std::vector<GameObject>()); // creates another row
-        for (int y = 0; y < GRID_SIZE; ++y)
+        for (unsigned int y = 0; y < GRID_SIZE; ++y)
         {
-            m_maze[x].push_back(GameObject());
-            m_maze[x][y].arrIndexX = x;
-            m_maze[x][y].arrIndexY = y;
-            m_maze[x][y].sprite.setScale(squareSize / TEXTURE_SIZE, squareSize / TEXTURE_SIZE);
-            file >> m_maze[x][y].textureIndex;
-
-            m_maze[x][y].sprite.setTexture(*vectorOfTextures[m_maze[x][y].textureIndex]);
-
-            switch (m_maze[x][y].textureIndex)
-            {
-                case 1:     // If the texture is a trap
-                    m_maze[x][y].walkable = 1;
-                    break;
-                case 2:     // If the texture is fire
-                    m_maze[x][y].walkable = 1;
-                    break;
-                case 3:     // If the texture is a bloodied path
-                    m_maze[x][y].walkable = 1;
-                    break;
-                case 4:     // Ff the texture ise a stone wall
-                    m_maze[x][y].walkable = 0;
-                    break;
-                case 5:     // If the texture is diseased path
-                    m_maze[x][y].walkable = 1;
-                    break;
-                case 6:     // If the texture is maze start
-                    m_maze[x][y].walkable = 1;
-                    startingBlock.x = m_maze[x][y].arrIndexX;
-                    startingBlock.y = m_maze[x][y].arrIndexY;
-                    break;
-                case 7:     // If the texture is maze end
-                    m_maze[x][y].walkable = 1;
-                    break;
-            };
+            m_visibility.setOpaque(x, y, m_level.get(x, y) == TileGrid::WALL);
         }
     }
 }
@@ -595,31 +682,52 @@ void Gameplay::populateGrid()
 /**
  * @brief Renders the maze, including a layer of blocks the user cannot see around the screen
  * @details Loops through upper left corner of the maze - 1 (so when the offset is reached, the square is rendered)
- * to the bottom right (+1 so when the offset is reached, the square is rendered)
- * The offset is added to the coordinates, so the grid moves if the player velocity is nonzero.
- * sets the sprite of the gameObject to the correct coordinate position, and draws it to the screen
+ * to the bottom right (+1 so when the offset is reached, the square is rendered), skipping
+ * anything outside of the grid. The offset is added to the coordinates, so the grid moves if
+ * the player velocity is nonzero. Every tile is drawn with the shared sprite of its type.
+ * The tiles come from m_shownGrid, so the simulation can keep changing the grid.
  * @throw None
- * @param None
+ * @param target - what to draw the tiles on, normally the window.
+ * @param scroll - the world position of the top left corner of the screen.
  * @return None
  */
-void Gameplay::renderGrid()
+void Gameplay::renderGrid(sf::RenderTarget& target, sf::Vector2f scroll)
 {
-
-    for (int arr_x = upperLeftSquare.x - 1; arr_x < (upperLeftSquare.x + objectsToDisplay) + 2; ++arr_x)
+    PROFILE_ZONE("Gameplay::renderGrid");
+    int size = m_shownGrid.size();
+    sf::Vector2i upperLeft(std::floor(scroll.x / squareSize), std::floor(scroll.y / squareSize));
+    for (int arr_x = std::max(upperLeft.x - 1, 0); arr_x < std::min<int>(upperLeft.x + objectsToDisplay + 2, size); ++arr_x)
     {
-        for (int arr_y = upperLeftSquare.y - 1; arr_y < (upperLeftSquare.y + objectsToDisplay) + 2; ++arr_y)
+        for (int arr_y = std::max(upperLeft.y - 1, 0); arr_y < std::min<int>(upperLeft.y + objectsToDisplay + 2, size); ++arr_y)
         {
-            float x_coords = ((m_maze[arr_x][arr_y].arrIndexX - upperLeftSquare.x + 2) * squareSize) - 2*squareSize;
-            float y_coords = ((m_maze[arr_x][arr_y].arrIndexY - upperLeftSquare.y + 2) * squareSize) - 2*squareSize;
-            x_coords += gridOffset.x;
-            y_coords += gridOffset.y;
-            m_maze[arr_x][arr_y].sprite.setPosition(x_coords, y_coords);
-            m_window->draw(m_maze[arr_x][arr_y].sprite);
+            float x_coords = arr_x * squareSize - scroll.x;
+            float y_coords = arr_y * squareSize - scroll.y;
+            sf::Sprite& sprite = m_tileSprites[m_shownGrid.get(arr_x, arr_y)];
+            sprite.setPosition(x_coords, y_coords);
+            FrameStats::draw(target, sprite);
         }
     }
 }
 
 
+/**
+ * @brief Returns the grid data of a single tile.
+ * @throw None
+ * @param x - the x index of the tile. It must be inside the grid.
+ * @param y - the y index of the tile. It must be inside the grid.
+ * @return GameObject - the indices, type and walkability of the tile
+ */
+GameObject Gameplay::tileAt(unsigned int x, unsigned int y) const
+{
+    GameObject tile;
+    tile.arrIndexX = x;
+    tile.arrIndexY = y;
+    tile.textureIndex = m_grid.get(x, y);
+    tile.walkable = tile.textureIndex != TileGrid::WALL;
+    return tile;
+}
+
+
 /**
  * @brief Returns a boolean indicating whether the player has won.
  * @details Checks the texture the player is standing on to determine if it is
@@ -630,7 +738,7 @@ void Gameplay::renderGrid()
  */
 bool Gameplay::playerWon()
 {
-    std::vector<GameObject> objectsStandingOn = blocksPlayerIsOn();
+    FrameVector<GameObject> objectsStandingOn = blocksPlayerIsOn();
     for (int i = 0; i < objectsStandingOn.size(); ++i)
     {
         if (objectsStandingOn[i].textureIndex == 7)
@@ -645,7 +753,8 @@ bool Gameplay::playerWon()
 /**
  * @brief Resets the level to its original form.
  * @details Player position, all textures, and player variables are all reset
- * to their initial values when the level was first ran.
+ * to their initial values when the level was first ran. The simulation must
+ * be stopped.
  * @throw None
  * @param None
  * @return None
@@ -662,33 +771,106 @@ void Gameplay::resetLevel()
     player.poisonedLength = 0;
     upperLeftSquare.x = startingBlock.x - (objectsToDisplay - 1) / 2.0f;
     upperLeftSquare.y = startingBlock.y - ((objectsToDisplay / m_width) * m_height-1) / 2.0f;
-    m_squareToMoveTo.setPosition(-1, -1);
+    m_moveTarget = sf::Vector2f(-1, -1);
 
     player.healthPercent = 100;
     player.status = Player::Alive;
-    populateGrid();
+    m_grid = m_level; // shares the level's tiles again, so nothing is copied or read from a file
+    m_shownGrid = m_level;
+    buildMinimap(); // triggered traps are back
+    m_visibilityOrigin = sf::Vector2i(-1, -1); // forces the visibility to be recalculated
+}
+
+
+/**
+ * @brief Swaps in the parts of the level file that changed on disk.
+ * @details Only the blocks that changed in the file are copied into the
+ * playing grid, so traps set off elsewhere stay set off. The player keeps
+ * their position, health and status, unless the level shrank out from under
+ * them, in which case the level is reset. Walls may have moved, so the
+ * lighting is always recalculated. The simulation is stopped while the
+ * changes are swapped in, and update() starts it again.
+ * @throw std::bad_alloc if the grid cannot be allocated.
+ * @param None
+ * @return None
+ */
+void Gameplay::reloadLevel()
+{
+    std::optional<LevelWatcher::Reload> reload = m_watcher.takeReload();
+    if (!reload)
+    {
+        return;
+    }
+    stopSimulation();
+
+    m_level = std::move(reload->level);
+    unsigned int startX = 0, startY = 0;
+    if (m_level.find(6, startX, startY))
+    {
+        startingBlock = sf::Vector2i(startX, startY);
+    }
+
+    if (reload->resized)
+    {
+        std::string saveFileName = m_exploration.saveFileName();
+        m_exploration.save();
+        populateGrid();
+        m_exploration.open(saveFileName, fileName, GRID_SIZE); // the old explored tiles no longer fit
+        buildMinimap();
+        sf::Vector2i tile = playerTile();
+        if (tile.x < 0 || tile.y < 0 || tile.x >= static_cast<int>(GRID_SIZE) || tile.y >= static_cast<int>(GRID_SIZE))
+        {
+            resetLevel();
+        }
+    }
+    else
+    {
+        const unsigned int chunk = TileGrid::CHANGE_CHUNK;
+        unsigned int chunksPerSide = (GRID_SIZE + chunk - 1) / chunk;
+        std::vector<unsigned char> types(chunk), oldTypes(chunk);
+        for (std::size_t i = 0; i < reload->changedChunks.size(); ++i)
+        {
+            if (!reload->changedChunks[i])
+            {
+                continue;
+            }
+            unsigned int firstX = (i / chunksPerSide) * chunk;
+            unsigned int firstY = (i % chunksPerSide) * chunk;
+            unsigned int length = std::min(chunk, GRID_SIZE - firstY);
+            for (unsigned int x = firstX; x < std::min(firstX + chunk, GRID_SIZE); ++x)
+            {
+                m_level.readColumn(x, firstY, length, types.data());
+                m_grid.writeColumn(x, firstY, length, types.data(), oldTypes.data());
+                m_shownGrid.writeColumn(x, firstY, length, types.data(), oldTypes.data());
+                for (unsigned int y = firstY; y < firstY + length; ++y)
+                {
+                    m_visibility.setOpaque(x, y, types[y - firstY] == TileGrid::WALL);
+                    if (m_exploration.isExplored(x, y))
+                    {
+                        m_minimap.setPixel(x, y, TileGrid::mapColor(types[y - firstY]));
+                    }
+                }
+            }
+        }
+    }
+    m_visibilityOrigin = sf::Vector2i(-1, -1); // forces the visibility to be recalculated
 }
 
 
 /**
  * @brief Calculates and returns the grid data of the mouse position.
- * @details Using the size of the game window and the coordinates of the mouse,
- * the grid x and y indices of the hovered over square are used to return the
+ * @details Using the mouse position the render thread last stored, the grid
+ * x and y indices of the hovered over square are used to return the
  * GameObject of the grid square.
- * @throw SFML exceptions may be thrown during fatal errors.
+ * @throw None
  * @param None
- * @return m_maze[x][y] - an instance of the GameObject struct.
+ * @return GameObject - the tile under the mouse, or nothing if the mouse is outside of the grid
  */
 std::optional<GameObject> Gameplay::blockMouseIsOn() const
 {
-    // scales the position of the mouse to m_width & m_height, since everything else is in terms of m_width and m_height
-    float mouseX = sf::Mouse::getPosition(*m_window).x;
-    float mouseY = sf::Mouse::getPosition(*m_window).y;
-    mouseX /= m_window->getSize().x;
-    mouseY /= m_window->getSize().y;
-    mouseX *= m_width;
-    mouseY *= m_height;
-
+    sf::Vector2f mouse = m_mouse.load(std::memory_order_relaxed);
+    float mouseX = mouse.x;
+    float mouseY = mouse.y;
 
     int x = ((mouseX - gridOffset.x)/ squareSize) + upperLeftSquare.x;
     int y = ((mouseY - gridOffset.y) / squareSize) + upperLeftSquare.y;
@@ -696,7 +878,7 @@ std::optional<GameObject> Gameplay::blockMouseIsOn() const
     {
         return std::nullopt;
     }
-    return m_maze[x][y];
+    return tileAt(x, y);
 }
 
 
@@ -722,48 +904,49 @@ sf::Vector2f Gameplay::indexToCoord(unsigned int x, unsigned int y) const
  * It then checks if the block to the immediate left of the player is out of bounds. If it is not,
  * it sees whether or not the player is partially inside it. If it is, it pushes the GameObject to the 
  * end of the vector. The same process for the left side is repeated for the top, bottom, and right
- * side.
+ * side. The vector is allocated from the FrameArena, so it must not be kept past the frame.
  * @throw None
  * @param None
- * @return std::vector<GameObject> - a vector of GameObjects the player is currenty on
+ * @return FrameVector<GameObject> - a vector of GameObjects the player is currenty on
  */
-std::vector<GameObject> Gameplay::blocksPlayerIsOn() const
+FrameVector<GameObject> Gameplay::blocksPlayerIsOn() const
 {
-    std::vector<GameObject> blocks;
+    FrameVector<GameObject> blocks;
+    blocks.reserve(5);
     unsigned int x = ((player.x - gridOffset.x) / squareSize) + upperLeftSquare.x; // dont calculate offset
     unsigned int y = ((player.y - gridOffset.y) / squareSize) + upperLeftSquare.y;
 
     if (!(x >= GRID_SIZE || x < 0 || y >= GRID_SIZE || y < 0)) // if block center is on not out of bounds
     {
-        blocks.push_back(m_maze[x][y]);
+        blocks.push_back(tileAt(x, y));
     }
 
     if (!(x-1 >= GRID_SIZE || x-1 < 0 || y >= GRID_SIZE || y < 0)) // if block to left not out of bounds
     { 
         if (player.x - 0.5*player.sprite.getGlobalBounds().width < indexToCoord(x-1, y).x + squareSize) // if player on it
         {
-            blocks.push_back(m_maze[x-1][y]);
+            blocks.push_back(tileAt(x-1, y));
         }
     }
     if (!(x+1 >= GRID_SIZE || x+1 < 0 || y >= GRID_SIZE || y < 0)) // if block to right not out of bounds
     {
         if (player.x + 0.5*player.sprite.getGlobalBounds().width > indexToCoord(x+1, y).x) // if player on it
         {
-            blocks.push_back(m_maze[x+1][y]);
+            blocks.push_back(tileAt(x+1, y));
         }
     }
     if (!(x >= GRID_SIZE || x < 0 || y-1 >= GRID_SIZE || y-1 < 0)) // if block below not out of bounds
     {
         if (player.y - 0.5*player.sprite.getGlobalBounds().height < indexToCoord(x, y).y) // if player on it
         {
-            blocks.push_back(m_maze[x][y-1]);
+            blocks.push_back(tileAt(x, y-1));
         }
     }
     if (!(x >= GRID_SIZE || x < 0 || y+1 >= GRID_SIZE || y+1 < 0)) // if block above not out of bounds
     {
         if (player.y + 0.5 * player.sprite.getGlobalBounds().height > indexToCoord(x, y+1).y) // if player on it
         {
-            blocks.push_back(m_maze[x][y+1]);
+            blocks.push_back(tileAt(x, y+1));
         }
     }
     return blocks;
@@ -774,7 +957,8 @@ std::vector<GameObject> Gameplay::blocksPlayerIsOn() const
  * @brief Deals with input for the ingame settings (when Escape is pressed).
  * @details Deals with input for ingame settings. When Mouse Left is clicked on 
  * specific areas of the screen, the Back to Game button  launches the user into the game again.
- * The Main Menu button launches the user into the title screen, and the settings button launches the user
+ * The Main Menu button launches the user into the title screen (or back to the MazeBuilder while
+ * playtesting), and the settings button launches the user
  * into the settings page.
  * @throw None
  * @param None
@@ -785,7 +969,7 @@ void Gameplay::pausedScreenInput()
     float width = m_window->getSize().x;
     float height = m_window->getSize().y;
     sf::Event event;
-    while(m_window->pollEvent(event))
+    while(pollEvent(event))
     {
         if (event.type == sf::Event::Closed)
         {
@@ -810,7 +994,7 @@ void Gameplay::pausedScreenInput()
                     {
                         // std::cout << "Gameplay: 'Main Menu' button pressed\n";
                         playClicked();
-                        m_sectionName = SectionName::Menu;
+                        m_sectionName = m_exitSection;
                     }
                     else if (event.mouseButton.y >= height * 0.45 &&
                              event.mouseButton.y <= height * 0.50)
@@ -848,7 +1032,7 @@ void Gameplay::settingsScreenInput()
     sf::Event event;
     float width = m_window->getSize().x;
     float height = m_window->getSize().y;
-    while(m_window->pollEvent(event))
+    while(pollEvent(event))
     {
         if (event.type == sf::Event::Closed) // if user clicks top right x in window
         {
@@ -889,7 +1073,6 @@ void Gameplay::settingsScreenInput()
                     {
                         // Gameplay: FPS '30' button pressed
                         m_settings->frameRate = 30;
-                        m_window->setFramerateLimit(m_settings->frameRate);
                     }
                     else if (event.mouseButton.y >= height * 0.65 &&
                              event.mouseButton.y <= height * 0.70)
@@ -929,7 +1112,6 @@ void Gameplay::settingsScreenInput()
                     {
                         // Gameplay: FPS '60' button pressed
                         m_settings->frameRate = 60;
-                        m_window->setFramerateLimit(m_settings->frameRate);
                     }
                     else if (event.mouseButton.y >= height * 0.65 &&
                              event.mouseButton.y <= height * 0.70)
@@ -947,7 +1129,6 @@ void Gameplay::settingsScreenInput()
                     {
                         // Gameplay: FPS '120' button pressed
                         m_settings->frameRate = 120;
-                        m_window->setFramerateLimit(m_settings->frameRate);
                     }
                 }
                 else if (event.mouseButton.x >= width * 0.10 &&
@@ -978,7 +1159,7 @@ void Gameplay::settingsScreenInput()
 
 /**
  * @brief Renders in game settings screen.
- * @details Creates a rectangle and displays it on each setting, if that setting is True.
+ * @details Moves the setting rectangle to each setting, if that setting is True, and displays it.
  * This creates the box around each setting, so the user knows which one is selected.
  * renderSettingsScreen() does not render the settings background.
  * @throw None
@@ -987,75 +1168,71 @@ void Gameplay::settingsScreenInput()
  */
 void Gameplay::renderSettingsScreen()
 {
-    sf::RectangleShape rectangle(sf::Vector2f(m_width * 0.09, m_height * 0.05));
-    rectangle.setFillColor(sf::Color(0, 0, 0, 0));
-    rectangle.setOutlineColor(sf::Color(255, 255, 255));
-    rectangle.setOutlineThickness(2);
     if (m_settings->playMusic)
     {
-        rectangle.setPosition(m_width * 0.3, m_height * 0.25);
-        m_window->draw(rectangle);
+        m_settingRect.setPosition(m_width * 0.3, m_height * 0.25);
+        draw(m_settingRect);
     }
     else
     {
-        rectangle.setPosition(m_width * 0.4, m_height * 0.25);
-        m_window->draw(rectangle);
+        m_settingRect.setPosition(m_width * 0.4, m_height * 0.25);
+        draw(m_settingRect);
     }
 
     if (m_settings->playAudio)
     {
-        rectangle.setPosition(m_width * 0.3, m_height * 0.35);
-        m_window->draw(rectangle);
+        m_settingRect.setPosition(m_width * 0.3, m_height * 0.35);
+        draw(m_settingRect);
     }
     else
     {
-        rectangle.setPosition(m_width * 0.4, m_height * 0.35);
-        m_window->draw(rectangle);
+        m_settingRect.setPosition(m_width * 0.4, m_height * 0.35);
+        draw(m_settingRect);
     }
 
     if (m_settings->difficulty)
     {
-        rectangle.setPosition(m_width * 0.4, m_height * 0.45);
-        m_window->draw(rectangle);
+        m_settingRect.setPosition(m_width * 0.4, m_height * 0.45);
+        draw(m_settingRect);
     }
     else
     {
-        rectangle.setPosition(m_width * 0.3, m_height * 0.45);
-        m_window->draw(rectangle);
+        m_settingRect.setPosition(m_width * 0.3, m_height * 0.45);
+        draw(m_settingRect);
     }
 
     if (m_settings->frameRate == 30)
     {
-        rectangle.setPosition(m_width * 0.3, m_height * 0.55);
-        m_window->draw(rectangle);
+        m_settingRect.setPosition(m_width * 0.3, m_height * 0.55);
+        draw(m_settingRect);
     }
     else if (m_settings->frameRate == 60)
     {
-        rectangle.setPosition(m_width * 0.4, m_height * 0.55);
-        m_window->draw(rectangle);
+        m_settingRect.setPosition(m_width * 0.4, m_height * 0.55);
+        draw(m_settingRect);
     }
     else if (m_settings->frameRate == 120)
     {
-        rectangle.setPosition(m_width * 0.5, m_height * 0.55);
-        m_window->draw(rectangle);
+        m_settingRect.setPosition(m_width * 0.5, m_height * 0.55);
+        draw(m_settingRect);
     }
 
     if (m_settings->showFps)
     {
-        rectangle.setPosition(m_width * 0.3, m_height * 0.65);
-        m_window->draw(rectangle);
+        m_settingRect.setPosition(m_width * 0.3, m_height * 0.65);
+        draw(m_settingRect);
     }
     else
     {
-        rectangle.setPosition(m_width * 0.4, m_height * 0.65);
-        m_window->draw(rectangle);
+        m_settingRect.setPosition(m_width * 0.4, m_height * 0.65);
+        draw(m_settingRect);
     }
 }
 
 
 /**
- * @brief Calculates the player velocity based on the distance to the selected square (m_squareToMoveTo).
- * @details Calculates the distance on the x axis  and the y axis etween the player coordinates and m_squareToMoveTo.
+ * @brief Calculates the player velocity based on the distance to the selected square (m_moveTarget).
+ * @details Calculates the distance on the x axis  and the y axis etween the player coordinates and m_moveTarget.
  * The absolute value of each x_distance and y_distance are added together to form total_distance.
  * If there is no selected square, or the total_distance is very negligable, then the
  * velocity is 0 for both x and y. Otherwise, the x velocity is (-75*x_distance/total_distance) / frameRate,
@@ -1066,12 +1243,12 @@ void Gameplay::renderSettingsScreen()
  */
 void Gameplay::calculatePlayerVelocity()
 {
-    float x_distance = m_squareToMoveTo.getPosition().x + 0.5 * squareSize - player.x;
-    float y_distance = m_squareToMoveTo.getPosition().y + 0.5 * squareSize - player.y;
+    float x_distance = m_moveTarget.x + 0.5 * squareSize - player.x;
+    float y_distance = m_moveTarget.y + 0.5 * squareSize - player.y;
     float total_distance = std::abs(x_distance) + std::abs(y_distance);
     
     // if no selected square or total_distanace is very negligable (keeps it from bouncing around square)
-    if (m_squareToMoveTo.getPosition().x == -1 || total_distance < 5)
+    if (m_moveTarget.x == -1 || total_distance < 5)
     {
         player.velocity.x = 0;
         player.velocity.y = 0;
@@ -1093,6 +1270,7 @@ void Gameplay::calculatePlayerVelocity()
  */
 void Gameplay::updateSettingsStruct()
 {
+    PROFILE_ZONE("Gameplay::updateSettingsStruct");
     std::fstream file("../user_data/settings.csv", std::ios::out);
     file << "PLAY_MUSIC, " << m_settings->playMusic << '\n';
     file << "PLAY_AUDIO, " << m_settings->playAudio << '\n';
@@ -1102,6 +1280,433 @@ void Gameplay::updateSettingsStruct()
     file << "SAVESLOT_1, " << m_settings->saveSlot1 << '\n';
     file << "SAVESLOT_2, " << m_settings->saveSlot2 << '\n';
     file << "SAVESLOT_3, " << m_settings->saveSlot3 << '\n';
-    m_window->setFramerateLimit(m_settings->frameRate);
 }
 
+
+
+/**
+ * @brief Returns the grid indices of the tile the center of the player is on.
+ * @details Uses the same conversion from pixels to indices as
+ * blocksPlayerIsOn().
+ * @throw None
+ * @param None
+ * @return sf::Vector2i - the x and y indices of the player's tile
+ */
+sf::Vector2i Gameplay::playerTile() const
+{
+    return sf::Vector2i(((player.x - gridOffset.x) / squareSize) + upperLeftSquare.x,
+                        ((player.y - gridOffset.y) / squareSize) + upperLeftSquare.y);
+}
+
+
+/**
+ * @brief Recalculates the lit tiles when the player moves onto a new tile.
+ * @details Shadowcasting only depends on the player's tile, so nothing is
+ * recalculated while the player moves within a single tile. The light radius
+ * is smaller on hard difficulty.
+ * @throw None
+ * @param None
+ * @return None
+ */
+void Gameplay::updateVisibility()
+{
+    sf::Vector2i tile = playerTile();
+    if (tile == m_visibilityOrigin)
+    {
+        return;
+    }
+    m_visibilityOrigin = tile;
+
+    int radius = (m_settings->difficulty == 0) ? EASY_LIGHT_RADIUS : HARD_LIGHT_RADIUS;
+    m_visibility.compute(tile.x, tile.y, radius);
+    m_exploration.markVisible(m_visibility);
+    revealOnMinimap();
+    buildDarknessMask();
+}
+
+
+/**
+ * @brief Rebuilds the vertex array drawn over tiles the player cannot see.
+ * @details Covers every tile that renderGrid() can draw with a single quad.
+ * Tiles that have never been seen are fully black, tiles that were explored
+ * before are dimmed, and visible tiles fade to black towards the edge of the
+ * light radius. Vertex positions are relative to
+ * m_maskOrigin so that the mask can be scrolled with a transform in render().
+ * The array is refilled in place, so it only allocates the first time; the
+ * states get a copy of it in captureState().
+ * @throw std::bad_alloc if the vertex array cannot be allocated.
+ * @param None
+ * @return None
+ */
+void Gameplay::buildDarknessMask()
+{
+    static const int corners[4][2] = {{0, 0}, {1, 0}, {1, 1}, {0, 1}};
+    const int maskRadius = objectsToDisplay;
+    const int side = 2 * maskRadius + 1;
+    const float lightRadius = m_visibility.radius() + 0.5f;
+
+    m_maskOrigin = sf::Vector2i(m_visibilityOrigin.x - maskRadius, m_visibilityOrigin.y - maskRadius);
+    m_darknessMask.setPrimitiveType(sf::Quads);
+    m_darknessMask.resize(side * side * 4);
+
+    std::size_t vertex = 0;
+    for (int y = 0; y < side; ++y)
+    {
+        for (int x = 0; x < side; ++x)
+        {
+            int tileX = m_maskOrigin.x + x;
+            int tileY = m_maskOrigin.y + y;
+            bool visible = m_visibility.isVisible(tileX, tileY);
+            sf::Uint8 darkness = m_exploration.isExplored(tileX, tileY) ? EXPLORED_DARKNESS : 255;
+            for (int i = 0; i < 4; ++i)
+            {
+                sf::Uint8 alpha = darkness;
+                if (visible)
+                {
+                    // distance from the center of the player's tile to this corner, in light radii
+                    float dx = (x + corners[i][0] - maskRadius - 0.5f) / lightRadius;
+                    float dy = (y + corners[i][1] - maskRadius - 0.5f) / lightRadius;
+                    alpha = static_cast<sf::Uint8>(std::min(1.0f, dx * dx + dy * dy) * EXPLORED_DARKNESS);
+                }
+                m_darknessMask[vertex].position = sf::Vector2f((x + corners[i][0]) * squareSize,
+                                                               (y + corners[i][1]) * squareSize);
+                m_darknessMask[vertex].color = sf::Color(0, 0, 0, alpha);
+                ++vertex;
+            }
+        }
+    }
+    ++m_maskRevision;
+}
+
+
+/**
+ * @brief Draws every explored tile of the level onto the minimap.
+ * @details This is the only place the whole minimap is built and uploaded,
+ * which happens when the level is loaded or reset. Explored tiles are read a
+ * chunk row (64 tiles) at a time, and chunks that were never explored are
+ * skipped entirely.
+ * @throw None
+ * @param None
+ * @return None
+ */
+void Gameplay::buildMinimap()
+{
+    if (!m_minimap.create(GRID_SIZE, sf::Color::Transparent))
+    {
+        return;
+    }
+
+    for (unsigned int y = 0; y < GRID_SIZE; ++y)
+    {
+        for (unsigned int chunkX = 0; chunkX < m_exploration.chunksPerSide(); ++chunkX)
+        {
+            std::uint64_t bits = m_exploration.exploredBits(chunkX, y);
+            for (unsigned int bit = 0; bits != 0; ++bit, bits >>= 1)
+            {
+                if (bits & 1)
+                {
+                    unsigned int x = chunkX * ExplorationMap::CHUNK_SIZE + bit;
+                    m_minimap.setPixel(x, y, TileGrid::mapColor(m_grid.get(x, y)));
+                }
+            }
+        }
+    }
+    m_minimap.flush();
+    m_minimapSprite.setTexture(m_minimap.getTexture(), true);
+}
+
+
+/**
+ * @brief Queues the currently visible tiles to be drawn onto the minimap.
+ * @details Visible tiles are explored by definition. The minimap belongs to
+ * the render thread, so the tiles go into the next published state and
+ * takeState() draws them. Pixels that already have the right color are not
+ * marked as changed there, so only newly explored tiles end up being
+ * uploaded.
+ * @throw std::bad_alloc if the queued tiles outgrow their vector.
+ * @param None
+ * @return None
+ */
+void Gameplay::revealOnMinimap()
+{
+    int firstX = m_visibility.originX() - Visibility::MAX_RADIUS;
+    for (int y = m_visibility.originY() - m_visibility.radius(); y <= m_visibility.originY() + m_visibility.radius(); ++y)
+    {
+        std::uint64_t bits = m_visibility.visibleRow(y);
+        for (int x = firstX; bits != 0; ++x, bits >>= 1)
+        {
+            if ((bits & 1) && x >= 0 && y >= 0 && x < static_cast<int>(GRID_SIZE) && y < static_cast<int>(GRID_SIZE))
+            {
+                m_simState.revealed.push_back(sf::Vector2i(x, y));
+            }
+        }
+    }
+}
+
+
+/**
+ * @brief Graphically displays the minimap around the player.
+ * @details Pending pixel changes are uploaded first, then the part of the
+ * minimap texture around the player is drawn with a dot marking the player.
+ * Near the edges of the maze the shown area is kept inside the texture and
+ * the dot is moved towards the edge instead.
+ * @throw SFML exceptions may be thrown during fatal errors.
+ * @param tile - the tile the player is drawn on.
+ * @return None
+ */
+void Gameplay::displayMinimap(sf::Vector2i tile)
+{
+    if (!m_minimap.isValid())
+    {
+        return;
+    }
+    m_minimap.flush();
+
+    // the shown area stops at the edges of the maze, and the dot moves off centre instead
+    int lastLeft = std::max(0, static_cast<int>(GRID_SIZE) - MINIMAP_TILES);
+    int left = std::clamp(tile.x - MINIMAP_TILES / 2, 0, lastLeft);
+    int top = std::clamp(tile.y - MINIMAP_TILES / 2, 0, lastLeft);
+    m_minimapSprite.setTextureRect(sf::IntRect(left, top, MINIMAP_TILES, MINIMAP_TILES));
+    float tileSize = m_minimapFrame.getSize().x / MINIMAP_TILES;
+    m_minimapPlayer.setPosition(m_minimapFrame.getPosition().x + (tile.x - left) * tileSize,
+                                m_minimapFrame.getPosition().y + (tile.y - top) * tileSize);
+    draw(m_minimapFrame);
+    draw(m_minimapSprite);
+    draw(m_minimapPlayer);
+}
+
+
+/**
+ * @brief Returns the world position of the top left corner of the screen.
+ * @details The world has the top left corner of tile (0, 0) at its origin,
+ * so tile (x, y) is drawn at (x, y) * squareSize minus this.
+ * @throw None
+ * @param None
+ * @return sf::Vector2f - the scroll of the grid, in pixels
+ */
+sf::Vector2f Gameplay::scroll() const
+{
+    return sf::Vector2f(upperLeftSquare.x * squareSize - gridOffset.x, upperLeftSquare.y * squareSize - gridOffset.y);
+}
+
+
+/**
+ * @brief Returns the mouse position scaled to m_width and m_height.
+ * @details Everything else is in terms of m_width and m_height, whatever
+ * size the window has. Reads the window, so only the render thread calls it.
+ * @throw None
+ * @param None
+ * @return sf::Vector2f - the position of the mouse
+ */
+sf::Vector2f Gameplay::mouseInView() const
+{
+    sf::Vector2i mouse = mouseOnWindow();
+    return sf::Vector2f(static_cast<float>(mouse.x) / m_window->getSize().x * m_width,
+                        static_cast<float>(mouse.y) / m_window->getSize().y * m_height);
+}
+
+
+/**
+ * @brief Publishes the current state and starts the simulation thread.
+ * @details The state is captured and taken here first, so the frame that
+ * starts the simulation already has something to draw. If the grid has
+ * traps, the simulation's grid and the render thread's grid are each given
+ * their own tiles first, so setting off a trap changes them in place instead
+ * of copying the level in a tick, and neither thread ever changes tiles the
+ * other one reads. Without traps the tiles never change and stay shared.
+ * @throw std::system_error if the thread cannot be started.
+ * @throw std::bad_alloc if the tiles cannot be copied.
+ * @param None
+ * @return None
+ */
+void Gameplay::startSimulation()
+{
+    if (m_grid.count(1) != 0)
+    {
+        m_grid.detach();
+        m_shownGrid.detach();
+    }
+    m_mouse.store(mouseInView(), std::memory_order_relaxed);
+    updateVisibility();
+    captureState(m_simState);
+    publishState();
+    takeState();
+    m_simulationStopping.store(false, std::memory_order_relaxed);
+    m_simulation = std::thread(&Gameplay::simulate, this);
+}
+
+
+/**
+ * @brief Stops the simulation thread, so the game can be changed from the
+ * render thread.
+ * @details Waits for the tick in progress to finish, at most one frame. The
+ * last state it published is taken so the minimap does not miss any tiles,
+ * and clicks the simulation did not get to are dropped.
+ * @throw None
+ * @param None
+ * @return None
+ */
+void Gameplay::stopSimulation()
+{
+    if (!m_simulation.joinable())
+    {
+        return;
+    }
+    m_simulationStopping.store(true, std::memory_order_relaxed);
+    m_simulation.join();
+    takeState();
+    sf::Event event;
+    while (m_simulationInput.pop(event))
+    {
+    }
+}
+
+
+/**
+ * @brief Runs a tick every frame until stopped, on the simulation thread.
+ * @details Ticks are paced to the frame rate setting by a FramePacer of their
+ * own, independent of how long the render thread takes to draw. The setting
+ * cannot change while the simulation runs, since it is only changed on the
+ * settings screen. Allocations are counted as transient, and the thread's
+ * FrameArena is reset after every tick. The heap allocations of each tick
+ * are added to FrameStats::tickAllocations(), so the soak test can check
+ * them along with the frames.
+ * @throw None
+ * @param None
+ * @return None
+ */
+void Gameplay::simulate()
+{
+    MemoryScope memoryScope(MemoryTag::Transient);
+    FramePacer pacer;
+    pacer.setRate(m_settings->frameRate);
+    while (!m_simulationStopping.load(std::memory_order_relaxed))
+    {
+        pacer.waitForFrame();
+        std::uint64_t allocations = FrameStats::threadAllocations();
+        {
+            PROFILE_ZONE("Gameplay::tick");
+            tick();
+        }
+        publishState();
+        FrameArena::reset();
+        FrameStats::countTickAllocations(FrameStats::threadAllocations() - allocations);
+    }
+}
+
+
+/**
+ * @brief Copies what render() draws out of the game.
+ * @details The darkness mask is only copied if it was rebuilt since the
+ * state last got it, into the state's own array, which keeps its memory.
+ * The previous scroll and rotation are set to the current ones, so a state
+ * captured outside of tick() is drawn without interpolating. The changed
+ * tiles and the tiles to reveal on the minimap are left as they are.
+ * gridBytes only covers the grids of the simulation, since m_shownGrid
+ * belongs to the render thread, which adds it in gridMemory().
+ * @throw std::bad_alloc if the state's mask has to grow.
+ * @param state - the state to fill.
+ * @return None
+ */
+void Gameplay::captureState(GameplayState& state) const
+{
+    state.scroll = state.previousScroll = scroll();
+    state.rotation = state.previousRotation = player.sprite.getRotation();
+    state.healthPercent = player.healthPercent;
+    state.status = player.status;
+    state.moveTarget.reset();
+    if (m_moveTarget.x != -1)
+    {
+        state.moveTarget = m_moveTarget + state.scroll;
+    }
+    state.highlighted.reset();
+    std::optional<GameObject> blockMouseOn = blockMouseIsOn();
+    if (blockMouseOn)
+    {
+        state.highlighted = sf::Vector2i(blockMouseOn->arrIndexX, blockMouseOn->arrIndexY);
+    }
+    if (state.maskRevision != m_maskRevision)
+    {
+        state.darknessMask = m_darknessMask;
+        state.maskRevision = m_maskRevision;
+    }
+    state.maskOrigin = m_maskOrigin;
+    state.gridBytes = m_level.memoryUsage() + m_grid.memoryUsage(m_grid.data() != m_level.data());
+    state.time = std::chrono::steady_clock::now();
+}
+
+
+/**
+ * @brief Hands the state of the last tick to the render thread.
+ * @details The states are swapped under the lock, so nothing is copied while
+ * it is held. If the render thread has not taken the previous state, that
+ * state is dropped, but the tiles it changed and had to reveal on the
+ * minimap are carried over into this one, ahead of its own. Their vectors are
+ * swapped out under the lock and merged after it is released, and the lock
+ * is taken a second time to publish the merged state.
+ * @throw std::bad_alloc if the carried over tiles cannot be allocated.
+ * @param None
+ * @return None
+ */
+void Gameplay::publishState()
+{
+    bool published = false;
+    {
+        std::lock_guard<std::mutex> lock(m_stateMutex);
+        if (!m_stateFresh)
+        {
+            std::swap(m_simState, m_publishedState);
+            m_stateFresh = published = true;
+        }
+        else
+        {
+            m_carriedTiles.swap(m_publishedState.changedTiles);
+            m_carriedReveals.swap(m_publishedState.revealed);
+            m_stateFresh = false;
+        }
+    }
+    if (!published)
+    {
+        m_simState.changedTiles.insert(m_simState.changedTiles.begin(), m_carriedTiles.begin(), m_carriedTiles.end());
+        m_simState.revealed.insert(m_simState.revealed.begin(), m_carriedReveals.begin(), m_carriedReveals.end());
+        m_carriedTiles.clear();
+        m_carriedReveals.clear();
+        std::lock_guard<std::mutex> lock(m_stateMutex);
+        std::swap(m_simState, m_publishedState);
+        m_stateFresh = true;
+    }
+    m_simState.changedTiles.clear();
+    m_simState.revealed.clear();
+}
+
+
+/**
+ * @brief Takes the newest published state and catches the minimap up with it.
+ * @details Does nothing if no state was published since the last one was
+ * taken. The tiles the simulation changed are replayed into m_shownGrid
+ * first, and the revealed tiles are colored from it, so a trap set off in
+ * the same tick shows as a path.
+ * @throw None
+ * @param None
+ * @return None
+ */
+void Gameplay::takeState()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_stateMutex);
+        if (!m_stateFresh)
+        {
+            return;
+        }
+        std::swap(m_publishedState, m_shownState);
+        m_stateFresh = false;
+    }
+    for (const GameplayState::TileChange& change : m_shownState.changedTiles)
+    {
+        m_shownGrid.set(change.tile.x, change.tile.y, change.type);
+    }
+    for (const sf::Vector2i& tile : m_shownState.revealed)
+    {
+        m_minimap.setPixel(tile.x, tile.y, TileGrid::mapColor(m_shownGrid.get(tile.x, tile.y)));
+    }
+}
@@ -9,6 +9,12 @@
 #include <iostream>
 #include <cstdlib>
 #include <cmath>
+#include <optional>
+#include <memory>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <chrono>
 
 
 // Included Graphics Library Dependencies
@@ -17,6 +23,14 @@
 
 // Included Local Dependencies
 #include "section.h"
+#include "visibility.h"
+#include "explorationMap.h"
+#include "tileImage.h"
+#include "tileGrid.h"
+#include "levelWatcher.h"
+#include "frameArena.h"
+#include "framePacer.h"
+#include "spscQueue.h"
 
 
 /**
@@ -48,7 +62,8 @@ struct Player
  * Brief: Stores all data for a single tile.
  * Description:
  *  Contains the index of the tile in the tile array, the type of tile, and
- *  the sprite texture of the tile.
+ *  whether the tile can be walked on. The tiles themselves are kept in a
+ *  TileGrid, so a GameObject is only a short lived copy of one of them.
  */
 struct GameObject
 {
@@ -56,7 +71,47 @@ struct GameObject
     int arrIndexY = -1;
     int textureIndex = 4;
     bool walkable = false;
-    sf::Sprite sprite;
+};
+
+
+/**
+ * Struct Name: GameplayState
+ * Brief: Everything the game screen draws, as of one simulation tick.
+ * Description:
+ *  The simulation thread fills one of these while the render thread draws
+ *  another, so the two never touch the same data. There are three, rotated
+ *  between the simulation, the one waiting to be taken and the one being
+ *  drawn. The tiles are not in the state: the render thread keeps its own
+ *  copy of the grid and replays the tiles the simulation changed into it.
+ *  Each state has its own darkness mask, refilled in place only when the
+ *  simulation built a new one since the state was last filled, so steady
+ *  ticks neither copy nor allocate it. Positions are in world pixels, so
+ *  the render thread can interpolate between the previous tick and this one.
+ */
+struct GameplayState
+{
+    // A tile the simulation changed
+    struct TileChange
+    {
+        sf::Vector2i tile;
+        unsigned char type;
+    };
+
+    sf::Vector2f previousScroll;    // World position of the top left corner of the screen one tick earlier.
+    sf::Vector2f scroll;            // World position of the top left corner of the screen.
+    float previousRotation = 0;
+    float rotation = 0;             // Of the player sprite, in degrees.
+    float healthPercent = 100;
+    decltype(Player::status) status = Player::Alive;
+    std::optional<sf::Vector2f> moveTarget;     // World position of the square the player walks to.
+    std::optional<sf::Vector2i> highlighted;    // The tile under the mouse.
+    sf::VertexArray darknessMask;
+    sf::Vector2i maskOrigin;        // The tile at the top left corner of the darkness mask.
+    unsigned long maskRevision = 0; // The Gameplay::m_maskRevision darknessMask was copied at.
+    std::vector<TileChange> changedTiles;       // Tiles changed since the last state the render thread took, oldest first.
+    std::vector<sf::Vector2i> revealed;         // Tiles to redraw on the minimap since the last state the render thread took.
+    std::size_t gridBytes = 0;      // Of m_level and m_grid; m_shownGrid is added by gridMemory() on the render thread.
+    std::chrono::steady_clock::time_point time; // When the tick ended.
 };
 
 
@@ -67,14 +122,28 @@ struct GameObject
  *  The Gameplay class contains all general functions required for the game to
  *  actually be played. This includes allowing the player to move their
  *  character, displaying the game, and all other processes for game
- *  playthrough.
+ *  playthrough. A level is either read from a .maze file for a save slot, or
+ *  handed over straight from the MazeBuilder to be playtested, in which case
+ *  it shares the builder's tiles and nothing is saved. A level read from a
+ *  file is reloaded while it is played whenever the file changes on disk.
+ *  While the game screen is shown, the game runs on a simulation thread at
+ *  the frame rate setting and publishes a GameplayState after every tick;
+ *  the render thread draws the newest one, interpolated to the moment it is
+ *  drawn. Clicks reach the simulation through a lock-free queue. Pausing,
+ *  resetting and reloading the level stop the simulation first, so only one
+ *  thread ever changes the game. The simulation's grid and the grid the
+ *  render thread draws never share tiles while it runs: both are given their
+ *  own copy before it starts if the level has traps to change, so a trap
+ *  never copies the level in a tick.
  */
 class Gameplay: public Section
 {
 public:
-    // Constructor and Destructor
-    Gameplay(std::shared_ptr<sf::RenderWindow> window, std::shared_ptr<Settings> settings, 
+    // Constructors and Destructor
+    Gameplay(std::shared_ptr<sf::RenderWindow> window, std::shared_ptr<Settings> settings, std::shared_ptr<JobSystem> jobs,
              std::shared_ptr<sf::Music> music, float width, float height, std::string fileName, int saveSlot);
+    Gameplay(std::shared_ptr<sf::RenderWindow> window, std::shared_ptr<Settings> settings, std::shared_ptr<JobSystem> jobs,
+             std::shared_ptr<sf::Music> music, float width, float height, const TileGrid& level, sf::Vector2i spawn);
     ~Gameplay();
     Gameplay(const Gameplay&) = delete;            // copy constructor
     Gameplay(Gameplay&&) = delete;                 // move constructor
@@ -86,31 +155,65 @@ public:
     virtual void update();          // Updates all gameplay variables based on events that occur.
     virtual void handleInput();     // Manages Gameplay input during game playthrough.
     virtual void render();          // Displays all Gameplay assets to the screen.
+    virtual std::size_t gridMemory() const {return m_shownState.gridBytes + m_shownGrid.memoryUsage(m_shownGrid.data() != m_level.data());}
+    virtual bool isIdle() const {return m_screenName == "paused_screen" || m_screenName == "settings_screen";}   // the game itself runs in real time
 
 
 private:
+    friend class GameplayBench;     // Times the private per-frame functions in src/bench.
+
+
     // Private Member Functions for General Gameplay Processes
+    void start(const std::string& saveFileName);  // Sets up everything that depends on the level and places the player.
     void displayHealth();           // Graphically displays the player's health bar.
     void calculateCollision();      // Calculates player related collision and applies damage if applicable
-    void populateGrid();            // Creates a 2d vector of GameObjects for the maze from a given file
-    void renderGrid();              // Renders the maze, including a layer of blocks the user cannot see around the screen
+    void populateGrid();            // Sets up the playing grid and the tiles that block light from the level.
+    void renderGrid(sf::RenderTarget& target, sf::Vector2f scroll);  // Renders the maze, including a layer of blocks the user cannot see around the screen
+    GameObject tileAt(unsigned int x, unsigned int y) const;            // Returns the grid data of a single tile.
     bool playerWon();               // Returns a boolean indicating whether the player has won.
     void resetLevel();              // Resets the level to its original form.
+    void reloadLevel();             // Swaps in the parts of the level file that changed on disk.
     std::optional<GameObject> blockMouseIsOn() const;                   // Calculates and returns the grid data of the mouse position.
     sf::Vector2f indexToCoord(unsigned int x, unsigned int y) const;    // Converts indices of the grid array to an sf::Vector2f.
-    std::vector<GameObject> blocksPlayerIsOn() const;                   // Calculates collision and returns a vector of squares the player is currently on.
+    FrameVector<GameObject> blocksPlayerIsOn() const;                   // Calculates collision and returns a vector of squares the player is currently on.
     void pausedScreenInput();           // Deals with input for the ingame settings (when Escape is pressed).
     void settingsScreenInput();         // Deals with input if the current screen is settings_screen.
     void renderSettingsScreen();        // Renders in game settings screen.
-    void calculatePlayerVelocity();     // Calculates the player velocity based on the distance to the selected square (m_squareToMoveTo).
+    void calculatePlayerVelocity();     // Calculates the player velocity based on the distance to the selected square (m_moveTarget).
     void updateSettingsStruct();        // Loads the current settings to settings.csv.
     void rotatePlayerToMouse();
+    sf::Vector2i playerTile() const;    // Returns the grid indices of the tile the center of the player is on.
+    void updateVisibility();            // Recalculates the lit tiles when the player moves onto a new tile.
+    void buildDarknessMask();           // Refills the vertex array drawn over tiles the player cannot see.
+    void buildMinimap();                // Draws every explored tile of the level onto the minimap.
+    void revealOnMinimap();             // Queues the currently visible tiles to be drawn onto the minimap.
+    void displayMinimap(sf::Vector2i tile);     // Graphically displays the minimap around the player's tile.
+    sf::Vector2f scroll() const;        // Returns the world position of the top left corner of the screen.
+    sf::Vector2f mouseInView() const;   // Returns the mouse position scaled to m_width and m_height.
+
+    // Private Member Functions for the Simulation Thread
+    void startSimulation();         // Publishes the current state and starts the simulation thread.
+    void stopSimulation();          // Stops the simulation thread, so the game can be changed from the render thread.
+    void simulate();                // Runs a tick every frame until stopped, on the simulation thread.
+    void tick();                    // Advances the game by one frame.
+    void captureState(GameplayState& state) const;  // Copies what render() draws out of the game.
+    void publishState();            // Hands the state of the last tick to the render thread.
+    void takeState();               // Takes the newest published state and catches the minimap up with it.
+
+    // Private Member Constants
+    static const int EASY_LIGHT_RADIUS = 8;     // Light radius in tiles on easy difficulty.
+    static const int HARD_LIGHT_RADIUS = 5;     // Light radius in tiles on hard difficulty.
+    static const int EXPLORED_DARKNESS = 170;   // Mask alpha of tiles that were seen before but are not lit.
+    static const int MINIMAP_TILES = 64;        // Width and height of the area shown on the minimap, in tiles.
+    static const std::size_t INPUT_CAPACITY = 64;   // Clicks that can wait for the simulation.
 
     // Private Member Variables
     sf::RectangleShape healthBar;
     sf::RectangleShape healthBarBg;
     sf::RectangleShape m_highlightedGridRect;
     sf::RectangleShape m_squareToMoveTo;
+    sf::Sprite m_playerSprite;          // The player as drawn; player.sprite belongs to the simulation.
+    sf::RectangleShape m_settingRect;   // box around a chosen setting, moved to each one in turn
     std::unique_ptr<sf::Texture> deathScreenTexture;
     sf::Sprite deathScreenSprite;
     std::unique_ptr<sf::Texture> hardModeTexture;
@@ -125,14 +228,43 @@ private:
     sf::Vector2i startingBlock;
     sf::Vector2f gridOffset;
     std::vector<std::unique_ptr<sf::Texture>> vectorOfTextures;
+    std::vector<sf::Sprite> m_tileSprites;  // one sprite per tile type, shared by every tile
     std::shared_ptr<sf::Music> m_music;
 
-    std::vector<std::vector<GameObject>> m_maze;
+    Visibility m_visibility;
+    ExplorationMap m_exploration;
+    TileImage m_minimap;
+    sf::Sprite m_minimapSprite;
+    sf::RectangleShape m_minimapFrame;
+    sf::RectangleShape m_minimapPlayer;
+    sf::VertexArray m_darknessMask;     // Copied into each state once after it changes.
+    unsigned long m_maskRevision = 0;   // Incremented whenever m_darknessMask is rebuilt.
+    sf::Vector2i m_visibilityOrigin;    // The player tile the visibility was last calculated from.
+    sf::Vector2i m_maskOrigin;          // The tile at the top left corner of the darkness mask.
+
+    TileGrid m_level;               // The level as it was loaded, shared with m_grid until a tile changes.
+    TileGrid m_grid;                // The level as it is being played, owned by the simulation while it runs.
+    TileGrid m_shownGrid;           // m_grid as of m_shownState, owned by the render thread.
+    SectionName m_exitSection;      // The section the Main Menu button leaves to.
+    LevelWatcher m_watcher;         // Only watches levels read from a file.
     std::string fileName;
     unsigned int objectsToDisplay;
     float squareSize;
     float TEXTURE_SIZE;
     unsigned int GRID_SIZE;
     Player player;
+    sf::Vector2f m_moveTarget;      // Screen position of the square the player walks to, (-1, -1) for none.
+
+    std::thread m_simulation;
+    std::atomic<bool> m_simulationStopping{false};
+    SpscQueue<sf::Event, INPUT_CAPACITY> m_simulationInput;     // Clicks, from the render thread to the simulation.
+    std::atomic<sf::Vector2f> m_mouse{sf::Vector2f(0, 0)};      // mouseInView(), stored by handleInput() for the simulation.
+    std::mutex m_stateMutex;
+    GameplayState m_simState;       // Filled by the simulation thread.
+    GameplayState m_publishedState; // Guarded by m_stateMutex.
+    bool m_stateFresh = false;      // Guarded by m_stateMutex; whether m_publishedState was not taken yet.
+    std::vector<GameplayState::TileChange> m_carriedTiles;  // changedTiles of a dropped state, merged by publishState().
+    std::vector<sf::Vector2i> m_carriedReveals;             // revealed of a dropped state, merged by publishState().
+    GameplayState m_shownState;     // Drawn by the render thread.
 };
 
@@ -0,0 +1,400 @@
+#include "jobSystem.h"
+
+
+/**
+ * @brief JobSystem class constructor
+ * @details Starts the workers straight away. One core is left for the main
+ * thread, and at most MAX_WORKERS are started.
+ * @throw std::system_error if a worker cannot be started.
+ * @param workers - the number of workers, or 0 for one less than the number
+ * of cores.
+ */
+JobSystem::JobSystem(unsigned int workers)
+{
+    if (workers == 0)
+    {
+        workers = std::clamp(std::thread::hardware_concurrency(), 2u, MAX_WORKERS + 1) - 1;
+    }
+    for (unsigned int i = 0; i < workers; ++i)
+    {
+        m_workers.push_back(std::make_unique<Worker>());
+    }
+    for (std::size_t i = 0; i < m_workers.size(); ++i)
+    {
+        m_workers[i]->thread = std::thread(&JobSystem::work, this, i);
+    }
+}
+
+
+/**
+ * @brief Destructor for the JobSystem class.
+ * @details Workers finish the job they are running, and jobs still queued
+ * are dropped. Sections cancel and wait for their own jobs before they are
+ * destroyed, so nothing they queued is left by then.
+ * @throw None
+ */
+JobSystem::~JobSystem()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_sleepMutex);
+        m_stopping = true;
+    }
+    m_wake.notify_all();
+    for (std::unique_ptr<Worker>& worker : m_workers)
+    {
+        worker->thread.join();
+    }
+}
+
+
+/**
+ * @brief Queues work to run once every job in after has finished.
+ * @details A job that waits for a cancelled job is cancelled as well.
+ * @throw std::bad_alloc if the job cannot be allocated.
+ * @param name - what the job does, shown in the profiler. It must outlive the
+ * job, so it is normally a string literal.
+ * @param work - runs on a worker, or on a thread waiting for a job.
+ * @param then - runs on the main thread in runCompletions() once work is
+ * done, or nothing.
+ * @param after - the jobs that have to finish before work starts.
+ * @return JobSystem::JobHandle - the job, to wait for, cancel or make other
+ * jobs wait for
+ */
+JobSystem::JobHandle JobSystem::submit(const char* name, std::function<void()> work, std::function<void()> then,
+                                       const std::vector<JobHandle>& after)
+{
+    JobHandle job = std::make_shared<Job>();
+    job->name = name;
+    job->work = std::move(work);
+    job->then = std::move(then);
+    job->tag = MemoryTracker::currentTag();
+    for (const JobHandle& dependency : after)
+    {
+        std::lock_guard<std::mutex> lock(dependency->mutex);
+        if (!dependency->finished)
+        {
+            dependency->dependents.push_back(job);
+            ++job->blockers;
+        }
+        else if (dependency->cancelled)
+        {
+            job->cancelled = true;
+        }
+    }
+    if (--job->blockers == 0)
+    {
+        enqueue(job);
+    }
+    return job;
+}
+
+
+/**
+ * @brief Runs job on the calling thread if it has not started, or sleeps
+ * until it has finished.
+ * @details Only the job itself is ever run here, so waiting for a short job
+ * never ends up running someone else's long one. A job still waiting for
+ * other jobs is run as soon as they have finished; a cancelled job that has
+ * not started is finished straight away.
+ * @throw Whatever the job throws.
+ * @param job - the job to wait for.
+ * @return None
+ */
+void JobSystem::wait(const JobHandle& job)
+{
+    while (!job->finished)
+    {
+        if (job->blockers == 0 && !job->claimed.exchange(true))
+        {
+            run(job); // its entry on a deque is skipped
+            return;
+        }
+        ++m_waiting;
+        {
+            std::unique_lock<std::mutex> lock(m_sleepMutex);
+            m_wake.wait(lock, [&job] {return job->finished || ready(*job);});
+        }
+        --m_waiting;
+    }
+}
+
+
+/**
+ * @brief Keeps a job from starting and its completion from running.
+ * @details A job that is already running is not interrupted; wait() for it
+ * before freeing anything it uses.
+ * @throw None
+ * @param job - the job to cancel.
+ * @return None
+ */
+void JobSystem::cancel(const JobHandle& job)
+{
+    job->cancelled = true;
+}
+
+
+/**
+ * @brief Returns whether the work of a job is done or was cancelled.
+ * @throw None
+ * @param job - the job.
+ * @return bool - true if the job will not run any more, false if not
+ */
+bool JobSystem::finished(const JobHandle& job) const
+{
+    return job->finished;
+}
+
+
+/**
+ * @brief Splits [0, count) into ranges and runs them on the calling thread
+ * and the workers.
+ * @details Ranges of at most grain indices are taken in order from a shared
+ * counter by the calling thread and by up to one helper job per worker, so
+ * the calling thread only works on this loop. Helpers that have not started
+ * by the time the ranges run out are cancelled, and those still running a
+ * range are waited for.
+ * @throw std::bad_alloc if the helper jobs cannot be allocated.
+ * @param name - what the jobs do, shown in the profiler.
+ * @param count - the number of indices.
+ * @param grain - the most indices a range gets, at least 1.
+ * @param body - called with the first and one past the last index of each
+ * range, on several threads at once.
+ * @return None
+ */
+void JobSystem::parallelFor(const char* name, std::size_t count, std::size_t grain,
+                            const std::function<void(std::size_t, std::size_t)>& body)
+{
+    std::atomic<std::size_t> next{0};
+    auto runRanges = [&next, &body, count, grain]
+    {
+        for (std::size_t first = next.fetch_add(grain); first < count; first = next.fetch_add(grain))
+        {
+            body(first, std::min(first + grain, count));
+        }
+    };
+
+    std::vector<JobHandle> helpers;
+    std::size_t ranges = (count + grain - 1) / grain;
+    for (std::size_t i = 1; i < std::min<std::size_t>(ranges, m_workers.size() + 1); ++i)
+    {
+        helpers.push_back(submit(name, runRanges));
+    }
+    runRanges();
+    for (const JobHandle& helper : helpers)
+    {
+        cancel(helper);
+        wait(helper);
+    }
+}
+
+
+/**
+ * @brief Runs the completions of finished jobs. Only called on the main
+ * thread.
+ * @details Called by Game at the start of every frame, before the section
+ * updates. Completions run in the order their jobs finished, and those of
+ * cancelled jobs are skipped. A completion may submit more jobs; theirs run
+ * next frame at the earliest.
+ * @throw Whatever the completions throw.
+ * @param None
+ * @return None
+ */
+void JobSystem::runCompletions()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_completionMutex);
+        if (m_completions.empty())
+        {
+            return;
+        }
+        m_runningCompletions.swap(m_completions);
+    }
+    for (const JobHandle& job : m_runningCompletions)
+    {
+        if (!job->cancelled)
+        {
+            PROFILE_ZONE(job->name);
+            job->then();
+        }
+        job->then = nullptr; // lets go of whatever it captured
+    }
+    m_runningCompletions.clear();
+}
+
+
+/**
+ * @brief Returns whether a completion is waiting for runCompletions().
+ * @throw None
+ * @param None
+ * @return bool - true if there is a completion to run, false if not
+ */
+bool JobSystem::hasCompletions() const
+{
+    std::lock_guard<std::mutex> lock(m_completionMutex);
+    return !m_completions.empty();
+}
+
+
+/**
+ * @brief Body of the worker threads.
+ * @details Runs jobs until the job system is destroyed, sleeping whenever
+ * every deque is empty. The FrameArena is reset after each job taken here.
+ * @throw None
+ * @param index - the index of the worker in m_workers.
+ * @return None
+ */
+void JobSystem::work(std::size_t index)
+{
+    t_system = this;
+    t_worker = index;
+    while (!m_stopping)
+    {
+        JobHandle job = take();
+        if (job)
+        {
+            run(job);
+            FrameArena::reset(); // only between jobs, never inside one that waits for another
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(m_sleepMutex);
+        m_wake.wait(lock, [this] {return m_stopping || m_queued > 0;});
+    }
+}
+
+
+/**
+ * @brief Puts a job whose dependencies have finished on a deque.
+ * @details A worker puts it on its own deque, where it is taken next; any
+ * other thread deals jobs out to the workers in turn.
+ * @throw std::bad_alloc if the deque cannot grow.
+ * @param job - the job.
+ * @return None
+ */
+void JobSystem::enqueue(JobHandle job)
+{
+    std::size_t index = (t_system == this) ? t_worker : m_nextWorker++ % m_workers.size();
+    ++m_queued; // counted first, so a thief that takes it straight away never takes the count below zero
+    {
+        std::lock_guard<std::mutex> lock(m_workers[index]->mutex);
+        m_workers[index]->jobs.push_back(std::move(job));
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_sleepMutex); // a worker about to sleep has either seen m_queued or gets the notification
+    }
+    m_wake.notify_one();
+}
+
+
+/**
+ * @brief Takes a job from the calling worker's deque, or steals one.
+ * @details A worker takes the newest job of its own deque first. Others are
+ * stolen from oldest first, starting at the next worker along, so thieves
+ * spread over the deques. Jobs a waiting thread already claimed are dropped
+ * on the way.
+ * @throw None
+ * @param None
+ * @return JobSystem::JobHandle - the job, claimed by the caller, or nullptr
+ * if every deque is empty
+ */
+JobSystem::JobHandle JobSystem::take()
+{
+    std::size_t own = t_worker;
+    while (true)
+    {
+        JobHandle job;
+        {
+            Worker& worker = *m_workers[own];
+            std::lock_guard<std::mutex> lock(worker.mutex);
+            if (!worker.jobs.empty())
+            {
+                job = std::move(worker.jobs.back());
+                worker.jobs.pop_back();
+            }
+        }
+        for (std::size_t i = 1; !job && i < m_workers.size(); ++i)
+        {
+            Worker& victim = *m_workers[(own + i) % m_workers.size()];
+            std::lock_guard<std::mutex> lock(victim.mutex);
+            if (!victim.jobs.empty())
+            {
+                job = std::move(victim.jobs.front());
+                victim.jobs.pop_front();
+            }
+        }
+        if (!job)
+        {
+            return nullptr;
+        }
+        --m_queued;
+        if (!job->claimed.exchange(true))
+        {
+            return job;
+        }
+    }
+}
+
+
+/**
+ * @brief Runs a claimed job unless it was cancelled, then finishes it.
+ * @details The job's allocations are tagged like those of the thread that
+ * submitted it. The FrameArena is left alone, since a thread running the job
+ * it waits for may be in the middle of a frame or of an outer job; work()
+ * resets it between jobs.
+ * @throw Whatever the job throws.
+ * @param job - the job.
+ * @return None
+ */
+void JobSystem::run(const JobHandle& job)
+{
+    if (!job->cancelled)
+    {
+        MemoryScope memoryScope(job->tag);
+        PROFILE_ZONE(job->name);
+        job->work();
+    }
+    job->work = nullptr; // lets go of whatever it captured
+    finish(job);
+}
+
+
+/**
+ * @brief Queues the completion of a job and releases the jobs that wait
+ * for it.
+ * @details Jobs waiting for a cancelled job are cancelled too. Threads in
+ * wait() are woken if there are any.
+ * @throw std::bad_alloc if a completion or a released job cannot be queued.
+ * @param job - the job that finished.
+ * @return None
+ */
+void JobSystem::finish(const JobHandle& job)
+{
+    if (job->then) // queued first, so a thread whose wait() returns finds it there
+    {
+        std::lock_guard<std::mutex> lock(m_completionMutex);
+        m_completions.push_back(job);
+    }
+    std::vector<JobHandle> dependents;
+    {
+        std::lock_guard<std::mutex> lock(job->mutex);
+        job->finished = true;
+        dependents.swap(job->dependents);
+    }
+    for (const JobHandle& dependent : dependents)
+    {
+        if (job->cancelled)
+        {
+            dependent->cancelled = true;
+        }
+        if (--dependent->blockers == 0)
+        {
+            enqueue(dependent);
+        }
+    }
+    if (m_waiting > 0) // wakes threads waiting for this job or for one it released
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_sleepMutex);
+        }
+        m_wake.notify_all();
+    }
+}
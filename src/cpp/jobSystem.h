@@ -0,0 +1,122 @@
+#pragma once
+
+
+// Included C++11 Libraries
+#include <vector>
+#include <deque>
+#include <memory>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <algorithm>
+
+
+// Included Local Dependencies
+#include "memoryTracker.h"
+#include "frameArena.h"
+#include "profiler.h"
+
+
+/**
+ * Class Name: JobSystem
+ * Brief: Pool of worker threads that runs background work for every section.
+ * Description:
+ *  Owned by Game and handed to every section, so nothing has to start
+ *  threads of its own for one-off work. Every worker has its own deque of
+ *  jobs: it takes the newest job from the back of its own, and when that is
+ *  empty steals the oldest from the front of another worker's, so a worker
+ *  that submits jobs keeps their data in its cache while idle workers share
+ *  the load. Jobs submitted from outside the workers are dealt out in turn.
+ *  A job can wait for other jobs to finish before it starts, and can have a
+ *  completion that Game runs on the main thread at the start of the next
+ *  frame, so results reach a section without it having to lock anything.
+ *  A job is claimed by whoever runs it first, so a thread that waits for a
+ *  job that has not started runs it itself rather than sleeping, but never
+ *  runs anyone else's. parallelFor() hands out its ranges through a shared
+ *  counter that the caller and the helper jobs it submits all take from, so
+ *  the caller only ever works on its own loop. Jobs are tagged with the
+ *  MemoryTag of the thread that submitted them, and a worker resets its
+ *  FrameArena between the jobs it takes off the deques, never while one
+ *  of them is still running.
+ */
+class JobSystem
+{
+    struct Job;
+
+public:
+    typedef std::shared_ptr<Job> JobHandle;
+
+    // Constructor and Destructor
+    JobSystem(unsigned int workers = 0);
+    ~JobSystem();
+    JobSystem(const JobSystem&) = delete;            // copy constructor
+    JobSystem(JobSystem&&) = delete;                 // move constructor
+    JobSystem& operator=(const JobSystem&) = delete; // copy assignment
+    JobSystem& operator=(JobSystem&&) = delete;      // move assignment
+
+    // Public Member Functions for JobSystem Processes
+    JobHandle submit(const char* name, std::function<void()> work, std::function<void()> then = nullptr,
+                     const std::vector<JobHandle>& after = {});     // Queues work to run once every job in after has finished.
+    void wait(const JobHandle& job);            // Runs job on the calling thread if it has not started, or sleeps until it has finished.
+    void cancel(const JobHandle& job);          // Keeps a job from starting and its completion from running.
+    bool finished(const JobHandle& job) const;  // Returns whether the work of a job is done or was cancelled.
+    void parallelFor(const char* name, std::size_t count, std::size_t grain,
+                     const std::function<void(std::size_t, std::size_t)>& body);   // Splits [0, count) into jobs and waits for them.
+    void runCompletions();                      // Runs the completions of finished jobs. Only called on the main thread.
+    bool hasCompletions() const;                // Returns whether a completion is waiting for runCompletions().
+    unsigned int workerCount() const {return m_workers.size();}
+
+
+private:
+    // One piece of work and what depends on it
+    struct Job
+    {
+        const char* name;               // Shown in the profiler, must outlive the job.
+        std::function<void()> work;
+        std::function<void()> then;     // Runs on the main thread, may be empty.
+        MemoryTag tag;                  // Tag of the thread that submitted the job.
+        std::atomic<int> blockers{1};   // Unfinished jobs it waits for, plus one while submit() sets it up.
+        std::atomic<bool> cancelled{false};
+        std::atomic<bool> claimed{false};   // Set by whoever runs it; a claimed job left on a deque is skipped.
+        std::atomic<bool> finished{false};
+        std::mutex mutex;               // Guards dependents, and finished against new dependents.
+        std::vector<JobHandle> dependents;
+    };
+
+    // A thread and the jobs queued on it
+    struct Worker
+    {
+        std::mutex mutex;
+        std::deque<JobHandle> jobs;     // The owner takes from the back, thieves from the front.
+        std::thread thread;
+    };
+
+    // Private Member Functions for JobSystem Processes
+    void work(std::size_t index);       // Body of the worker threads.
+    void enqueue(JobHandle job);        // Puts a job whose dependencies have finished on a deque.
+    JobHandle take();                   // Takes a job from the calling worker's deque, or steals one.
+    static bool ready(const Job& job) {return job.blockers == 0 && !job.claimed;}  // Whether a job can be claimed.
+    void run(const JobHandle& job);     // Runs a claimed job unless it was cancelled, then finishes it.
+    void finish(const JobHandle& job);  // Releases the jobs that wait for a job and queues its completion.
+
+    // Private Member Constants
+    static constexpr unsigned int MAX_WORKERS = 8;
+
+    // Private Member Variables
+    std::vector<std::unique_ptr<Worker>> m_workers;
+    std::atomic<std::size_t> m_nextWorker{0};   // The deque the next job from outside the workers goes on.
+    std::atomic<std::size_t> m_queued{0};       // Jobs on the deques, including claimed ones not removed yet.
+    std::atomic<int> m_waiting{0};              // Threads sleeping in wait().
+    std::atomic<bool> m_stopping{false};
+    std::mutex m_sleepMutex;
+    std::condition_variable m_wake;             // Wakes idle workers and waiting threads.
+
+    mutable std::mutex m_completionMutex;
+    std::vector<JobHandle> m_completions;       // Finished jobs with a completion, guarded by m_completionMutex.
+    std::vector<JobHandle> m_runningCompletions;    // Reused by runCompletions(), so it does not allocate.
+
+    static inline thread_local JobSystem* t_system = nullptr;   // The job system the calling thread works for.
+    static inline thread_local std::size_t t_worker = 0;        // Its index in m_workers.
+};
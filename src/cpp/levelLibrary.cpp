@@ -0,0 +1,339 @@
+#include "levelLibrary.h"
+
+
+namespace
+{
+    const char INDEX_MAGIC[4] = {'L', 'I', 'B', '1'};
+}
+
+
+/**
+ * @brief LevelLibrary class constructor
+ * @details Reads the index and lists the directory, which only touches the
+ * index file and the directory entries, then queues a job for every level
+ * that has to be read. Entries that are not indexed yet are listed straight
+ * away, and filled in by update() as their jobs finish.
+ * @throw std::bad_alloc if the entries or jobs cannot be allocated.
+ * @param directory - the directory holding the .maze files.
+ * @param jobs - the job system the levels are read on.
+ */
+LevelLibrary::LevelLibrary(const std::string& directory, std::shared_ptr<JobSystem> jobs) :
+m_jobs(jobs),
+m_directory(directory),
+m_pending(0),
+m_indexChanged(false)
+{
+    readIndex();
+    scan();
+}
+
+
+/**
+ * @brief Destructor for the LevelLibrary class.
+ * @details Levels still waiting to be read are dropped, and the jobs already
+ * reading a level are waited for. Everything indexed so far is saved, so the
+ * next library only reads the levels that are left.
+ * @throw None
+ */
+LevelLibrary::~LevelLibrary()
+{
+    for (Indexing& indexing : m_indexing)
+    {
+        m_jobs->cancel(indexing.job);
+    }
+    for (Indexing& indexing : m_indexing)
+    {
+        m_jobs->wait(indexing.job);
+        if (indexing.entry && indexing.entry->indexed) // read, but its completion will not run any more
+        {
+            m_finished.push_back(std::move(*indexing.entry));
+        }
+    }
+
+    update();
+    if (m_indexChanged)
+    {
+        writeIndex();
+    }
+}
+
+
+/**
+ * @brief Takes the levels the jobs finished, returning which entries changed.
+ * @details Meant to be called once a frame, after Game ran the jobs'
+ * completions. The index file is rewritten once every queued level has been
+ * read.
+ * @throw std::bad_alloc if the list of changed entries cannot be allocated.
+ * @param None
+ * @return std::vector<std::size_t> - the indices of the entries that were filled in
+ */
+std::vector<std::size_t> LevelLibrary::update()
+{
+    std::vector<Entry> finished;
+    finished.swap(m_finished);
+
+    std::vector<std::size_t> changed;
+    for (Entry& entry : finished)
+    {
+        auto it = std::lower_bound(m_entries.begin(), m_entries.end(), entry.fileName,
+                                   [](const Entry& a, const std::string& name) {return a.fileName < name;});
+        changed.push_back(it - m_entries.begin());
+        *it = std::move(entry);
+    }
+    m_pending -= finished.size();
+    if (m_pending == 0)
+    {
+        m_indexing.clear();
+    }
+
+    if (m_pending == 0 && m_indexChanged)
+    {
+        writeIndex();
+        m_indexChanged = false;
+    }
+    return changed;
+}
+
+
+/**
+ * @brief Reads the entries of the index file.
+ * @details A missing or damaged index leaves the library empty, so every
+ * level is read again.
+ * @throw std::bad_alloc if the entries cannot be allocated.
+ * @param None
+ * @return None
+ */
+void LevelLibrary::readIndex()
+{
+    PROFILE_ZONE("LevelLibrary::readIndex");
+    std::fstream file(m_directory + "/" + INDEX_FILE_NAME, std::ios::in | std::ios::binary);
+    char magic[4];
+    std::uint32_t count = 0;
+    file.read(magic, sizeof(magic));
+    file.read(reinterpret_cast<char*>(&count), sizeof(count));
+    if (!file || !std::equal(magic, magic + 4, INDEX_MAGIC))
+    {
+        return;
+    }
+
+    for (std::uint32_t i = 0; i < count && file; ++i)
+    {
+        Entry entry;
+        std::uint32_t nameLength = 0;
+        std::uint32_t thumbnailSize = 0;
+        file.read(reinterpret_cast<char*>(&nameLength), sizeof(nameLength));
+        entry.fileName.resize(std::min<std::uint32_t>(nameLength, 4096));
+        file.read(&entry.fileName[0], entry.fileName.size());
+        file.read(reinterpret_cast<char*>(&entry.modified), sizeof(entry.modified));
+        file.read(reinterpret_cast<char*>(&entry.fileSize), sizeof(entry.fileSize));
+        file.read(reinterpret_cast<char*>(&entry.gridSize), sizeof(entry.gridSize));
+        file.read(reinterpret_cast<char*>(entry.typeCounts.data()), sizeof(entry.typeCounts));
+        file.read(reinterpret_cast<char*>(&thumbnailSize), sizeof(thumbnailSize));
+        entry.thumbnail.resize(thumbnailSize == THUMBNAIL_SIZE * THUMBNAIL_SIZE ? thumbnailSize : 0);
+        file.read(reinterpret_cast<char*>(entry.thumbnail.data()), entry.thumbnail.size());
+        entry.indexed = true;
+        if (file && nameLength == entry.fileName.size() && thumbnailSize == entry.thumbnail.size())
+        {
+            m_entries.push_back(std::move(entry));
+        }
+    }
+    if (!file)
+    {
+        m_entries.clear();
+    }
+    std::sort(m_entries.begin(), m_entries.end(), [](const Entry& a, const Entry& b) {return a.fileName < b.fileName;});
+}
+
+
+/**
+ * @brief Writes every indexed entry to the index file.
+ * @details The index is written next to the old one and renamed over it, so
+ * a failed write never damages the previous index.
+ * @throw None
+ * @param None
+ * @return None
+ */
+void LevelLibrary::writeIndex()
+{
+    PROFILE_ZONE("LevelLibrary::writeIndex");
+    std::uint32_t count = std::count_if(m_entries.begin(), m_entries.end(), [](const Entry& entry) {return entry.indexed;});
+    std::string fileName = m_directory + "/" + INDEX_FILE_NAME;
+    std::string tempFileName = fileName + ".tmp";
+    std::fstream file(tempFileName, std::ios::out | std::ios::binary | std::ios::trunc);
+    file.write(INDEX_MAGIC, sizeof(INDEX_MAGIC));
+    file.write(reinterpret_cast<const char*>(&count), sizeof(count));
+    for (const Entry& entry : m_entries)
+    {
+        if (!entry.indexed)
+        {
+            continue;
+        }
+        std::uint32_t nameLength = entry.fileName.size();
+        std::uint32_t thumbnailSize = entry.thumbnail.size();
+        file.write(reinterpret_cast<const char*>(&nameLength), sizeof(nameLength));
+        file.write(entry.fileName.data(), nameLength);
+        file.write(reinterpret_cast<const char*>(&entry.modified), sizeof(entry.modified));
+        file.write(reinterpret_cast<const char*>(&entry.fileSize), sizeof(entry.fileSize));
+        file.write(reinterpret_cast<const char*>(&entry.gridSize), sizeof(entry.gridSize));
+        file.write(reinterpret_cast<const char*>(entry.typeCounts.data()), sizeof(entry.typeCounts));
+        file.write(reinterpret_cast<const char*>(&thumbnailSize), sizeof(thumbnailSize));
+        file.write(reinterpret_cast<const char*>(entry.thumbnail.data()), thumbnailSize);
+    }
+    file.close();
+    std::error_code error;
+    if (file)
+    {
+        std::filesystem::rename(tempFileName, fileName, error); // replaces the old index, on Windows too
+    }
+    if (!file || error)
+    {
+        std::filesystem::remove(tempFileName, error);
+    }
+}
+
+
+/**
+ * @brief Lists the levels in the directory and queues the ones the index is out of date for.
+ * @details An index entry is used as it is when the level's modification
+ * time and size both still match it. Every other level gets a job that
+ * reads it, and entries of levels that no longer exist are dropped. The
+ * completion of each job hands its entry to update().
+ * @throw std::bad_alloc if the entries or jobs cannot be allocated.
+ * @param None
+ * @return None
+ */
+void LevelLibrary::scan()
+{
+    std::vector<Entry> indexed;
+    indexed.swap(m_entries);
+
+    std::error_code error;
+    for (std::filesystem::directory_iterator it(m_directory, error), end; !error && it != end; it.increment(error))
+    {
+        if (it->path().extension() != ".maze" || !it->is_regular_file(error))
+        {
+            continue;
+        }
+        Entry entry;
+        entry.fileName = it->path().filename().string();
+        entry.modified = it->last_write_time(error).time_since_epoch().count();
+        entry.fileSize = it->file_size(error);
+
+        auto match = std::lower_bound(indexed.begin(), indexed.end(), entry.fileName,
+                                      [](const Entry& a, const std::string& name) {return a.fileName < name;});
+        if (match != indexed.end() && match->fileName == entry.fileName &&
+            match->modified == entry.modified && match->fileSize == entry.fileSize)
+        {
+            m_entries.push_back(*match); // copied, moving would break the sorting of the index
+            continue;
+        }
+        m_indexing.push_back({nullptr, std::make_shared<Entry>(entry)});
+        m_entries.push_back(std::move(entry));
+    }
+    std::sort(m_entries.begin(), m_entries.end(), [](const Entry& a, const Entry& b) {return a.fileName < b.fileName;});
+
+    for (std::size_t i = 0; i < m_indexing.size(); ++i)
+    {
+        std::shared_ptr<Entry> entry = m_indexing[i].entry;
+        std::string path = m_directory + "/" + entry->fileName;
+        m_indexing[i].job = m_jobs->submit("LevelLibrary::scan", [entry, path] {indexLevel(path, *entry);}, [this, i]
+        {
+            m_finished.push_back(std::move(*m_indexing[i].entry));
+            m_indexing[i].entry.reset();
+        });
+    }
+    m_pending = m_indexing.size();
+    m_indexChanged = m_pending != 0 || m_entries.size() != indexed.size();
+}
+
+
+/**
+ * @brief Reads a level and fills in its metadata and thumbnail.
+ * @details A level that cannot be read is still marked as indexed, with no
+ * thumbnail, so it is not read again until the file changes.
+ * @throw std::bad_alloc if the level cannot be allocated.
+ * @param path - the path of the .maze file.
+ * @param entry - the entry to fill in.
+ * @return None
+ */
+void LevelLibrary::indexLevel(const std::string& path, Entry& entry)
+{
+    PROFILE_ZONE("LevelLibrary::indexLevel");
+    entry.indexed = true;
+    TileGrid level;
+    if (!level.loadFromFile(path))
+    {
+        return;
+    }
+    entry.gridSize = level.size();
+    for (unsigned int type = 0; type < TileGrid::TYPE_COUNT; ++type)
+    {
+        entry.typeCounts[type] = level.count(type);
+    }
+    makeThumbnail(level, entry);
+}
+
+
+/**
+ * @brief Shrinks the painted part of a level into a thumbnail.
+ * @details The thumbnail covers the bounding box of the non-wall tiles,
+ * padded to a square. Each pixel shows the start or end if one is inside it,
+ * otherwise its most common non-wall tile, so thin paths do not vanish when a
+ * large level is shrunk.
+ * @throw std::bad_alloc if the thumbnail cannot be allocated.
+ * @param level - the level to shrink.
+ * @param entry - the entry the thumbnail is stored in.
+ * @return None
+ */
+void LevelLibrary::makeThumbnail(const TileGrid& level, Entry& entry)
+{
+    int left = 0, top = 0, side = level.size();
+    if (level.hasContent())
+    {
+        int width = level.contentRight() - level.contentLeft() + 1;
+        int height = level.contentBottom() - level.contentTop() + 1;
+        side = std::max(width, height);
+        left = level.contentLeft() - (side - width) / 2;
+        top = level.contentTop() - (side - height) / 2;
+    }
+
+    int gridSize = level.size();
+    entry.thumbnail.resize(THUMBNAIL_SIZE * THUMBNAIL_SIZE);
+    for (unsigned int pixelX = 0; pixelX < THUMBNAIL_SIZE; ++pixelX)
+    {
+        int firstX = std::max(left + static_cast<int>(pixelX * side / THUMBNAIL_SIZE), 0);
+        int lastX = std::min(left + std::max<int>((pixelX + 1) * side / THUMBNAIL_SIZE, pixelX * side / THUMBNAIL_SIZE + 1), gridSize);
+        for (unsigned int pixelY = 0; pixelY < THUMBNAIL_SIZE; ++pixelY)
+        {
+            int firstY = std::max(top + static_cast<int>(pixelY * side / THUMBNAIL_SIZE), 0);
+            int lastY = std::min(top + std::max<int>((pixelY + 1) * side / THUMBNAIL_SIZE, pixelY * side / THUMBNAIL_SIZE + 1), gridSize);
+
+            std::array<unsigned int, TileGrid::TYPE_COUNT> counts{};
+            for (int x = firstX; x < lastX; ++x)
+            {
+                const unsigned char* column = level.data() + level.index(x, 0);
+                for (int y = firstY; y < lastY; ++y)
+                {
+                    ++counts[column[y]];
+                }
+            }
+
+            unsigned char type = TileGrid::WALL;
+            if (counts[6] != 0 || counts[7] != 0)
+            {
+                type = counts[6] != 0 ? 6 : 7;
+            }
+            else
+            {
+                for (unsigned char t = 0; t < TileGrid::TYPE_COUNT; ++t)
+                {
+                    if (t != TileGrid::WALL && counts[t] != 0 && (type == TileGrid::WALL || counts[t] > counts[type]))
+                    {
+                        type = t;
+                    }
+                }
+            }
+            entry.thumbnail[pixelY * THUMBNAIL_SIZE + pixelX] = type;
+        }
+    }
+}
@@ -0,0 +1,97 @@
+#pragma once
+
+
+// Included C++11 Libraries
+#include <vector>
+#include <string>
+#include <array>
+#include <fstream>
+#include <cstdio>
+#include <cstdint>
+#include <algorithm>
+#include <filesystem>
+#include <memory>
+
+
+// Included Graphics Library Dependencies
+#include <SFML/Graphics.hpp>
+
+
+// Included Local Dependencies
+#include "tileGrid.h"
+#include "profiler.h"
+#include "jobSystem.h"
+
+
+/**
+ * Class Name: LevelLibrary
+ * Brief: Index of the .maze files in a directory, with metadata and thumbnails.
+ * Description:
+ *  Keeps the grid size, tile counts and a thumbnail of every level in an
+ *  index file next to the levels, so listing them only has to read one small
+ *  file and look at the modification time and size of each level. Levels
+ *  that are new or changed since they were indexed are read on the job
+ *  system, one job per level, and their entries are filled in as the jobs'
+ *  completions run on the main thread.
+ *  Thumbnails hold one tile type per pixel rather than colors, so they stay
+ *  small on disk and are colored when they are drawn.
+ */
+class LevelLibrary
+{
+public:
+    static const unsigned int THUMBNAIL_SIZE = 64;  // Width and height of a thumbnail in pixels.
+
+    // Everything the library knows about one level
+    struct Entry
+    {
+        std::string fileName;           // Name of the file inside the library directory.
+        std::int64_t modified = 0;      // Modification time the entry was made from.
+        std::uint64_t fileSize = 0;     // File size the entry was made from.
+        std::uint32_t gridSize = 0;
+        std::array<std::uint64_t, TileGrid::TYPE_COUNT> typeCounts{};
+        std::vector<unsigned char> thumbnail;   // Tile types, row by row. Empty until the level is indexed.
+        bool indexed = false;           // False while the level is waiting to be read.
+    };
+
+    // Constructor and Destructor
+    LevelLibrary(const std::string& directory, std::shared_ptr<JobSystem> jobs);
+    ~LevelLibrary();
+    LevelLibrary(const LevelLibrary&) = delete;            // copy constructor
+    LevelLibrary(LevelLibrary&&) = delete;                 // move constructor
+    LevelLibrary& operator=(const LevelLibrary&) = delete; // copy assignment
+    LevelLibrary& operator=(LevelLibrary&&) = delete;      // move assignment
+
+    // Public Member Functions for LevelLibrary Processes
+    std::vector<std::size_t> update();      // Takes the levels the jobs finished, returning which entries changed.
+    const std::vector<Entry>& entries() const {return m_entries;}
+    std::string path(std::size_t index) const {return m_directory + "/" + m_entries[index].fileName;}
+    std::size_t pending() const {return m_pending;}
+
+
+private:
+    // Private Member Functions for LevelLibrary Processes
+    void readIndex();           // Reads the entries of the index file.
+    void writeIndex();          // Writes every indexed entry to the index file.
+    void scan();                // Lists the levels in the directory and queues the ones the index is out of date for.
+    static void indexLevel(const std::string& path, Entry& entry);          // Reads a level and fills in its metadata and thumbnail.
+    static void makeThumbnail(const TileGrid& level, Entry& entry);        // Shrinks the painted part of a level into a thumbnail.
+
+    // Private Member Constants
+    static constexpr const char* INDEX_FILE_NAME = "index.lib";    // Kept inside the library directory.
+
+    // A level being read and the job reading it
+    struct Indexing
+    {
+        JobSystem::JobHandle job;
+        std::shared_ptr<Entry> entry;   // Written by the job, reset once its completion took the entry.
+    };
+
+    // Private Member Variables
+    std::shared_ptr<JobSystem> m_jobs;
+    std::string m_directory;
+    std::vector<Entry> m_entries;       // Sorted by file name.
+    std::size_t m_pending;              // Queued levels not taken back by update() yet.
+    bool m_indexChanged;
+    std::vector<Indexing> m_indexing;   // Every level queued since the library was idle.
+    std::vector<Entry> m_finished;      // Levels whose completion ran but that update() has not taken yet.
+};
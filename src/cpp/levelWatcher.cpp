@@ -0,0 +1,257 @@
+#include "levelWatcher.h"
+
+
+/**
+ * @brief LevelWatcher class constructor
+ * @details Nothing is watched until watch() is called.
+ * @throw None
+ */
+LevelWatcher::LevelWatcher() :
+m_stopping(false),
+m_inotify(-1),
+m_wakePipe{-1, -1}
+{
+}
+
+
+/**
+ * @brief Destructor for the LevelWatcher class.
+ * @details Wakes the background thread up and waits for it to finish. A
+ * reload that was never taken is dropped.
+ * @throw None
+ */
+LevelWatcher::~LevelWatcher()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_wake.notify_one();
+#ifdef __linux__
+    if (m_wakePipe[1] != -1)
+    {
+        char wake = 0;
+        (void)write(m_wakePipe[1], &wake, 1);
+    }
+#endif
+    if (m_thread.joinable())
+    {
+        m_thread.join();
+    }
+#ifdef __linux__
+    for (int fd : {m_inotify, m_wakePipe[0], m_wakePipe[1]})
+    {
+        if (fd != -1)
+        {
+            close(fd);
+        }
+    }
+#endif
+}
+
+
+/**
+ * @brief Starts watching a level file.
+ * @details The directory is watched rather than the file itself, since a
+ * file that is replaced by renaming a new one over it would otherwise stop
+ * being watched. If inotify is not available the modification time of the
+ * file is polled instead. Must only be called once.
+ * @throw std::system_error if the background thread cannot be started.
+ * @param fileName - the .maze file being played.
+ * @param level - the level as it was read from the file, which changes are
+ * compared against. Its tiles are shared, not copied.
+ * @return None
+ */
+void LevelWatcher::watch(const std::string& fileName, const TileGrid& level)
+{
+    m_fileName = fileName;
+    m_lastLevel = level;
+    std::error_code error;
+    m_lastWriteTime = std::filesystem::last_write_time(fileName, error);
+
+#ifdef __linux__
+    std::filesystem::path directory = std::filesystem::path(fileName).parent_path();
+    m_inotify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (m_inotify != -1 && (pipe(m_wakePipe) != 0 ||
+        inotify_add_watch(m_inotify, directory.empty() ? "." : directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) == -1))
+    {
+        close(m_inotify);
+        m_inotify = -1; // fall back to polling
+    }
+#endif
+
+    m_thread = std::thread(&LevelWatcher::run, this);
+}
+
+
+/**
+ * @brief Returns the changes read since the last call.
+ * @details Meant to be called between frames, so the level is never changed
+ * halfway through one.
+ * @throw None
+ * @param None
+ * @return std::optional<Reload> - the new version of the level, or nothing if
+ * the file has not changed
+ */
+std::optional<LevelWatcher::Reload> LevelWatcher::takeReload()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    std::optional<Reload> reload = std::move(m_reload);
+    m_reload.reset();
+    return reload;
+}
+
+
+/**
+ * @brief Body of the background thread.
+ * @details Reloads the file every time it changes until the watcher is
+ * destroyed.
+ * @throw None
+ * @param None
+ * @return None
+ */
+void LevelWatcher::run()
+{
+    while (waitForChange())
+    {
+        reload();
+    }
+}
+
+
+/**
+ * @brief Sleeps until the file has changed and settled, or the watcher stops.
+ * @details Once the file changes, further changes are waited out until
+ * SETTLE_MS pass without one, so a file written in several parts is only read
+ * once it is complete.
+ * @throw None
+ * @param None
+ * @return bool - true if the file changed, false if the watcher is stopping
+ */
+bool LevelWatcher::waitForChange()
+{
+#ifdef __linux__
+    if (m_inotify != -1)
+    {
+        std::string name = std::filesystem::path(m_fileName).filename().string();
+        pollfd fds[2] = {{m_inotify, POLLIN, 0}, {m_wakePipe[0], POLLIN, 0}};
+        bool changed = false;
+        while (!isStopping())
+        {
+            int ready = poll(fds, 2, changed ? SETTLE_MS : -1);
+            if (ready == 0)
+            {
+                return true; // nothing happened for SETTLE_MS since the last change
+            }
+            if (ready < 0 || (fds[1].revents & POLLIN))
+            {
+                continue; // interrupted, or woken up to stop
+            }
+
+            alignas(inotify_event) char buffer[4096];
+            ssize_t length;
+            while ((length = read(m_inotify, buffer, sizeof(buffer))) > 0)
+            {
+                for (char* next = buffer; next < buffer + length; )
+                {
+                    inotify_event* event = reinterpret_cast<inotify_event*>(next);
+                    changed = changed || (event->len != 0 && name == event->name);
+                    next += sizeof(inotify_event) + event->len;
+                }
+            }
+        }
+        return false;
+    }
+#endif
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (!m_stopping)
+    {
+        m_wake.wait_for(lock, std::chrono::milliseconds(POLL_MS));
+        std::error_code error;
+        std::filesystem::file_time_type writeTime = std::filesystem::last_write_time(m_fileName, error);
+        if (!error && writeTime != m_lastWriteTime)
+        {
+            m_lastWriteTime = writeTime;
+            return true;
+        }
+    }
+    return false;
+}
+
+
+/**
+ * @brief Reads the file and queues the blocks that differ from the last version.
+ * @details A file that cannot be read, for example because it is still
+ * being written, is skipped; the write that completes it is seen as another
+ * change. A reload that has not been taken yet is merged with the new one.
+ * @throw std::bad_alloc if the level cannot be allocated.
+ * @param None
+ * @return None
+ */
+void LevelWatcher::reload()
+{
+    PROFILE_ZONE("LevelWatcher::reload");
+    TileGrid level;
+    if (!level.loadFromFile(m_fileName))
+    {
+        return;
+    }
+
+    const unsigned int chunk = TileGrid::CHANGE_CHUNK;
+    unsigned int size = level.size();
+    unsigned int chunksPerSide = (size + chunk - 1) / chunk;
+    Reload next{level, std::vector<bool>(static_cast<std::size_t>(chunksPerSide) * chunksPerSide, true),
+                size != m_lastLevel.size()};
+    bool changed = next.resized;
+    if (!next.resized)
+    {
+        for (std::size_t i = 0; i < next.changedChunks.size(); ++i)
+        {
+            unsigned int firstX = (i / chunksPerSide) * chunk;
+            unsigned int firstY = (i % chunksPerSide) * chunk;
+            unsigned int length = std::min(chunk, size - firstY);
+            bool differs = false;
+            for (unsigned int x = firstX; x < std::min(firstX + chunk, size) && !differs; ++x)
+            {
+                std::size_t index = level.index(x, firstY);
+                differs = std::memcmp(level.data() + index, m_lastLevel.data() + index, length) != 0;
+            }
+            next.changedChunks[i] = differs;
+            changed = changed || differs;
+        }
+    }
+    m_lastLevel = level;
+    if (!changed)
+    {
+        return; // written again without changing, for example by a save in place
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_reload && (m_reload->resized || next.resized))
+    {
+        next.resized = true; // the level being played still has the size before the pending reload
+        next.changedChunks.assign(next.changedChunks.size(), true);
+    }
+    else if (m_reload)
+    {
+        for (std::size_t i = 0; i < next.changedChunks.size(); ++i)
+        {
+            next.changedChunks[i] = next.changedChunks[i] || m_reload->changedChunks[i];
+        }
+    }
+    m_reload = std::move(next);
+}
+
+
+/**
+ * @brief Returns whether the watcher is being destroyed.
+ * @throw None
+ * @param None
+ * @return bool - true once the destructor has started
+ */
+bool LevelWatcher::isStopping()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_stopping;
+}
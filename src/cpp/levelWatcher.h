@@ -0,0 +1,85 @@
+#pragma once
+
+
+// Included C++11 Libraries
+#include <vector>
+#include <string>
+#include <optional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <filesystem>
+#include <chrono>
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <poll.h>
+#include <unistd.h>
+#endif
+
+
+// Included Local Dependencies
+#include "tileGrid.h"
+#include "profiler.h"
+
+
+/**
+ * Class Name: LevelWatcher
+ * Brief: Reloads a .maze file on a background thread whenever it changes.
+ * Description:
+ *  Watches the directory of a level file with inotify on Linux (and by
+ *  polling the modification time elsewhere), so it sees the file both when
+ *  it is written in place and when a new file is renamed over it. Bursts of
+ *  writes are waited out before the file is read. The new tiles are
+ *  compared against the previous version of the file one CHANGE_CHUNK block
+ *  at a time, and only the blocks that differ are reported, so whoever
+ *  applies the reload can leave the rest of a level being played alone.
+ */
+class LevelWatcher
+{
+public:
+    // A new version of the level, waiting to be swapped in
+    struct Reload
+    {
+        TileGrid level;                     // The whole level as it is now on disk.
+        std::vector<bool> changedChunks;    // Blocks that differ, laid out like TileGrid::takeChangedChunks().
+        bool resized;                       // True if the grid size changed, in which case every block is new.
+    };
+
+    // Constructor and Destructor
+    LevelWatcher();
+    ~LevelWatcher();
+    LevelWatcher(const LevelWatcher&) = delete;            // copy constructor
+    LevelWatcher(LevelWatcher&&) = delete;                 // move constructor
+    LevelWatcher& operator=(const LevelWatcher&) = delete; // copy assignment
+    LevelWatcher& operator=(LevelWatcher&&) = delete;      // move assignment
+
+    // Public Member Functions for LevelWatcher Processes
+    void watch(const std::string& fileName, const TileGrid& level); // Starts watching a level file.
+    std::optional<Reload> takeReload();     // Returns the changes read since the last call.
+
+
+private:
+    // Private Member Functions for LevelWatcher Processes
+    void run();                 // Body of the background thread.
+    bool waitForChange();       // Sleeps until the file has changed and settled, or the watcher stops.
+    void reload();              // Reads the file and queues the blocks that differ from the last version.
+    bool isStopping();          // Returns whether the watcher is being destroyed.
+
+    // Private Member Constants
+    static constexpr int SETTLE_MS = 100;   // Quiet time after a change before the file is read.
+    static constexpr int POLL_MS = 500;     // How often the modification time is checked without inotify.
+
+    // Private Member Variables, guarded by m_mutex
+    std::mutex m_mutex;
+    std::condition_variable m_wake;     // Wakes the polling fallback up to stop.
+    std::optional<Reload> m_reload;
+    bool m_stopping;
+
+    // Only used by the background thread once it is started
+    std::string m_fileName;
+    TileGrid m_lastLevel;       // The file as it was last read.
+    std::filesystem::file_time_type m_lastWriteTime;
+    int m_inotify;              // inotify descriptor, -1 without inotify
+    int m_wakePipe[2];          // Written to by the destructor to wake the thread up.
+    std::thread m_thread;
+};
@@ -2,7 +2,9 @@
 #include <SFML/Graphics.hpp>
 #include <memory>
 #include "game.h"
+#include "soakTest.h"
 #include <iostream>
+#include <string>
 
 
 /**
@@ -12,22 +14,56 @@
  * the game, until the game loop has ended. The entire game and all of the main
  * function's dependencies can be compiled by entering:
  * g++ -std=c++14 main.cpp game.cpp menu.cpp mazeBuilder.cpp gameplay.cpp -o main.exe -LC:/sfml/lib/ -IC:/sfml/include/ -lsfml-graphics -lsfml-window -lsfml-system -lsfml-audio
+ * While the game is idle (a menu, the pause or settings screen, or the maze
+ * builder waiting for input), no frames are drawn until input arrives.
+ * Started with "--soak <minutes>", a scripted scenario is played in a hidden
+ * window instead, and frame time percentiles are printed at the end; adding
+ * "--check-allocations" also fails the test if an idle frame allocates. Started
+ * with "--profile", the profiler records from the first frame instead of
+ * waiting for F9. Started with "--skip-late-frames", frames that start more
+ * than a whole frame late are updated without being drawn.
  * @throw SFML exceptions may be thrown during fatal errors.
- * @param None
- * @return None
+ * @param argc - the number of arguments.
+ * @param argv - the arguments.
+ * @return int - 0, or the result of the soak test
  */
-int main()
+int main(int argc, char* argv[])
 {
+    if ((argc == 3 || (argc == 4 && std::string(argv[3]) == "--check-allocations")) && std::string(argv[1]) == "--soak")
+    {
+        SoakTest soakTest(std::stod(argv[2]), argc == 4);
+        return soakTest.run();
+    }
+    bool skipLateFrames = false;
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string argument = argv[i];
+        if (argument == "--profile")
+        {
+            Profiler::setEnabled(true);
+        }
+        else if (argument == "--skip-late-frames")
+        {
+            skipLateFrames = true;
+        }
+    }
+
     std::shared_ptr<sf::RenderWindow> window = std::make_shared<sf::RenderWindow>(sf::VideoMode(1000, 600), "Out of the Dark");
     Game game(window);
+    game.setSkipLateFrames(skipLateFrames);
 
     while(!game.isDone())
     {
+        if (game.isIdle() && !game.waitForInput())
+        {
+            continue; // nothing changed, so the last frame stays on screen
+        }
+        game.waitForFrame();
         game.clearScreen();
         game.handleInput();
         game.update();
         game.render();
-        window->display();
+        game.display();
     }
 
     return 0;
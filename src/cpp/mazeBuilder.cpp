@@ -8,12 +8,17 @@
  * @throw None
  * @param sf::RenderWindow* window - a pointer to a window. used for rendering sprites to screen
  * @param Settings* settings - a pointer to a Settings struct, used for editing and using setting info
+ * @param JobSystem* jobs - a pointer to the game's job system, used for loading assets and scanning the grid
  * @param float width - width of starting window (used for scaling)
  * @param float height - height of starting window (used for scaling)
  */
-MazeBuilder::MazeBuilder(std::shared_ptr<sf::RenderWindow> window, std::shared_ptr<Settings> settings, float width, float height) :
+MazeBuilder::MazeBuilder(std::shared_ptr<sf::RenderWindow> window, std::shared_ptr<Settings> settings, std::shared_ptr<JobSystem> jobs,
+                         float width, float height) :
 m_TEXTURE_COUNT(8),
-m_textures(8)
+m_textures(8),
+m_chunkCache(m_textures),
+m_history(HISTORY_MEMORY_LIMIT),
+m_journal(AUTOSAVE_SNAPSHOT, AUTOSAVE_JOURNAL)
 {
     m_window = window;
     m_width = width;
@@ -22,6 +27,7 @@ m_textures(8)
     m_sectionName = SectionName::MazeBuilder;
     m_backgroundTexture = std::make_unique<sf::Texture>();
     m_settings = settings;
+    m_jobs = jobs;
 
     load();
 
@@ -34,13 +40,27 @@ m_textures(8)
     m_mazeOrigin.y = 0.1 * m_height; // top edge of grid
     m_squareSize = static_cast<float>(std::max(m_width - m_mazeOrigin.x, m_height - m_mazeOrigin.y)) / m_squaresToDisplay;
 
+    // view that clips everything drawn on the grid to the grid area
+    sf::FloatRect gridArea(m_mazeOrigin.x, m_mazeOrigin.y, m_width - m_mazeOrigin.x, m_height - m_mazeOrigin.y);
+    m_gridView.reset(gridArea);
+    m_gridView.setViewport(sf::FloatRect(gridArea.left / m_width, gridArea.top / m_height,
+                                         gridArea.width / m_width, gridArea.height / m_height));
+
     // highlighted square when mouse is on grid
     m_highlightedGridRect = sf::RectangleShape(sf::Vector2f(m_squareSize, m_squareSize));
     m_highlightedGridRect.setFillColor(sf::Color(230, 230, 220, 150));
+    m_toolPreviewRect.setFillColor(sf::Color(230, 230, 220, 100));
+    m_selectionRect.setFillColor(sf::Color::Transparent);
+    m_selectionRect.setOutlineColor(sf::Color(230, 230, 220));
+    m_selectionRect.setOutlineThickness(-2.0f);
+    m_tool = EditTool::Brush;
+    m_brushSize = 1;
+    m_toolType = TileGrid::WALL;
 
     // sets texture to 0 (first texture)
     m_selectedTextureIndex = 0;
     m_textureSize = 250.0f; // size of texture (250x250)
+    updateTileScale();
     populateGrid();
     m_highlightedGridIndex.x = -1;
     m_highlightedGridIndex.y = -1;
@@ -54,6 +74,12 @@ m_textures(8)
     m_textureHighlightRect = sf::RectangleShape(sf::Vector2f(0.16 * m_width, 0.08 * m_height));
     m_textureHighlightRect.setFillColor(sf::Color(230, 230, 220, 150));
     m_textureHighlightRect.setPosition(0.033*m_width, 0.11*m_height);
+
+    // an autosave is only left behind if the last session ended with unsaved changes
+    if (m_journal.hasRecovery())
+    {
+        m_screenName = "recover_screen";
+    }
 }
 
 
@@ -77,12 +103,8 @@ MazeBuilder::~MazeBuilder()
  */
 void MazeBuilder::load()
 {
+    PROFILE_ZONE("MazeBuilder::load");
 
-    if (!m_backgroundTexture->loadFromFile("../assets/maze_builder_background.png"))
-    {
-        std::exit(1);   
-    }
-    m_backgroundSprite.setTexture(*m_backgroundTexture);
 
     if (!m_font.loadFromFile("../assets/rm_typerighter.ttf"))
     {
@@ -92,7 +114,23 @@ void MazeBuilder::load()
     m_gridLocation.setFont(m_font);
     m_gridLocation.setCharacterSize(24);
     m_gridLocation.setFillColor(sf::Color::White);
-    m_gridLocation.setPosition(0.82*m_width, 0.95*m_height);
+    m_gridLocation.setPosition(0.68*m_width, 0.95*m_height);
+
+    // text at bottom left for telling the size of the painted maze
+    m_gridContent.setFont(m_font);
+    m_gridContent.setCharacterSize(24);
+    m_gridContent.setFillColor(sf::Color::White);
+    m_gridContent.setPosition(0.21*m_width, 0.95*m_height);
+
+    // prompt shown when there is an autosave to recover
+    m_recoveryText.setFont(m_font);
+    m_recoveryText.setCharacterSize(36);
+    m_recoveryText.setFillColor(sf::Color::White);
+    m_recoveryText.setOutlineColor(sf::Color::Black);
+    m_recoveryText.setOutlineThickness(3);
+    m_recoveryText.setString("Unsaved changes from the last session were found.\n"
+                             "Press Y to recover them or N to discard them.");
+    m_recoveryText.setPosition(0.25*m_width, 0.45*m_height);
 
 
     for (unsigned int i=0; i < m_TEXTURE_COUNT; ++i)
@@ -101,39 +139,51 @@ void MazeBuilder::load()
     }
         std::cout << m_textures.size();
 
-    if (!m_textures[0]->loadFromFile("../assets/blue_floor_texture.png"))
-    {
-        std::exit(1);
-    }
-
-
-    if (!m_textures[1]->loadFromFile("../assets/blue_floor_trapped_texture.png"))
-    {
-        std::exit(1);
-    }
-    if (!m_textures[2]->loadFromFile("../assets/blue_floor_fire_texture.png"))
-    {
-        std::exit(1);
-    }
-    if (!m_textures[3]->loadFromFile("../assets/death_texture.png"))
-    {
-        std::exit(1);
-    }
-    if (!m_textures[4]->loadFromFile("../assets/wall_texture.png"))
-    {
-        std::exit(1);
-    }
-    if (!m_textures[5]->loadFromFile("../assets/alien_texture.png"))
+    // the files are decoded in parallel, see Section::loadTextures()
+    const char* failed = loadTextures({{m_backgroundTexture.get(), "maze_builder_background.png"},
+                                       {m_textures[0].get(), "blue_floor_texture.png"},
+                                       {m_textures[1].get(), "blue_floor_trapped_texture.png"},
+                                       {m_textures[2].get(), "blue_floor_fire_texture.png"},
+                                       {m_textures[3].get(), "death_texture.png"},
+                                       {m_textures[4].get(), "wall_texture.png"},
+                                       {m_textures[5].get(), "alien_texture.png"},
+                                       {m_textures[6].get(), "start_texture.png"},
+                                       {m_textures[7].get(), "end_texture.png"}});
+    if (failed)
     {
+        std::cout << "MazeBuilder: Failed to load asset '" << failed << "'\n";
         std::exit(1);
     }
-    if (!m_textures[6]->loadFromFile("../assets/start_texture.png"))
+    m_backgroundSprite.setTexture(*m_backgroundTexture);
+    std::size_t textureBytes = MemoryTracker::textureBytes(*m_backgroundTexture);
+    for (const std::unique_ptr<sf::Texture>& texture : m_textures)
     {
-        std::exit(1);
+        textureBytes += MemoryTracker::textureBytes(*texture);
     }
-    if (!m_textures[7]->loadFromFile("../assets/end_texture.png"))
+    m_textureMemory.set(textureBytes);
+
+    m_tileSprites.resize(m_TEXTURE_COUNT);
+    m_tileColors.resize(m_TEXTURE_COUNT);
+    for (unsigned int i=0; i < m_TEXTURE_COUNT; ++i)
     {
-        std::exit(1);
+        m_tileSprites[i].setTexture(*m_textures[i]);
+
+        // average color of the texture, used when a tile is smaller than a pixel or two
+        sf::Image image = m_textures[i]->copyToImage();
+        unsigned int red = 0, green = 0, blue = 0, samples = 0;
+        for (unsigned int x = 0; x < image.getSize().x; x += 5)
+        {
+            for (unsigned int y = 0; y < image.getSize().y; y += 5)
+            {
+                sf::Color pixel = image.getPixel(x, y);
+                red += pixel.r;
+                green += pixel.g;
+                blue += pixel.b;
+                ++samples;
+            }
+        }
+        samples = std::max(samples, 1u);
+        m_tileColors[i] = sf::Color(red / samples, green / samples, blue / samples);
     }
 
     loadSound(); // function to load sound (inherited from Section)
@@ -142,18 +192,76 @@ void MazeBuilder::load()
 
 /**
  * @brief Updates the MazeBuilder between input handling and rendering.
- * @details resets the position to the current texture rectangle based off of m_selectedTextureIndex,
+ * @details Paints the tiles the brush touched this frame, compacts the autosave journal when it is long,
+ * handles a finished background save, resets the position to the current texture rectangle based off of m_selectedTextureIndex,
  * and resets the string to print at the bottom right screen for the current block position based
- * off of the current m_highlightedGridRect coordinates.
+ * off of the current m_highlightedGridRect coordinates, along with the size of the painted maze.
+ * The strings are only rebuilt when something they show changed, in the FrameArena, so an idle
+ * frame does not allocate. Whether a save is running is read before taking its result, so
+ * isIdle() cannot stop the game with "Saving..." shown after the save finished.
  * @throw None
  * @param None
  * @return None
  */
 void MazeBuilder::update()
 {
+    applyStroke();
+    if (m_journal.needsCompaction())
+    {
+        m_journal.start(m_grid, m_mazeFileName);
+    }
+    bool saving = m_saver.isSaving(); // before finished(), so a save that is not saving any more has its result taken
+    if (std::optional<MazeSaver::Result> saved = m_saver.finished())
+    {
+        if (!saved->success)
+        {
+            m_grid.markAllChanged(); // the next save has to write everything
+        }
+        else if (saved->revision == m_grid.revision())
+        {
+            m_journal.discard(); // everything is on disk now
+        }
+    }
 
-    m_gridLocation.setString("Current position: (" + std::to_string(m_highlightedGridIndex.x)
-                             + ", " + std::to_string(m_highlightedGridIndex.y) + ")");
+    StatusKey status{m_tool, m_brushSize, m_highlightedGridIndex, m_grid.revision(), saving};
+    if (m_statusKey == status)
+    {
+        return; // nothing shown at the bottom changed
+    }
+    m_statusKey = status;
+
+    static const char* TOOL_NAMES[] = {"Brush", "Fill", "Rectangle", "Line", "Select", "Paste"};
+    FrameString text = "Tool: ";
+    text += TOOL_NAMES[static_cast<int>(m_tool)];
+    if (m_tool == EditTool::Brush)
+    {
+        text += " ";
+        text += std::to_string(m_brushSize);
+        text += "x";
+        text += std::to_string(m_brushSize);
+    }
+    text += "   Current position: (";
+    text += std::to_string(m_highlightedGridIndex.x);
+    text += ", ";
+    text += std::to_string(m_highlightedGridIndex.y);
+    text += ")";
+    m_gridLocation.setString(text.c_str());
+
+    text = "Maze size: empty";
+    if (m_grid.hasContent())
+    {
+        text = "Maze size: ";
+        text += std::to_string(m_grid.contentRight() - m_grid.contentLeft() + 1);
+        text += "x";
+        text += std::to_string(m_grid.contentBottom() - m_grid.contentTop() + 1);
+        text += "   Painted tiles: ";
+        text += std::to_string(m_grid.contentCount());
+    }
+    if (saving)
+    {
+        text += "   Saving...";
+    }
+    m_gridContent.setString(text.c_str());
 }
 
 
@@ -167,6 +275,11 @@ void MazeBuilder::update()
  * previewing the maze if the preview button is pressed,
  * changing the highlightedSquare if the mosue moves to a different square,
  * changing the texture of the highlighted square if the left mouse button is down,
+ * changing the edit tool if the user presses B (brush), F (fill), R (rectangle), L (line) or E (select),
+ * undoing and redoing with ctrl+Z and ctrl+Y, copying and pasting with ctrl+C and ctrl+V,
+ * rotating and mirroring the pasted tiles with Q and M,
+ * saving the clipboard as a stamp with ctrl+S and loading stamps with ctrl+1 to ctrl+9,
+ * playtesting the maze with P,
  * and changing the upperLeftSquare if the user presses arrow keys or wasd keys
  * @throw None
  * @param None
@@ -175,13 +288,19 @@ void MazeBuilder::update()
 void MazeBuilder::handleInput()
 {
     sf::Event event;
-    while(m_window->pollEvent(event))
+    while(pollEvent(event))
     {
         if (event.type == sf::Event::Closed)    // Close window button clicked.
         {
             m_window->close();
         }
 
+        if (m_screenName == "recover_screen") // nothing else is possible until the user answers
+        {
+            handleRecovery(event);
+            continue;
+        }
+
         if (event.type == sf::Event::MouseButtonPressed)
         {
             if (event.mouseButton.button == sf::Mouse::Left)
@@ -287,6 +406,18 @@ void MazeBuilder::handleInput()
             }
         }
 
+        if (event.type == sf::Event::MouseWheelScrolled && event.mouseWheelScroll.wheel == sf::Mouse::VerticalWheel)
+        {
+            // zoom around the mouse when it is on the grid, otherwise around the center of the grid
+            sf::Vector2f pixel(event.mouseWheelScroll.x * m_width / m_window->getSize().x,
+                               event.mouseWheelScroll.y * m_height / m_window->getSize().y);
+            if (pixel.x < m_mazeOrigin.x || pixel.y < m_mazeOrigin.y)
+            {
+                pixel = sf::Vector2f((m_mazeOrigin.x + m_width) / 2, (m_mazeOrigin.y + m_height) / 2);
+            }
+            zoom(std::pow(ZOOM_STEP, event.mouseWheelScroll.delta), pixel);
+        }
+
         handleMouse(event);
         handleKeyboard(event);
     }
@@ -303,38 +434,56 @@ void MazeBuilder::handleInput()
  */
 void MazeBuilder::render()
 {
-    m_window->draw(m_backgroundSprite);
-    m_window->draw(m_textureHighlightRect);
-    drawGrid();
+    draw(m_backgroundSprite);
+    draw(m_textureHighlightRect);
 
+    m_window->setView(m_gridView);
+    drawGrid();
+    drawToolPreview();
     if (m_highlightedGridIndex.x != -1) // if there is a highlighted grid square
     {
         highlightGridSquare();
     }
+    m_window->setView(m_window->getDefaultView());
+
+    draw(m_gridLocation);
+    draw(m_gridContent);
 
-    m_window->draw(m_gridLocation);
+    if (m_screenName == "recover_screen")
+    {
+        draw(m_recoveryText);
+    }
 }
 
 
 std::optional<sf::Vector2i> MazeBuilder::blockMouseIsOn() const
 {
-    // scales the position of the mouse to m_width & m_height, since everything else is in terms of m_width and m_height
-    float mouseX = sf::Mouse::getPosition(*m_window).x;
-    float mouseY = sf::Mouse::getPosition(*m_window).y;
-    mouseX /= m_window->getSize().x;
-    mouseY /= m_window->getSize().y;
-    mouseX *= m_width;
-    mouseY *= m_height;
-
+    sf::Vector2f mouse = mousePosition();
+    if (mouse.x < m_mazeOrigin.x || mouse.y < m_mazeOrigin.y) // mouse is not on the grid area
+    {
+        return std::nullopt;
+    }
 
-    int x = ((mouseX - m_mazeOrigin.x)/ m_squareSize) + m_upperLeftSquare.x;
-    int y = ((mouseY - m_mazeOrigin.y) / m_squareSize) + m_upperLeftSquare.y;
-    if (x >= m_upperLeftSquare.x + m_squaresToDisplay || x < m_upperLeftSquare.x || 
-        y >= m_upperLeftSquare.y + m_squaresToDisplay || y < m_upperLeftSquare.y)
+    sf::Vector2i tile = tileUnderMouse();
+    if (tile.x < 0 || tile.y < 0 || tile.x >= static_cast<int>(m_grid.size()) || tile.y >= static_cast<int>(m_grid.size()))
     {
         return std::nullopt;
     }
-    return sf::Vector2i(x, y);
+    return tile;
+}
+
+
+/**
+ * @brief Returns the tile coordinates under the mouse, even outside of the grid.
+ * @throw None
+ * @param None
+ * @return sf::Vector2i - the tile coordinates, which may be out of range
+ */
+sf::Vector2i MazeBuilder::tileUnderMouse() const
+{
+    sf::Vector2f mouse = mousePosition();
+    return sf::Vector2i(std::floor((mouse.x - m_mazeOrigin.x) / m_squareSize + m_upperLeftSquare.x),
+                        std::floor((mouse.y - m_mazeOrigin.y) / m_squareSize + m_upperLeftSquare.y));
 }
 
 
@@ -348,27 +497,80 @@ std::optional<sf::Vector2i> MazeBuilder::blockMouseIsOn() const
  */
 void MazeBuilder::handleMouse(sf::Event& event)
 {
-    if (sf::Mouse::isButtonPressed(sf::Mouse::Left)) // if mouse left is down (not an event)
+    // the brush paints every tile between consecutive mouse samples, see applyStroke()
+    if (m_tool == EditTool::Brush)
     {
-        std::optional<sf::Vector2i> blockMouseOn = blockMouseIsOn();
-        if (blockMouseOn)
+        if (event.type == sf::Event::MouseButtonPressed &&
+            (event.mouseButton.button == sf::Mouse::Left || event.mouseButton.button == sf::Mouse::Right))
         {
-            m_grid[blockMouseOn->x][blockMouseOn->y].texture = m_selectedTextureIndex;
-            m_grid[blockMouseOn->x][blockMouseOn->y].sprite.setScale(m_squareSize/m_textureSize,
-                                                         m_squareSize/m_textureSize);
+            std::optional<sf::Vector2i> blockMouseOn = blockMouseIsOn();
+            if (blockMouseOn)
+            {
+                m_toolType = (event.mouseButton.button == sf::Mouse::Left) ? m_selectedTextureIndex : TileGrid::WALL;
+                m_strokeTile = blockMouseOn;
+                m_strokePoints.push_back(*blockMouseOn);
+            }
+        }
+        else if (event.type == sf::Event::MouseMoved && m_strokeTile)
+        {
+            queueStroke(tileUnderMouse());
+        }
+        else if (event.type == sf::Event::MouseButtonReleased && m_strokeTile)
+        {
+            applyStroke();
+            m_strokeTile.reset();
         }
-
     }
 
-    else if (sf::Mouse::isButtonPressed(sf::Mouse::Right)) // if mouse right is down (not an event)
+    // the other tools paint with the selected texture on left click and with walls on right click
+    else if (event.type == sf::Event::MouseButtonPressed &&
+             (event.mouseButton.button == sf::Mouse::Left || event.mouseButton.button == sf::Mouse::Right))
     {
         std::optional<sf::Vector2i> blockMouseOn = blockMouseIsOn();
         if (blockMouseOn)
         {
-            m_grid[blockMouseOn->x][blockMouseOn->y].texture = 4;
-            m_grid[blockMouseOn->x][blockMouseOn->y].sprite.setScale(m_squareSize/m_textureSize,
-                                                         m_squareSize/m_textureSize);
+            m_toolType = (event.mouseButton.button == sf::Mouse::Left) ? m_selectedTextureIndex : TileGrid::WALL;
+            if (m_tool == EditTool::Fill)
+            {
+                floodFill(blockMouseOn->x, blockMouseOn->y, m_toolType);
+            }
+            else if (m_tool == EditTool::Paste)
+            {
+                if (event.mouseButton.button == sf::Mouse::Left)
+                {
+                    pasteClipboard(*blockMouseOn);
+                }
+            }
+            else
+            {
+                m_toolAnchor = blockMouseOn;
+            }
+        }
+    }
+    else if (event.type == sf::Event::MouseButtonReleased && m_toolAnchor)
+    {
+        std::optional<sf::Vector2i> blockMouseOn = blockMouseIsOn();
+        if (blockMouseOn && m_tool == EditTool::Rectangle)
+        {
+            fillRectangle(*m_toolAnchor, *blockMouseOn, m_toolType);
         }
+        else if (blockMouseOn && m_tool == EditTool::Line)
+        {
+            drawLine(*m_toolAnchor, *blockMouseOn, m_toolType);
+        }
+        else if (blockMouseOn && m_tool == EditTool::Select)
+        {
+            m_selection = sf::IntRect(std::min(m_toolAnchor->x, blockMouseOn->x), std::min(m_toolAnchor->y, blockMouseOn->y),
+                                      std::abs(m_toolAnchor->x - blockMouseOn->x) + 1,
+                                      std::abs(m_toolAnchor->y - blockMouseOn->y) + 1);
+        }
+        m_toolAnchor.reset(); // releasing outside of the grid cancels
+    }
+
+    // a brush stroke lasts from pressing a mouse button until releasing it
+    if (event.type == sf::Event::MouseButtonReleased)
+    {
+        m_history.endStroke();
     }
 
     if (event.type == sf::Event::MouseMoved)
@@ -395,43 +597,113 @@ void MazeBuilder::handleMouse(sf::Event& event)
  */
 void MazeBuilder::handleKeyboard(sf::Event& event)
 {
-    if (event.type == sf::Event::KeyPressed)
+    if (event.type == sf::Event::KeyPressed && event.key.control)
+    {
+        if (event.key.code == sf::Keyboard::C)
+        {
+            copySelection();
+        }
+        else if (event.key.code == sf::Keyboard::V && !m_clipboard.empty())
+        {
+            m_tool = EditTool::Paste;
+        }
+        else if (event.key.code == sf::Keyboard::S)
+        {
+            saveStamp();
+        }
+        else if (event.key.code >= sf::Keyboard::Num1 && event.key.code <= sf::Keyboard::Num9)
+        {
+            loadStamp(event.key.code - sf::Keyboard::Num0);
+        }
+        else if (event.key.code == sf::Keyboard::Z && !event.key.shift)
+        {
+            undo();
+        }
+        else if (event.key.code == sf::Keyboard::Y || event.key.code == sf::Keyboard::Z)
+        {
+            redo();
+        }
+    }
+    else if (event.type == sf::Event::KeyPressed)
     {
+        if (event.key.code == sf::Keyboard::B || event.key.code == sf::Keyboard::F ||
+            event.key.code == sf::Keyboard::R || event.key.code == sf::Keyboard::L ||
+            event.key.code == sf::Keyboard::E)
+        {
+            applyStroke();
+            m_history.endStroke();
+            m_strokeTile.reset();
+            m_toolAnchor.reset();
+        }
+        if (event.key.code == sf::Keyboard::B)
+        {
+            m_tool = EditTool::Brush;
+        }
+        else if (event.key.code == sf::Keyboard::F)
+        {
+            m_tool = EditTool::Fill;
+        }
+        else if (event.key.code == sf::Keyboard::R)
+        {
+            m_tool = EditTool::Rectangle;
+        }
+        else if (event.key.code == sf::Keyboard::L)
+        {
+            m_tool = EditTool::Line;
+        }
+        else if (event.key.code == sf::Keyboard::E)
+        {
+            m_tool = EditTool::Select;
+        }
+        else if (event.key.code == sf::Keyboard::Q && m_tool == EditTool::Paste)
+        {
+            m_clipboard.rotate();
+        }
+        else if (event.key.code == sf::Keyboard::M && m_tool == EditTool::Paste)
+        {
+            m_clipboard.mirror();
+        }
+        else if (event.key.code == sf::Keyboard::LBracket)
+        {
+            m_brushSize = std::max(m_brushSize - 1, 1);
+        }
+        else if (event.key.code == sf::Keyboard::RBracket)
+        {
+            m_brushSize = std::min(m_brushSize + 1, MAX_BRUSH_SIZE);
+        }
+        else if (event.key.code == sf::Keyboard::P)
+        {
+            startPlaytest();
+        }
+
+        // scroll further when zoomed out, so crossing the grid takes the same number of presses
+        float step = std::max(1.0f, std::floor(visibleTiles().width / 25.0f));
         if (event.key.code == sf::Keyboard::W || event.key.code == sf::Keyboard::Up)
         {
-            if (m_upperLeftSquare.y - 1 >= 0) // move up if possible
-            {
-                m_upperLeftSquare.y--;
-            }
+            m_upperLeftSquare.y -= step;
         }
         if (event.key.code == sf::Keyboard::A || event.key.code == sf::Keyboard::Left)
         {
-            if (m_upperLeftSquare.x - 1 >= 0) // move up if possible
-            {
-                m_upperLeftSquare.x--;
-            }
+            m_upperLeftSquare.x -= step;
         }
         if (event.key.code == sf::Keyboard::S || event.key.code == sf::Keyboard::Down)
         {
-            if (m_upperLeftSquare.y + m_squaresToDisplay < m_MAX_GRID_SIZE) // move up if possible
-            {
-                m_upperLeftSquare.y++;
-            }
+            m_upperLeftSquare.y += step;
         }
         if (event.key.code == sf::Keyboard::D || event.key.code == sf::Keyboard::Right)
         {
-            if (m_upperLeftSquare.x + m_squaresToDisplay < m_MAX_GRID_SIZE) // move up if possible
-            {
-                m_upperLeftSquare.x++;
-            }
+            m_upperLeftSquare.x += step;
         }
+        clampView(); // move only if possible
     }
 }
 
 
 /**
  * @brief Saves current maze data to a file.
- * @details Invokes a python script to open file explorer for user to save file. If a filename exists, it 
+ * @details The file is written by m_saver on a background thread from a
+ * snapshot of the grid, so editing can continue while it is saved; update()
+ * picks up the result. Invokes a python script to open file explorer for user to save file. If a filename exists, it 
  * has that as the default save name
  * @throw None
  * @param None
@@ -453,15 +725,11 @@ void MazeBuilder::generateFile()
     std::getline(file, m_mazeFileName);
     file.close();
 
-    file.open(m_mazeFileName, std::ios::out);
-    file << m_MAX_GRID_SIZE << '\n';
-    for (int x = 0; x < m_MAX_GRID_SIZE; ++x)
+    if (m_mazeFileName.empty()) // save dialog was cancelled
     {
-        for (int y = 0; y < m_MAX_GRID_SIZE; ++y)
-        {
-            file << m_grid[x][y].texture << '\n';
-        }
+        return;
     }
+    m_saver.save(m_grid, m_grid.snapshot(), m_grid.takeChangedChunks(), m_mazeFileName);
 }
 
 
@@ -482,64 +750,77 @@ void MazeBuilder::loadFromFile()
     getline(file, m_mazeFileName);
     file.close();
 
-    file.open(m_mazeFileName, std::ios::in);
-    file >> m_MAX_GRID_SIZE;
-    for (int x = 0; x < m_MAX_GRID_SIZE; ++x)
+    if (m_grid.loadFromFile(m_mazeFileName))
     {
-        for (int y = 0; y < m_MAX_GRID_SIZE; ++y)
-        {
-            file >> m_grid[x][y].texture;
-        }
+        m_MAX_GRID_SIZE = m_grid.size();
+        m_history.clear();
+        m_journal.discard();
+        rebuildCaches();
+        clampView();
     }
 }
 
 
 /**
  * @brief Populates the grid with default textures (wall).
- * @details Loops through the grid and creates a 2d array with proper textures and scales for walls
+ * @details Fills the grid with walls and rebuilds every cached rendering of
+ * it.
  * @throw None
  * @param None
  * @return None
  */
 void MazeBuilder::populateGrid()
 {
-    for (int x = 0; x < m_MAX_GRID_SIZE; ++x)
-    {
-        m_grid.push_back(std::vector<gridStruct>());
-        for (int y = 0; y < m_MAX_GRID_SIZE; ++y)
-        {
-            gridStruct currentStruct;
-            currentStruct.x = x;
-            currentStruct.y = y;
-            currentStruct.texture = 4;
-            currentStruct.sprite.setScale(m_squareSize/250.0f,
-                                           m_squareSize/250.0f);
-            m_grid[x].push_back(currentStruct);
-        }
-    }
+    m_grid.resize(m_MAX_GRID_SIZE, TileGrid::WALL);
+    m_history.clear();
+    rebuildCaches();
 }
 
 
 /**
  * @brief Draws the 2D grid of tiles.
- * @details Has a 2D nested for loop looping through all squares to display. It then sets the correct position and texture, and 
- * draws the sprite to the screen.
+ * @details The level of detail depends on the square size. Close up, the
+ * visible tiles are drawn one at a time with the shared sprite of each tile
+ * type. Further out, the pre-rendered chunks are drawn with one draw call per
+ * chunk, and when tiles are only a pixel or two wide the whole grid is drawn
+ * as a single image with one color per tile. None of these depend on per-tile
+ * sprite state, so zooming never touches the tiles.
  * @throw None
  * @param None
  * @return None
  */
 void MazeBuilder::drawGrid()
 {
-    for (int arr_x = m_upperLeftSquare.x; arr_x < (m_upperLeftSquare.x + m_squaresToDisplay); ++arr_x)
+    sf::IntRect tiles = visibleTiles();
+    if (m_squareSize < CHUNK_LOD_SIZE && m_overview.isValid())
     {
-        for (int arr_y = m_upperLeftSquare.y; arr_y < (m_upperLeftSquare.y + m_squaresToDisplay); ++arr_y)
-        {
-            float x_coords = (m_grid[arr_x][arr_y].x - m_upperLeftSquare.x) * m_squareSize + m_mazeOrigin.x;
-            float y_coords = (m_grid[arr_x][arr_y].y - m_upperLeftSquare.y) * m_squareSize + m_mazeOrigin.y;
-            m_grid[arr_x][arr_y].sprite.setPosition(x_coords, y_coords);
-            m_grid[arr_x][arr_y].sprite.setTexture(*m_textures[m_grid[arr_x][arr_y].texture]);
-            m_window->draw(m_grid[arr_x][arr_y].sprite);
+        m_overview.flush();
+        sf::Sprite overview(m_overview.getTexture());
+        overview.setScale(m_squareSize, m_squareSize);
+        overview.setPosition(m_mazeOrigin.x - m_upperLeftSquare.x * m_squareSize,
+                             m_mazeOrigin.y - m_upperLeftSquare.y * m_squareSize);
+        draw(overview);
+        return;
+    }
+    if (m_squareSize < TILE_LOD_SIZE)
+    {
+        m_chunkCache.draw(*m_window, m_grid, m_mazeOrigin, m_upperLeftSquare, tiles, m_squareSize);
+        return;
+    }
 
+    int firstX = std::max(tiles.left, 0);
+    int firstY = std::max(tiles.top, 0);
+    int lastX = std::min<int>(tiles.left + tiles.width, m_grid.size());
+    int lastY = std::min<int>(tiles.top + tiles.height, m_grid.size());
+    for (int arr_x = firstX; arr_x < lastX; ++arr_x)
+    {
+        for (int arr_y = firstY; arr_y < lastY; ++arr_y)
+        {
+            float x_coords = (arr_x - m_upperLeftSquare.x) * m_squareSize + m_mazeOrigin.x;
+            float y_coords = (arr_y - m_upperLeftSquare.y) * m_squareSize + m_mazeOrigin.y;
+            sf::Sprite& sprite = m_tileSprites[m_grid.get(arr_x, arr_y)];
+            sprite.setPosition(x_coords, y_coords);
+            draw(sprite);
         }
     }
 }
@@ -551,17 +832,17 @@ void MazeBuilder::drawGrid()
  * The Mouse coordinates are then scaled to fit the original screen size. The function then returns True if 
  * the mouse is in the boundaries of the block, False if not.
  * @throw None
- * @param const gridStruct& block - a gridStruct object to check if the mouse is on
+ * @param sf::Vector2i block - the indices of the block to check if the mouse is on
  * @return bool - True if the mouse is in the block parameter, False otherwise
  */
-bool MazeBuilder::isMouseOnBlock(const gridStruct& block) const
+bool MazeBuilder::isMouseOnBlock(sf::Vector2i block) const
 {
     float x_coords, y_coords;
     x_coords = (block.x - m_upperLeftSquare.x) * m_squareSize + m_mazeOrigin.x;
     y_coords = (block.y - m_upperLeftSquare.y) * m_squareSize + m_mazeOrigin.y;
 
-    float mouseX = sf::Mouse::getPosition(*m_window).x;
-    float mouseY = sf::Mouse::getPosition(*m_window).y;
+    float mouseX = mouseOnWindow().x;
+    float mouseY = mouseOnWindow().y;
 
     // scales mouse coords
     mouseX /= m_window->getSize().x;
@@ -591,21 +872,27 @@ bool MazeBuilder::isMouseOnBlock(const gridStruct& block) const
  */
 void MazeBuilder::highlightGridSquare()
 {
+    // the brush highlights every tile it would paint
+    int brushSize = (m_tool == EditTool::Brush) ? m_brushSize : 1;
+    int offset = (brushSize - 1) / 2;
+
     // gets location to be drawn on screen
-    float pixelX = (m_highlightedGridIndex.x - m_upperLeftSquare.x)*m_squareSize + m_mazeOrigin.x;
-    float pixelY = (m_highlightedGridIndex.y - m_upperLeftSquare.y)*m_squareSize + m_mazeOrigin.y;
+    float pixelX = (m_highlightedGridIndex.x - offset - m_upperLeftSquare.x)*m_squareSize + m_mazeOrigin.x;
+    float pixelY = (m_highlightedGridIndex.y - offset - m_upperLeftSquare.y)*m_squareSize + m_mazeOrigin.y;
 
+    m_highlightedGridRect.setSize(sf::Vector2f(brushSize * m_squareSize, brushSize * m_squareSize));
     m_highlightedGridRect.setPosition(pixelX, pixelY);
-    m_window->draw(m_highlightedGridRect);
+    draw(m_highlightedGridRect);
 }
 
 
 /**
  * @brief Resizes the square size and grid to preview most of the maze on one screen (either zooms in or out).
- * @details First, the m_screenName is set to "preview_screen". Then, the maze is iterated through using 2D
- * nested for loops, and the bottom, top, left, and right sides of the maze are found.
- * If not all of them are found, then the preview_screen cannot work and the function is exited.
- * the m_squaresToDisplay is updated based on the bottom, top, left, and right values, and the grid is resized.
+ * @details First, the m_screenName is set to "preview_screen". Then, the bottom, top, left, and right
+ * sides of the maze are read from the grid, which keeps them up to date as tiles are painted.
+ * If nothing has been painted, then the preview_screen cannot work and the function is exited.
+ * The square size is then chosen so that the painted area fits in the grid area. Only the
+ * shared tile sprites are rescaled.
  * @throw None
  * @param None
  * @return None
@@ -614,61 +901,26 @@ void MazeBuilder::toPreview()
 {
     m_screenName = "preview_screen";
 
-    int bottom = -1, top = -1, left = -1, right = -1;
-    
-    for (int i=0; i < m_MAX_GRID_SIZE; ++i)
-    {
-        for (int z=0; z < m_MAX_GRID_SIZE; ++z)
-        {
-            if (m_grid[i][z].texture != 4)
-            {
-                right = m_grid[i][z].x;
-                if (left == -1)
-                {
-                    left = m_grid[i][z].x;
-                }
-            }
-            if (m_grid[z][i].texture != 4)
-            {
-                bottom = m_grid[z][i].y;
-                if (top == -1)
-                {
-                    top = m_grid[z][i].y;
-                }
-            }
-        }
-    }
-    if (left == -1 || right == -1 || top == -1 || bottom == -1)
+    if (!m_grid.hasContent())
     {
         return;
     }
+    int left = m_grid.contentLeft();
+    int right = m_grid.contentRight();
+    int top = m_grid.contentTop();
+    int bottom = m_grid.contentBottom();
 
     float delta_x = right-left;
     float delta_y = bottom-top;
     float gridWidth = m_width - m_mazeOrigin.x;
     float gridHeight = m_height - m_mazeOrigin.y;
 
-    if (delta_x/gridWidth > delta_y/gridHeight) // if size of maze (in x) is greater than size of maze (in y) after both are scaled by width and height
-    {
-        m_squaresToDisplay = delta_x + 2; // min amount of squares needed to display
-    }
-    else
-    {
-        m_squaresToDisplay = delta_y*(gridWidth/gridHeight) + 1;
-
-    }
-    
-    m_squareSize = static_cast<float>(std::max(gridWidth, gridHeight)) / m_squaresToDisplay;
-    m_upperLeftSquare.x = left;
-    m_upperLeftSquare.y = top;
-    for (int i=0; i < m_MAX_GRID_SIZE; ++i)
-    {
-        for (int z = 0; z < m_MAX_GRID_SIZE; ++z)
-        {
-            m_grid[i][z].sprite.setScale(m_squareSize/250.0f,
-                                           m_squareSize/250.0f);
-        }
-    }
+    // min amount of squares needed to display, with a one square border
+    m_squareSize = std::min(gridWidth / (delta_x + 3), gridHeight / (delta_y + 3));
+    m_upperLeftSquare.x = left - 1;
+    m_upperLeftSquare.y = top - 1;
+    clampView();
+    updateTileScale();
     m_highlightedGridRect.setSize(sf::Vector2f(m_squareSize, m_squareSize));
 }
 
@@ -690,15 +942,786 @@ void MazeBuilder::toMain() // called after state machine is changed to main
     m_squareSize = static_cast<float>(std::max(m_width - m_mazeOrigin.x, m_height - m_mazeOrigin.y)) / m_squaresToDisplay;
     m_upperLeftSquare.x = m_MAX_GRID_SIZE/2;
     m_upperLeftSquare.y = m_MAX_GRID_SIZE/2;
-    for (int i=0; i < m_MAX_GRID_SIZE; ++i)
+    clampView();
+    updateTileScale();
+    m_highlightedGridRect.setSize(sf::Vector2f(m_squareSize, m_squareSize));
+
+}
+
+
+/**
+ * @brief Scales the tile sprites to the current square size.
+ * @details Only the shared sprite of each tile type is scaled, so changing
+ * the square size does not depend on the size of the grid.
+ * @throw None
+ * @param None
+ * @return None
+ */
+void MazeBuilder::updateTileScale()
+{
+    for (unsigned int i=0; i < m_tileSprites.size(); ++i)
     {
-        for (int z = 0; z < m_MAX_GRID_SIZE; ++z)
-        {
-            m_grid[i][z].sprite.setScale(m_squareSize/250.0f,
-                                           m_squareSize/250.0f);
-        }
+        m_tileSprites[i].setScale(m_squareSize/m_textureSize,
+                                  m_squareSize/m_textureSize);
     }
+}
+
+
+/**
+ * @brief Zooms the grid in or out, keeping the tile under a pixel in place.
+ * @details The square size is limited between the whole grid fitting in the
+ * grid area and a single tile filling it. Only the square size, the view
+ * position and the shared tile sprites change.
+ * @throw None
+ * @param factor - how much bigger the squares become (below 1 zooms out).
+ * @param pixel - the position to zoom around, scaled to m_width and m_height.
+ * @return None
+ */
+void MazeBuilder::zoom(float factor, sf::Vector2f pixel)
+{
+    float gridWidth = m_width - m_mazeOrigin.x;
+    float gridHeight = m_height - m_mazeOrigin.y;
+    float minSize = std::min(gridWidth, gridHeight) / m_grid.size();
+    float maxSize = std::max(gridWidth, gridHeight);
+
+    sf::Vector2f offset = pixel - m_mazeOrigin;
+    sf::Vector2f tile = m_upperLeftSquare + offset * (1.0f / m_squareSize);
+    m_squareSize = std::min(std::max(m_squareSize * factor, minSize), maxSize);
+    m_upperLeftSquare = tile - offset * (1.0f / m_squareSize);
+
+    clampView();
+    updateTileScale();
     m_highlightedGridRect.setSize(sf::Vector2f(m_squareSize, m_squareSize));
+}
 
+
+/**
+ * @brief Keeps the visible area from leaving the grid.
+ * @details If the grid is smaller than the grid area along an axis, it is
+ * centered along that axis instead.
+ * @throw None
+ * @param None
+ * @return None
+ */
+void MazeBuilder::clampView()
+{
+    float tilesWide = (m_width - m_mazeOrigin.x) / m_squareSize;
+    float tilesHigh = (m_height - m_mazeOrigin.y) / m_squareSize;
+    float size = m_grid.size();
+
+    if (tilesWide >= size)
+    {
+        m_upperLeftSquare.x = (size - tilesWide) / 2;
+    }
+    else
+    {
+        m_upperLeftSquare.x = std::min(std::max(m_upperLeftSquare.x, 0.0f), size - tilesWide);
+    }
+    if (tilesHigh >= size)
+    {
+        m_upperLeftSquare.y = (size - tilesHigh) / 2;
+    }
+    else
+    {
+        m_upperLeftSquare.y = std::min(std::max(m_upperLeftSquare.y, 0.0f), size - tilesHigh);
+    }
+}
+
+
+/**
+ * @brief Returns the tiles that are at least partially visible.
+ * @details The returned rectangle may extend past the edges of the grid.
+ * @throw None
+ * @param None
+ * @return sf::IntRect - the visible tiles
+ */
+sf::IntRect MazeBuilder::visibleTiles() const
+{
+    int left = std::floor(m_upperLeftSquare.x);
+    int top = std::floor(m_upperLeftSquare.y);
+    int right = std::ceil(m_upperLeftSquare.x + (m_width - m_mazeOrigin.x) / m_squareSize);
+    int bottom = std::ceil(m_upperLeftSquare.y + (m_height - m_mazeOrigin.y) / m_squareSize);
+    return sf::IntRect(left, top, right - left, bottom - top);
 }
 
+
+/**
+ * @brief Returns the mouse position scaled to m_width and m_height.
+ * @details Everything else is in terms of m_width and m_height, so the mouse
+ * position is scaled from the current window size.
+ * @throw None
+ * @param None
+ * @return sf::Vector2f - the scaled mouse position
+ */
+sf::Vector2f MazeBuilder::mousePosition() const
+{
+    sf::Vector2i mouse = mouseOnWindow();
+    return sf::Vector2f(mouse.x * m_width / m_window->getSize().x,
+                        mouse.y * m_height / m_window->getSize().y);
+}
+
+
+/**
+ * @brief Paints a tile and updates every cached rendering of it.
+ * @details Painting a tile with the type it already has does nothing.
+ * @throw std::bad_alloc if the change cannot be recorded.
+ * @param x - the x index of the tile.
+ * @param y - the y index of the tile.
+ * @param type - the new texture index of the tile.
+ * @param recordHistory - whether the change is added to the current brush stroke.
+ * @param markDirty - whether the chunk of the tile is marked for re-rendering. Callers
+ * changing many tiles at once can mark the whole block themselves instead.
+ * @return None
+ */
+void MazeBuilder::setTile(unsigned int x, unsigned int y, unsigned char type, bool recordHistory, bool markDirty)
+{
+    unsigned char old = m_grid.set(x, y, type);
+    if (old == type)
+    {
+        return;
+    }
+    if (recordHistory)
+    {
+        m_history.record(m_grid.index(x, y), old, type);
+    }
+    journalTile(x, y, type);
+    if (markDirty)
+    {
+        m_chunkCache.markDirty(x, y);
+    }
+    m_overview.setPixel(x, y, m_tileColors[type]);
+}
+
+
+/**
+ * @brief Paints part of a column, leaving the chunk cache to the caller.
+ * @details The column is written straight into the grid in one go. Every
+ * changed tile is added to the current brush stroke, and each run of changed
+ * tiles is handed to the overview and the autosave journal at once.
+ * @throw std::bad_alloc if the change cannot be recorded.
+ * @param x - the x index of the column.
+ * @param y - the y index of the first tile.
+ * @param length - the number of tiles.
+ * @param type - the new texture index of the tiles.
+ * @return None
+ */
+void MazeBuilder::fillColumn(unsigned int x, unsigned int y, unsigned int length, unsigned char type)
+{
+    m_fillBuffer.assign(length, type);
+    m_columnBuffer.resize(length);
+    m_grid.writeColumn(x, y, length, m_fillBuffer.data(), m_columnBuffer.data());
+
+    unsigned int runStart = 0;
+    for (unsigned int i = 0; i <= length; ++i)
+    {
+        if (i < length && m_columnBuffer[i] != type)
+        {
+            m_history.record(m_grid.index(x, y + i), m_columnBuffer[i], type);
+            continue;
+        }
+        if (i > runStart)
+        {
+            m_overview.fillColumn(x, y + runStart, i - runStart, m_tileColors[type]);
+            journalColumn(x, y + runStart, i - runStart, type);
+        }
+        runStart = i + 1;
+    }
+}
+
+
+/**
+ * @brief Rebuilds the chunk cache and the overview after the whole grid changed.
+ * @details The overview image starts out as walls, and the other tiles are
+ * written in bands of columns on the job system, so each job reads the grid
+ * in the order it is stored. The whole image is uploaded once at the end.
+ * @throw std::bad_alloc if the jobs cannot be allocated.
+ * @param None
+ * @return None
+ */
+void MazeBuilder::rebuildCaches()
+{
+    m_chunkCache.reset(m_grid.size());
+    if (!m_overview.create(m_grid.size(), m_tileColors[TileGrid::WALL]))
+    {
+        return;
+    }
+    m_jobs->parallelFor("MazeBuilder::rebuildCaches", m_grid.size(), OVERVIEW_COLUMNS_PER_JOB,
+                        [this](std::size_t first, std::size_t last)
+    {
+        for (unsigned int x = first; x < last; ++x)
+        {
+            for (unsigned int y = 0; y < m_grid.size(); ++y)
+            {
+                unsigned char type = m_grid.get(x, y);
+                if (type != TileGrid::WALL)
+                {
+                    m_overview.writePixel(x, y, m_tileColors[type]);
+                }
+            }
+        }
+    });
+    m_overview.upload();
+}
+
+
+/**
+ * @brief Reverts the latest brush stroke.
+ * @details Only the tiles changed by the stroke are touched.
+ * @throw None
+ * @param None
+ * @return None
+ */
+void MazeBuilder::undo()
+{
+    applyStroke();
+    m_strokeTile.reset();
+    m_history.undo([this](std::size_t index, unsigned char type)
+    {
+        setTile(index / m_grid.size(), index % m_grid.size(), type, false);
+    });
+}
+
+
+/**
+ * @brief Reapplies the latest undone brush stroke.
+ * @throw None
+ * @param None
+ * @return None
+ */
+void MazeBuilder::redo()
+{
+    applyStroke();
+    m_strokeTile.reset();
+    m_history.redo([this](std::size_t index, unsigned char type)
+    {
+        setTile(index / m_grid.size(), index % m_grid.size(), type, false);
+    });
+}
+
+
+/**
+ * @brief Replaces the connected region of one tile type.
+ * @details Scanline flood fill: every seed is extended up and down its
+ * column, which is contiguous in the grid, and one new seed is pushed for
+ * each run of matching tiles in the neighbouring columns. Each tile is read
+ * a handful of times at most, and every span is written with fillColumn(),
+ * so the grid, the overview, the journal and the chunk cache are updated
+ * once per span rather than once per tile. The fill is recorded as a single
+ * undoable stroke.
+ * @throw std::bad_alloc if the seed stack or the history cannot grow.
+ * @param x - the x index of the tile the fill starts at.
+ * @param y - the y index of the tile the fill starts at.
+ * @param type - the texture index to fill with.
+ * @return None
+ */
+void MazeBuilder::floodFill(int x, int y, unsigned char type)
+{
+    unsigned char target = m_grid.get(x, y);
+    if (target == type)
+    {
+        return;
+    }
+
+    int size = m_grid.size();
+    m_history.endStroke();
+    m_toolTiles.clear();
+    m_toolTiles.push_back(sf::Vector2i(x, y));
+    while (!m_toolTiles.empty())
+    {
+        sf::Vector2i seed = m_toolTiles.back();
+        m_toolTiles.pop_back();
+        if (m_grid.get(seed.x, seed.y) != target) // already filled from another seed
+        {
+            continue;
+        }
+
+        int top = seed.y;
+        int bottom = seed.y;
+        while (top > 0 && m_grid.get(seed.x, top - 1) == target)
+        {
+            --top;
+        }
+        while (bottom < size - 1 && m_grid.get(seed.x, bottom + 1) == target)
+        {
+            ++bottom;
+        }
+        fillColumn(seed.x, top, bottom - top + 1, type);
+        m_chunkCache.markDirty(sf::IntRect(seed.x, top, 1, bottom - top + 1));
+
+        for (int column = seed.x - 1; column <= seed.x + 1; column += 2)
+        {
+            if (column < 0 || column >= size)
+            {
+                continue;
+            }
+            bool inRun = false;
+            for (int i = top; i <= bottom; ++i)
+            {
+                bool matches = m_grid.get(column, i) == target;
+                if (matches && !inRun)
+                {
+                    m_toolTiles.push_back(sf::Vector2i(column, i));
+                }
+                inRun = matches;
+            }
+        }
+    }
+    m_history.endStroke();
+}
+
+
+/**
+ * @brief Fills every tile of a rectangle.
+ * @details The rectangle is filled column by column with fillColumn(), in
+ * the order the grid is stored, and the chunk cache is told about the whole
+ * block once. The fill is recorded as a single undoable stroke.
+ * @throw std::bad_alloc if the history cannot grow.
+ * @param from - one corner of the rectangle.
+ * @param to - the opposite corner of the rectangle.
+ * @param type - the texture index to fill with.
+ * @return None
+ */
+void MazeBuilder::fillRectangle(sf::Vector2i from, sf::Vector2i to, unsigned char type)
+{
+    m_history.endStroke();
+    sf::Vector2i first(std::min(from.x, to.x), std::min(from.y, to.y));
+    sf::Vector2i last(std::max(from.x, to.x), std::max(from.y, to.y));
+    for (int x = first.x; x <= last.x; ++x)
+    {
+        fillColumn(x, first.y, last.y - first.y + 1, type);
+    }
+    m_chunkCache.markDirty(sf::IntRect(first.x, first.y, last.x - first.x + 1, last.y - first.y + 1));
+    m_history.endStroke();
+}
+
+
+/**
+ * @brief Paints every tile on a line.
+ * @details Recorded as a single undoable stroke.
+ * @throw std::bad_alloc if the history cannot grow.
+ * @param from - the first tile of the line.
+ * @param to - the last tile of the line.
+ * @param type - the texture index to paint with.
+ * @return None
+ */
+void MazeBuilder::drawLine(sf::Vector2i from, sf::Vector2i to, unsigned char type)
+{
+    lineTiles(from, to);
+    m_history.endStroke();
+    for (const sf::Vector2i& tile : m_toolTiles)
+    {
+        setTile(tile.x, tile.y, type);
+    }
+    m_history.endStroke();
+}
+
+
+/**
+ * @brief Puts the tiles of a line in m_toolTiles.
+ * @details Uses Bresenham's algorithm, so consecutive tiles always touch.
+ * @throw std::bad_alloc if m_toolTiles cannot grow.
+ * @param from - the first tile of the line.
+ * @param to - the last tile of the line.
+ * @return None
+ */
+void MazeBuilder::lineTiles(sf::Vector2i from, sf::Vector2i to)
+{
+    m_toolTiles.clear();
+    int deltaX = std::abs(to.x - from.x);
+    int deltaY = -std::abs(to.y - from.y);
+    int stepX = from.x < to.x ? 1 : -1;
+    int stepY = from.y < to.y ? 1 : -1;
+    int error = deltaX + deltaY;
+    while (true)
+    {
+        m_toolTiles.push_back(from);
+        if (from == to)
+        {
+            break;
+        }
+        if (2 * error >= deltaY)
+        {
+            error += deltaY;
+            from.x += stepX;
+        }
+        if (2 * error <= deltaX)
+        {
+            error += deltaX;
+            from.y += stepY;
+        }
+    }
+}
+
+
+/**
+ * @brief Draws the rectangle or line that will be filled when the mouse is released.
+ * @details Also outlines the selection, and shows where the clipboard would
+ * be pasted while the paste tool is active.
+ * @throw None
+ * @param None
+ * @return None
+ */
+void MazeBuilder::drawToolPreview()
+{
+    if (m_selection)
+    {
+        m_selectionRect.setPosition((m_selection->left - m_upperLeftSquare.x) * m_squareSize + m_mazeOrigin.x,
+                                    (m_selection->top - m_upperLeftSquare.y) * m_squareSize + m_mazeOrigin.y);
+        m_selectionRect.setSize(sf::Vector2f(m_selection->width * m_squareSize, m_selection->height * m_squareSize));
+        draw(m_selectionRect);
+    }
+    if (m_highlightedGridIndex.x == -1)
+    {
+        return;
+    }
+    if (m_tool == EditTool::Paste)
+    {
+        m_toolPreviewRect.setPosition((m_highlightedGridIndex.x - m_upperLeftSquare.x) * m_squareSize + m_mazeOrigin.x,
+                                      (m_highlightedGridIndex.y - m_upperLeftSquare.y) * m_squareSize + m_mazeOrigin.y);
+        m_toolPreviewRect.setSize(sf::Vector2f(m_clipboard.width() * m_squareSize, m_clipboard.height() * m_squareSize));
+        draw(m_toolPreviewRect);
+    }
+    if (!m_toolAnchor)
+    {
+        return;
+    }
+
+    if (m_tool == EditTool::Rectangle || m_tool == EditTool::Select)
+    {
+        int left = std::min(m_toolAnchor->x, m_highlightedGridIndex.x);
+        int top = std::min(m_toolAnchor->y, m_highlightedGridIndex.y);
+        m_toolPreviewRect.setPosition((left - m_upperLeftSquare.x) * m_squareSize + m_mazeOrigin.x,
+                                      (top - m_upperLeftSquare.y) * m_squareSize + m_mazeOrigin.y);
+        m_toolPreviewRect.setSize(sf::Vector2f((std::abs(m_toolAnchor->x - m_highlightedGridIndex.x) + 1) * m_squareSize,
+                                               (std::abs(m_toolAnchor->y - m_highlightedGridIndex.y) + 1) * m_squareSize));
+        draw(m_toolPreviewRect);
+    }
+    else if (m_tool == EditTool::Line)
+    {
+        lineTiles(*m_toolAnchor, m_highlightedGridIndex);
+        m_toolPreviewRect.setSize(sf::Vector2f(m_squareSize, m_squareSize));
+        for (const sf::Vector2i& tile : m_toolTiles)
+        {
+            m_toolPreviewRect.setPosition((tile.x - m_upperLeftSquare.x) * m_squareSize + m_mazeOrigin.x,
+                                          (tile.y - m_upperLeftSquare.y) * m_squareSize + m_mazeOrigin.y);
+            draw(m_toolPreviewRect);
+        }
+    }
+}
+
+
+/**
+ * @brief Adds the line from the last brush sample to a tile to the pending stroke.
+ * @details Mouse samples can be many tiles apart when the mouse moves
+ * quickly, so every tile on the line between them is queued, not just the
+ * tile under the mouse. The line may leave the grid; those tiles are skipped
+ * when the stroke is applied.
+ * @throw std::bad_alloc if the pending stroke cannot grow.
+ * @param to - the tile under the newest mouse sample.
+ * @return None
+ */
+void MazeBuilder::queueStroke(sf::Vector2i to)
+{
+    if (to == *m_strokeTile)
+    {
+        return;
+    }
+    lineTiles(*m_strokeTile, to);
+    m_strokePoints.insert(m_strokePoints.end(), m_toolTiles.begin() + 1, m_toolTiles.end());
+    m_strokeTile = to;
+}
+
+
+/**
+ * @brief Paints every tile the brush touched since the last call.
+ * @details Called once per frame, so however many mouse samples arrived the
+ * grid is updated in one pass and the chunk cache is told about a single
+ * block of changed tiles. Each queued point paints a square of m_brushSize
+ * tiles centered on it, clipped to the grid.
+ * @throw std::bad_alloc if the history cannot grow.
+ * @param None
+ * @return None
+ */
+void MazeBuilder::applyStroke()
+{
+    if (m_strokePoints.empty())
+    {
+        return;
+    }
+
+    int size = m_grid.size();
+    int offset = (m_brushSize - 1) / 2;
+    sf::Vector2i first(size, size), last(-1, -1);
+    for (const sf::Vector2i& point : m_strokePoints)
+    {
+        int left = std::max(point.x - offset, 0);
+        int top = std::max(point.y - offset, 0);
+        int right = std::min(point.x - offset + m_brushSize, size);
+        int bottom = std::min(point.y - offset + m_brushSize, size);
+        for (int x = left; x < right; ++x)
+        {
+            for (int y = top; y < bottom; ++y)
+            {
+                setTile(x, y, m_toolType, true, false);
+            }
+        }
+        if (left < right && top < bottom)
+        {
+            first.x = std::min(first.x, left);
+            first.y = std::min(first.y, top);
+            last.x = std::max(last.x, right - 1);
+            last.y = std::max(last.y, bottom - 1);
+        }
+    }
+    m_strokePoints.clear();
+
+    if (last.x != -1)
+    {
+        m_chunkCache.markDirty(sf::IntRect(first.x, first.y, last.x - first.x + 1, last.y - first.y + 1));
+    }
+}
+
+
+/**
+ * @brief Copies the selected tiles to the clipboard.
+ * @details Each column of the selection is copied in one operation.
+ * @throw std::bad_alloc if the clipboard cannot be allocated.
+ * @param None
+ * @return None
+ */
+void MazeBuilder::copySelection()
+{
+    if (!m_selection)
+    {
+        return;
+    }
+    m_clipboard.resize(m_selection->width, m_selection->height);
+    for (int x = 0; x < m_selection->width; ++x)
+    {
+        m_grid.readColumn(m_selection->left + x, m_selection->top, m_selection->height, m_clipboard.column(x));
+    }
+}
+
+
+/**
+ * @brief Pastes the clipboard with its top left corner on a tile.
+ * @details The clipboard is clipped to the grid and written one column at a
+ * time straight into the grid. Only tiles that actually change are added
+ * to the history and the overview, and the chunk cache is told about the
+ * pasted block once. The paste is recorded as a single undoable stroke.
+ * @throw std::bad_alloc if the history cannot grow.
+ * @param topLeft - the tile the top left corner of the clipboard lands on.
+ * @return None
+ */
+void MazeBuilder::pasteClipboard(sf::Vector2i topLeft)
+{
+    int size = m_grid.size();
+    int firstX = std::max(topLeft.x, 0);
+    int firstY = std::max(topLeft.y, 0);
+    int lastX = std::min<int>(topLeft.x + m_clipboard.width(), size);
+    int lastY = std::min<int>(topLeft.y + m_clipboard.height(), size);
+    if (firstX >= lastX || firstY >= lastY)
+    {
+        return;
+    }
+
+    m_history.endStroke();
+    m_columnBuffer.resize(lastY - firstY);
+    for (int x = firstX; x < lastX; ++x)
+    {
+        const unsigned char* column = m_clipboard.column(x - topLeft.x) + (firstY - topLeft.y);
+        m_grid.writeColumn(x, firstY, lastY - firstY, column, m_columnBuffer.data());
+        for (int y = firstY; y < lastY; ++y)
+        {
+            unsigned char old = m_columnBuffer[y - firstY];
+            unsigned char type = column[y - firstY];
+            if (old != type)
+            {
+                m_history.record(m_grid.index(x, y), old, type);
+                m_overview.setPixel(x, y, m_tileColors[type]);
+                journalTile(x, y, type);
+            }
+        }
+    }
+    m_chunkCache.markDirty(sf::IntRect(firstX, firstY, lastX - firstX, lastY - firstY));
+    m_history.endStroke();
+}
+
+
+/**
+ * @brief Saves the clipboard to the stamp library.
+ * @details Stamps are numbered from 1, and the clipboard is saved under the
+ * first number that is not taken yet.
+ * @throw std::filesystem::filesystem_error if the stamp directory cannot be created.
+ * @param None
+ * @return None
+ */
+void MazeBuilder::saveStamp()
+{
+    if (m_clipboard.empty())
+    {
+        return;
+    }
+
+    std::filesystem::create_directories(STAMP_DIRECTORY);
+    unsigned int number = 1;
+    while (std::filesystem::exists(STAMP_DIRECTORY + std::string("stamp_") + std::to_string(number) + ".stamp"))
+    {
+        ++number;
+    }
+    if (m_clipboard.saveToFile(STAMP_DIRECTORY + std::string("stamp_") + std::to_string(number) + ".stamp"))
+    {
+        playClicked();
+    }
+}
+
+
+/**
+ * @brief Loads a stamp from the stamp library into the clipboard.
+ * @details Switches to the paste tool if the stamp exists.
+ * @throw std::bad_alloc if the stamp cannot be allocated.
+ * @param number - the number of the stamp.
+ * @return None
+ */
+void MazeBuilder::loadStamp(unsigned int number)
+{
+    if (m_clipboard.loadFromFile(STAMP_DIRECTORY + std::string("stamp_") + std::to_string(number) + ".stamp"))
+    {
+        m_tool = EditTool::Paste;
+        playClicked();
+    }
+}
+
+
+/**
+ * @brief Adds a changed tile to the autosave journal.
+ * @details The first change after the maze was saved or loaded starts a new
+ * autosave with a snapshot of the grid, which already contains the change.
+ * @throw std::bad_alloc if the journal cannot grow.
+ * @param x - the x index of the tile.
+ * @param y - the y index of the tile.
+ * @param type - the new texture index of the tile.
+ * @return None
+ */
+void MazeBuilder::journalTile(unsigned int x, unsigned int y, unsigned char type)
+{
+    if (!m_journal.isStarted())
+    {
+        m_journal.start(m_grid, m_mazeFileName);
+    }
+    else
+    {
+        m_journal.record(m_grid.index(x, y), type);
+    }
+}
+
+
+/**
+ * @brief Adds a run of a column changed to one type to the autosave journal.
+ * @details Works like journalTile(), but hands the whole run over at once.
+ * @throw std::bad_alloc if the journal cannot grow.
+ * @param x - the x index of the column.
+ * @param y - the y index of the first tile.
+ * @param length - the number of tiles.
+ * @param type - the new texture index of the tiles.
+ * @return None
+ */
+void MazeBuilder::journalColumn(unsigned int x, unsigned int y, unsigned int length, unsigned char type)
+{
+    if (!m_journal.isStarted())
+    {
+        m_journal.start(m_grid, m_mazeFileName);
+    }
+    else
+    {
+        m_journal.recordRun(m_grid.index(x, y), length, type);
+    }
+}
+
+
+/**
+ * @brief Asks whether to recover the autosave of an earlier session.
+ * @details Y loads the autosaved grid, N deletes it. Either way the maze
+ * builder then returns to its main screen.
+ * @throw None
+ * @param event - the event variable that is created upon input.
+ * @return None
+ */
+void MazeBuilder::handleRecovery(sf::Event& event)
+{
+    if (event.type != sf::Event::KeyPressed)
+    {
+        return;
+    }
+
+    if (event.key.code == sf::Keyboard::Y)
+    {
+        if (m_journal.recover(m_grid, m_mazeFileName))
+        {
+            m_MAX_GRID_SIZE = m_grid.size();
+            m_history.clear();
+            rebuildCaches();
+            m_journal.start(m_grid, m_mazeFileName);
+        }
+        playClicked();
+        toMain();
+    }
+    else if (event.key.code == sf::Keyboard::N)
+    {
+        m_journal.discard();
+        playClicked();
+        m_screenName = "main_screen";
+    }
+}
+
+
+/**
+ * @brief Hands the grid over to be played, starting at the cursor or the start tile.
+ * @details The player starts on the tile under the mouse if it can be stood
+ * on, otherwise on the maze start. Pending brush strokes are painted first.
+ * The Game then builds a Gameplay from grid() and playtestSpawn(), which
+ * shares the grid's tiles instead of copying them, and keeps this MazeBuilder
+ * alive until the playtest ends.
+ * @throw None
+ * @param None
+ * @return None
+ */
+void MazeBuilder::startPlaytest()
+{
+    applyStroke();
+    m_history.endStroke();
+    m_strokeTile.reset();
+    m_toolAnchor.reset();
+
+    sf::Vector2i tile = tileUnderMouse();
+    int size = m_grid.size();
+    if (tile.x >= 0 && tile.y >= 0 && tile.x < size && tile.y < size && m_grid.get(tile.x, tile.y) != TileGrid::WALL)
+    {
+        m_playtestSpawn = tile;
+    }
+    else
+    {
+        unsigned int x = 0, y = 0;
+        if (!m_grid.find(6, x, y))
+        {
+            std::cout << "MazeBuilder: Nothing to playtest from, place a maze start or point at a path\n";
+            return;
+        }
+        m_playtestSpawn = sf::Vector2i(x, y);
+    }
+    m_sectionName = SectionName::Playtest;
+}
+
+
+/**
+ * @brief Picks up editing again after a playtest.
+ * @details Everything else about the MazeBuilder was kept while the maze was
+ * being played, so only the section name has to be set back.
+ * @throw None
+ * @param None
+ * @return None
+ */
+void MazeBuilder::resume()
+{
+    m_sectionName = SectionName::MazeBuilder;
+}
@@ -8,6 +8,9 @@
 #include <fstream>
 #include <stdlib.h>
 #include <algorithm>
+#include <cmath>
+#include <optional>
+#include <filesystem>
 
 
 // Included Graphics Library Dependencies
@@ -18,21 +21,19 @@
 // Included Local Dependencies
 #include "section.h"
 #include "settings.h"
+#include "tileGrid.h"
+#include "chunkCache.h"
+#include "tileImage.h"
+#include "editHistory.h"
+#include "stamp.h"
+#include "editJournal.h"
+#include "mazeSaver.h"
+#include "frameArena.h"
 
 
-/**
- * Struct Name: gridStruct
- * Brief: Stores all data for a single square.
- * Description:
- *  Contains the index of the tile in the tile array, the type of tile, and
- *  the sprite texture of the tile.
- */
-struct gridStruct
+enum class EditTool
 {
-    unsigned int x;
-    unsigned int y;
-    unsigned int texture;
-    sf::Sprite sprite;
+    Brush, Fill, Rectangle, Line, Select, Paste
 };
 
 
@@ -48,7 +49,8 @@ class MazeBuilder: public Section
 {
 public:
     // Constructor and Destructor
-    MazeBuilder(std::shared_ptr<sf::RenderWindow> window, std::shared_ptr<Settings> settings, float width, float height);
+    MazeBuilder(std::shared_ptr<sf::RenderWindow> window, std::shared_ptr<Settings> settings, std::shared_ptr<JobSystem> jobs,
+                float width, float height);
     ~MazeBuilder();
     MazeBuilder(const MazeBuilder&) = delete;            // copy constructor
     MazeBuilder(MazeBuilder&&) = delete;                 // move constructor
@@ -60,9 +62,29 @@ public:
     virtual void update();          // Updates the MazeBuilder between input handling and rendering.
     virtual void handleInput();     // Polls input and updates screen based off of it.
     virtual void render();          // Renders the MazeBuilder screen.
+    virtual std::size_t gridMemory() const {return m_grid.memoryUsage();}
+    virtual bool isIdle() const {return m_statusKey && !m_statusKey->saving;}     // idle once the status is shown and no save is running
+    void resume();                  // Picks up editing again after a playtest.
+    const TileGrid& grid() const {return m_grid;}
+    sf::Vector2i playtestSpawn() const {return m_playtestSpawn;}
 
 
 private:
+    // What the texts at the bottom of the screen show
+    struct StatusKey
+    {
+        EditTool tool;
+        int brushSize;
+        sf::Vector2i tile;
+        unsigned long revision;
+        bool saving;
+        bool operator==(const StatusKey& other) const
+        {
+            return tool == other.tool && brushSize == other.brushSize && tile == other.tile
+                   && revision == other.revision && saving == other.saving;
+        }
+    };
+
     // Private Member Functions for General MazeBuilder Processes
     void handleMouse(sf::Event& event);      // Handels input specific to mouse, excluding virtual button presses.
     void handleKeyboard(sf::Event& event);   // Handles input specific to the keyboard.
@@ -71,26 +93,88 @@ private:
     void populateGrid();                    // Populates the grid with default textures (wall).
     void drawGrid();                        // Draws the 2D grid of tiles.
     std::optional<sf::Vector2i> blockMouseIsOn() const;  // returns block mouse is on
-    bool isMouseOnBlock(const gridStruct& block) const;     // Checks whether the mouse is currently on a passed tile.
+    sf::Vector2i tileUnderMouse() const;    // Returns the tile coordinates under the mouse, even outside of the grid.
+    bool isMouseOnBlock(sf::Vector2i block) const;          // Checks whether the mouse is currently on a passed tile.
     void highlightGridSquare();     // Draws the highlighted grid square to the screen.
     void toPreview();               // Resizes the square size and grid to preview most of the maze on one screen (either zooms in or out).
     void toMain();                  // Puts the maze builder back in main mode, from preview mode.
+    void updateTileScale();         // Scales the tile sprites to the current square size.
+    void zoom(float factor, sf::Vector2f pixel);    // Zooms the grid in or out, keeping the tile under a pixel in place.
+    void clampView();               // Keeps the visible area from leaving the grid.
+    sf::IntRect visibleTiles() const;               // Returns the tiles that are at least partially visible.
+    sf::Vector2f mousePosition() const;             // Returns the mouse position scaled to m_width and m_height.
+    void setTile(unsigned int x, unsigned int y, unsigned char type, bool recordHistory = true, bool markDirty = true);  // Paints a tile and updates every cached rendering of it.
+    void fillColumn(unsigned int x, unsigned int y, unsigned int length, unsigned char type);  // Paints part of a column, leaving the chunk cache to the caller.
+    void rebuildCaches();           // Rebuilds the chunk cache and the overview after the whole grid changed.
+    void undo();                    // Reverts the latest brush stroke.
+    void floodFill(int x, int y, unsigned char type);   // Replaces the connected region of one tile type.
+    void fillRectangle(sf::Vector2i from, sf::Vector2i to, unsigned char type);    // Fills every tile of a rectangle.
+    void drawLine(sf::Vector2i from, sf::Vector2i to, unsigned char type);         // Paints every tile on a line.
+    void lineTiles(sf::Vector2i from, sf::Vector2i to);  // Puts the tiles of a line in m_toolTiles.
+    void queueStroke(sf::Vector2i to);  // Adds the line from the last brush sample to a tile to the pending stroke.
+    void applyStroke();             // Paints every tile the brush touched since the last call.
+    void copySelection();           // Copies the selected tiles to the clipboard.
+    void pasteClipboard(sf::Vector2i topLeft);   // Pastes the clipboard with its top left corner on a tile.
+    void saveStamp();               // Saves the clipboard to the stamp library.
+    void loadStamp(unsigned int number);    // Loads a stamp from the stamp library into the clipboard.
+    void journalTile(unsigned int x, unsigned int y, unsigned char type);   // Adds a changed tile to the autosave journal.
+    void journalColumn(unsigned int x, unsigned int y, unsigned int length, unsigned char type);  // Adds a run of a column changed to one type to the autosave journal.
+    void handleRecovery(sf::Event& event);  // Asks whether to recover the autosave of an earlier session.
+    void startPlaytest();           // Hands the grid over to be played, starting at the cursor or the start tile.
+    void drawToolPreview();         // Draws the rectangle or line that will be filled when the mouse is released.
+    void redo();                    // Reapplies the latest undone brush stroke.
+
+    // Private Member Constants
+    static constexpr float TILE_LOD_SIZE = 16.0f;   // Smallest square size that draws individual tile sprites.
+    static constexpr float CHUNK_LOD_SIZE = 2.0f;   // Smallest square size that draws cached chunks, below it one color per tile is drawn.
+    static constexpr float ZOOM_STEP = 1.15f;       // Zoom factor of a single mouse wheel step.
+    static constexpr int MAX_BRUSH_SIZE = 16;       // Largest brush width and height in tiles.
+    static constexpr std::size_t OVERVIEW_COLUMNS_PER_JOB = 64;    // Columns of the overview each rebuildCaches() job writes.
+    static constexpr const char* STAMP_DIRECTORY = "../user_data/stamps/";   // Where the stamp library is kept.
+    static constexpr const char* AUTOSAVE_SNAPSHOT = "../user_data/autosave.snapshot";
+    static constexpr const char* AUTOSAVE_JOURNAL = "../user_data/autosave.journal";
+    static const std::size_t HISTORY_MEMORY_LIMIT = 32 * 1024 * 1024;   // Bytes of undo history kept.
 
     // Private SFML Member Variables
     std::unique_ptr<sf::Texture> m_backgroundTexture;
     sf::Sprite m_backgroundSprite;
-    sf::Vector2i m_upperLeftSquare;
+    sf::Vector2f m_upperLeftSquare;     // tile coordinates shown at m_mazeOrigin, fractional while zoomed
+    sf::View m_gridView;                // clips drawing to the grid area
     sf::Vector2f m_mazeOrigin;
     sf::RectangleShape m_textureHighlightRect;
     sf::RectangleShape m_highlightedGridRect;
     sf::Font m_font;
     sf::Text m_gridLocation;
+    sf::Text m_gridContent;
+    sf::Text m_recoveryText;
     sf::Vector2i m_highlightedGridIndex;
+    sf::Vector2i m_playtestSpawn;       // tile the player starts on when playtesting
+    sf::RectangleShape m_toolPreviewRect;
+    sf::RectangleShape m_selectionRect;
 
     // Private Gameplay Member Variables
     std::string m_mazeFileName;
     std::vector<std::unique_ptr<sf::Texture>> m_textures;
-    std::vector<std::vector<gridStruct>> m_grid;
+    std::vector<sf::Sprite> m_tileSprites;  // one sprite per tile type, shared by every tile
+    TileGrid m_grid;
+    ChunkCache m_chunkCache;
+    TileImage m_overview;                   // one pixel per tile, used when zoomed out the furthest
+    std::vector<sf::Color> m_tileColors;    // average color of each tile texture
+    EditHistory m_history;
+    EditJournal m_journal;
+    MazeSaver m_saver;
+    EditTool m_tool;
+    std::optional<sf::Vector2i> m_toolAnchor;   // tile the rectangle or line tool was pressed on
+    unsigned char m_toolType;                   // type the rectangle or line tool fills with
+    std::vector<sf::Vector2i> m_toolTiles;      // reused by the flood fill and line tools
+    std::optional<sf::Vector2i> m_strokeTile;   // last brush sample while a brush stroke is in progress
+    std::vector<sf::Vector2i> m_strokePoints;   // brush centers waiting to be painted this frame
+    int m_brushSize;
+    std::optional<StatusKey> m_statusKey;       // what the texts at the bottom were last built from
+    std::optional<sf::IntRect> m_selection;     // tiles chosen with the select tool
+    Stamp m_clipboard;
+    std::vector<unsigned char> m_columnBuffer;  // old tiles of the column being pasted over or filled
+    std::vector<unsigned char> m_fillBuffer;    // a column of the type being filled with
     unsigned int m_MAX_GRID_SIZE;
     unsigned int m_squaresToDisplay;
     unsigned int m_TEXTURE_COUNT; // num of textures blocks can be (fire, wall, etc.)
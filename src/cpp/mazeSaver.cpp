@@ -0,0 +1,255 @@
+#include "mazeSaver.h"
+
+
+/**
+ * @brief MazeSaver class constructor
+ * @details Starts the background thread, which sleeps until a save is queued.
+ * @throw std::system_error if the background thread cannot be started.
+ */
+MazeSaver::MazeSaver() :
+m_writing(false),
+m_stopping(false),
+m_savedSize(0)
+{
+    m_thread = std::thread(&MazeSaver::run, this);
+}
+
+
+/**
+ * @brief Destructor for the MazeSaver class.
+ * @details Finishes a queued or running save before returning, so leaving
+ * the editor never loses a save.
+ * @throw None
+ */
+MazeSaver::~MazeSaver()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_wake.notify_one();
+    m_thread.join();
+}
+
+
+/**
+ * @brief Queues a snapshot of a grid to be written to a file.
+ * @details Returns straight away. If a save is already queued it is
+ * replaced, keeping the changed blocks of both.
+ * @throw std::bad_alloc if the job cannot be allocated.
+ * @param grid - the grid being saved.
+ * @param tiles - a snapshot of the grid's tiles.
+ * @param changedChunks - the blocks changed since the last save, from TileGrid::takeChangedChunks().
+ * @param fileName - the .maze file to write.
+ * @return None
+ */
+void MazeSaver::save(const TileGrid& grid, TileGrid::Snapshot tiles, std::vector<bool> changedChunks,
+                     const std::string& fileName)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_job && m_job->changedChunks.size() == changedChunks.size())
+        {
+            for (std::size_t i = 0; i < changedChunks.size(); ++i)
+            {
+                changedChunks[i] = changedChunks[i] || m_job->changedChunks[i];
+            }
+        }
+        m_job = Job{tiles, grid.size(), grid.revision(), std::move(changedChunks), fileName};
+    }
+    m_wake.notify_one();
+}
+
+
+/**
+ * @brief Returns the result of a save that finished since the last call.
+ * @throw None
+ * @param None
+ * @return std::optional<Result> - the result, or nothing if no save finished
+ */
+std::optional<MazeSaver::Result> MazeSaver::finished()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    std::optional<Result> result = m_result;
+    m_result.reset();
+    return result;
+}
+
+
+/**
+ * @brief Returns whether a save is queued or being written.
+ * @throw None
+ * @param None
+ * @return bool - true while saving, false if idle
+ */
+bool MazeSaver::isSaving()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_job || m_writing;
+}
+
+
+/**
+ * @brief Body of the background thread.
+ * @details Writes queued saves one at a time until the saver is destroyed.
+ * @throw None
+ * @param None
+ * @return None
+ */
+void MazeSaver::run()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (true)
+    {
+        m_wake.wait(lock, [this] {return m_stopping || m_job;});
+        if (!m_job)
+        {
+            return; // stopping, and nothing left to save
+        }
+
+        Job job = std::move(*m_job);
+        m_job.reset();
+        m_writing = true;
+        lock.unlock();
+
+        bool success = false;
+        if (job.fileName == m_savedFileName && job.size == m_savedSize)
+        {
+            success = writeChanged(job);
+        }
+        if (!success)
+        {
+            success = writeWhole(job);
+        }
+        std::error_code error;
+        m_savedTime = std::filesystem::last_write_time(job.fileName, error);
+        m_savedFileName = (success && !error) ? job.fileName : "";
+        m_savedSize = job.size;
+
+        lock.lock();
+        m_writing = false;
+        m_result = Result{success, job.revision};
+    }
+}
+
+
+/**
+ * @brief Writes a whole new file and renames it into place.
+ * @details The file is formatted into a buffer and written with a single
+ * call, instead of one formatted write per tile.
+ * @throw std::bad_alloc if the buffer cannot be allocated.
+ * @param job - the save to write.
+ * @return bool - true if the file was written, false if not
+ */
+bool MazeSaver::writeWhole(const Job& job)
+{
+    PROFILE_ZONE("MazeSaver::writeWhole");
+    std::string header = std::to_string(job.size) + '\n';
+    const std::vector<unsigned char>& tiles = *job.tiles;
+    m_buffer.resize(header.size() + 2 * tiles.size());
+    std::copy(header.begin(), header.end(), m_buffer.begin());
+    char* out = m_buffer.data() + header.size();
+    for (std::size_t i = 0; i < tiles.size(); ++i)
+    {
+        out[2 * i] = '0' + tiles[i];
+        out[2 * i + 1] = '\n';
+    }
+
+    std::string tempFileName = job.fileName + ".tmp";
+    std::fstream file(tempFileName, std::ios::out | std::ios::binary | std::ios::trunc);
+    file.write(m_buffer.data(), m_buffer.size());
+    file.close();
+    if (!file)
+    {
+        std::remove(tempFileName.c_str());
+        return false;
+    }
+    return replaceFile(tempFileName, job.fileName);
+}
+
+
+/**
+ * @brief Patches the changed blocks into a copy of the file and renames it into place.
+ * @details Only used on a file this saver wrote, so every tile is known to
+ * be at header + 2 * index. A file whose size or modification time differs
+ * from the last save was changed by someone else, so it is rewritten whole
+ * instead. The copy is made by the file system, and each changed block is
+ * written into it one column span at a time. A crash before the rename
+ * leaves the previous file as it was.
+ * @throw None
+ * @param job - the save to write.
+ * @return bool - true if the file was patched, false if it has to be rewritten
+ */
+bool MazeSaver::writeChanged(const Job& job)
+{
+    PROFILE_ZONE("MazeSaver::writeChanged");
+    std::string header = std::to_string(job.size) + '\n';
+    std::error_code error;
+    if (std::filesystem::file_size(job.fileName, error) != header.size() + 2 * job.tiles->size() || error ||
+        std::filesystem::last_write_time(job.fileName, error) != m_savedTime || error)
+    {
+        return false; // changed by someone else since it was written
+    }
+    std::string tempFileName = job.fileName + ".tmp";
+    if (!std::filesystem::copy_file(job.fileName, tempFileName, std::filesystem::copy_options::overwrite_existing, error))
+    {
+        std::remove(tempFileName.c_str());
+        return false;
+    }
+    std::fstream file(tempFileName, std::ios::in | std::ios::out | std::ios::binary);
+
+    const unsigned int chunk = TileGrid::CHANGE_CHUNK;
+    unsigned int chunksPerSide = (job.size + chunk - 1) / chunk;
+    m_buffer.resize(2 * chunk);
+    for (std::size_t i = 0; i < job.changedChunks.size(); ++i)
+    {
+        if (!job.changedChunks[i])
+        {
+            continue;
+        }
+        unsigned int firstX = (i / chunksPerSide) * chunk;
+        unsigned int firstY = (i % chunksPerSide) * chunk;
+        unsigned int length = std::min(chunk, job.size - firstY);
+        for (unsigned int x = firstX; x < std::min(firstX + chunk, job.size); ++x)
+        {
+            std::size_t index = static_cast<std::size_t>(x) * job.size + firstY;
+            for (unsigned int y = 0; y < length; ++y)
+            {
+                m_buffer[2 * y] = '0' + (*job.tiles)[index + y];
+                m_buffer[2 * y + 1] = '\n';
+            }
+            file.seekp(header.size() + 2 * index);
+            file.write(m_buffer.data(), 2 * length);
+        }
+    }
+    file.close();
+    if (!file)
+    {
+        std::remove(tempFileName.c_str());
+        return false;
+    }
+    return replaceFile(tempFileName, job.fileName);
+}
+
+
+/**
+ * @brief Moves a finished temporary file over the file it replaces.
+ * @details std::filesystem::rename() replaces an existing file on every
+ * platform, unlike std::rename(), which fails on Windows when the target
+ * exists. The temporary file is removed if the rename fails.
+ * @throw None
+ * @param tempFileName - the file that was written.
+ * @param fileName - the file it replaces.
+ * @return bool - true if the file was replaced, false if not
+ */
+bool MazeSaver::replaceFile(const std::string& tempFileName, const std::string& fileName)
+{
+    std::error_code error;
+    std::filesystem::rename(tempFileName, fileName, error);
+    if (error)
+    {
+        std::filesystem::remove(tempFileName, error);
+        return false;
+    }
+    return true;
+}
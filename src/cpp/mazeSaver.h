@@ -0,0 +1,91 @@
+#pragma once
+
+
+// Included C++11 Libraries
+#include <vector>
+#include <string>
+#include <fstream>
+#include <cstdio>
+#include <optional>
+#include <filesystem>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+
+// Included Local Dependencies
+#include "tileGrid.h"
+#include "profiler.h"
+
+
+/**
+ * Class Name: MazeSaver
+ * Brief: Writes .maze files on a background thread.
+ * Description:
+ *  Saves a snapshot of a TileGrid so that the editor keeps running while the
+ *  file is written. Every tile of a .maze file is a single digit and a
+ *  newline, so each tile sits at a fixed offset. When a file this saver
+ *  wrote earlier in the session is saved again at the same size, and its
+ *  size and modification time show nobody else changed it since, the file
+ *  is copied and only the blocks that changed are patched into the copy.
+ *  Every other save formats a whole new file. Either way the new file is
+ *  written next to the target and renamed over it, so the previous file is
+ *  never left half written.
+ */
+class MazeSaver
+{
+public:
+    // The outcome of a finished save
+    struct Result
+    {
+        bool success;
+        unsigned long revision;     // TileGrid::revision() of the saved snapshot.
+    };
+
+    // Constructor and Destructor
+    MazeSaver();
+    ~MazeSaver();
+    MazeSaver(const MazeSaver&) = delete;            // copy constructor
+    MazeSaver(MazeSaver&&) = delete;                 // move constructor
+    MazeSaver& operator=(const MazeSaver&) = delete; // copy assignment
+    MazeSaver& operator=(MazeSaver&&) = delete;      // move assignment
+
+    // Public Member Functions for MazeSaver Processes
+    void save(const TileGrid& grid, TileGrid::Snapshot tiles, std::vector<bool> changedChunks,
+              const std::string& fileName);     // Queues a snapshot of a grid to be written to a file.
+    std::optional<Result> finished();           // Returns the result of a save that finished since the last call.
+    bool isSaving();                            // Returns whether a save is queued or being written.
+
+
+private:
+    // A save waiting for the background thread
+    struct Job
+    {
+        TileGrid::Snapshot tiles;
+        unsigned int size;
+        unsigned long revision;
+        std::vector<bool> changedChunks;
+        std::string fileName;
+    };
+
+    // Private Member Functions for MazeSaver Processes
+    void run();                         // Body of the background thread.
+    bool writeWhole(const Job& job);    // Writes a whole new file and renames it into place.
+    bool writeChanged(const Job& job);  // Patches the changed blocks into a copy of the file and renames it into place.
+    static bool replaceFile(const std::string& tempFileName, const std::string& fileName);    // Moves a finished temporary file over the file it replaces.
+
+    // Private Member Variables, guarded by m_mutex
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::optional<Job> m_job;
+    std::optional<Result> m_result;
+    bool m_writing;
+    bool m_stopping;
+
+    // Only used by the background thread
+    std::string m_savedFileName;    // File last written by this saver.
+    unsigned int m_savedSize;
+    std::filesystem::file_time_type m_savedTime;    // Modification time of the file when it was last written.
+    std::vector<char> m_buffer;
+    std::thread m_thread;
+};
@@ -0,0 +1,266 @@
+#include "memoryTracker.h"
+
+
+// Included C++11 Libraries
+#include <new>
+#include <cstdlib>
+
+
+// Included Local Dependencies
+#include "frameStats.h"
+
+
+std::atomic<std::uint64_t> MemoryTracker::s_live[TAG_COUNT] = {};
+std::atomic<std::uint64_t> MemoryTracker::s_peak[TAG_COUNT] = {};
+std::atomic<std::uint64_t> MemoryTracker::s_allocations[TAG_COUNT] = {};
+std::atomic<std::uint64_t> MemoryTracker::s_totalLive(0);
+std::atomic<std::uint64_t> MemoryTracker::s_totalPeak(0);
+
+
+namespace
+{
+    // Raises a high-water mark to value if it is lower
+    void raisePeak(std::atomic<std::uint64_t>& peak, std::uint64_t value)
+    {
+        std::uint64_t current = peak.load(std::memory_order_relaxed);
+        while (current < value && !peak.compare_exchange_weak(current, value, std::memory_order_relaxed)) {}
+    }
+}
+
+
+/**
+ * @brief Returns the usage of a tag.
+ * @details The counters are read one at a time while other threads may be
+ * allocating, so they are only as consistent as a single frame needs.
+ * @throw None
+ * @param tag - the tag to read.
+ * @return Usage - the live bytes, the peak bytes and the allocations of the tag
+ */
+MemoryTracker::Usage MemoryTracker::usage(MemoryTag tag)
+{
+    std::size_t index = static_cast<std::size_t>(tag);
+    return Usage{s_live[index].load(std::memory_order_relaxed), s_peak[index].load(std::memory_order_relaxed),
+                 s_allocations[index].load(std::memory_order_relaxed)};
+}
+
+
+/**
+ * @brief Returns the usage of every tag together.
+ * @throw None
+ * @param None
+ * @return Usage - the live bytes, the highest live bytes there ever were and
+ * the allocations of every tag
+ */
+MemoryTracker::Usage MemoryTracker::total()
+{
+    Usage usage{s_totalLive.load(std::memory_order_relaxed), s_totalPeak.load(std::memory_order_relaxed), 0};
+    for (std::size_t i = 0; i < TAG_COUNT; ++i)
+    {
+        usage.allocations += s_allocations[i].load(std::memory_order_relaxed);
+    }
+    return usage;
+}
+
+
+/**
+ * @brief Returns the name of a tag, as shown in reports.
+ * @throw None
+ * @param tag - the tag.
+ * @return const char* - the name of the tag
+ */
+const char* MemoryTracker::tagName(MemoryTag tag)
+{
+    static const char* const names[TAG_COUNT] = {"grid", "textures", "audio", "ui", "transient", "other"};
+    return names[static_cast<std::size_t>(tag)];
+}
+
+
+/**
+ * @brief Counts memory that is not on the heap.
+ * @details Usually called through a TrackedBytes, which takes the bytes off
+ * again when the memory goes.
+ * @throw None
+ * @param tag - the tag to count the bytes towards.
+ * @param bytes - the bytes to add.
+ * @return None
+ */
+void MemoryTracker::add(MemoryTag tag, std::size_t bytes)
+{
+    std::size_t index = static_cast<std::size_t>(tag);
+    raisePeak(s_peak[index], s_live[index].fetch_add(bytes, std::memory_order_relaxed) + bytes);
+    raisePeak(s_totalPeak, s_totalLive.fetch_add(bytes, std::memory_order_relaxed) + bytes);
+}
+
+
+/**
+ * @brief Stops counting memory that was added with add().
+ * @throw None
+ * @param tag - the tag the bytes were added to.
+ * @param bytes - the bytes to remove.
+ * @return None
+ */
+void MemoryTracker::remove(MemoryTag tag, std::size_t bytes)
+{
+    s_live[static_cast<std::size_t>(tag)].fetch_sub(bytes, std::memory_order_relaxed);
+    s_totalLive.fetch_sub(bytes, std::memory_order_relaxed);
+}
+
+
+/**
+ * @brief Estimates the video memory of a texture.
+ * @details Four bytes per pixel, and a third more for the smaller levels of
+ * a mipmapped texture. The driver may pad it further.
+ * @throw None
+ * @param texture - the texture.
+ * @param mipmapped - true if generateMipmap() was called on it.
+ * @return std::size_t - the bytes of the texture
+ */
+std::size_t MemoryTracker::textureBytes(const sf::Texture& texture, bool mipmapped)
+{
+    std::size_t bytes = static_cast<std::size_t>(texture.getSize().x) * texture.getSize().y * 4;
+    return mipmapped ? bytes + bytes / 3 : bytes;
+}
+
+
+/**
+ * @brief Writes the usage of every tag as a .csv file.
+ * @details One row per tag and a last row for the total, each with the live
+ * bytes, the peak bytes and the allocations made so far, so reports from
+ * different releases can be compared.
+ * @throw std::bad_alloc if the file cannot be opened.
+ * @param fileName - the .csv file to write.
+ * @return bool - true if the file was written, false if not
+ */
+bool MemoryTracker::writeReport(const std::string& fileName)
+{
+    std::ofstream file(fileName);
+    file << "tag,live_bytes,peak_bytes,allocations\n";
+    for (std::size_t i = 0; i < TAG_COUNT; ++i)
+    {
+        Usage tagUsage = usage(static_cast<MemoryTag>(i));
+        file << tagName(static_cast<MemoryTag>(i)) << "," << tagUsage.live << "," << tagUsage.peak << "," << tagUsage.allocations << "\n";
+    }
+    Usage totalUsage = total();
+    file << "total," << totalUsage.live << "," << totalUsage.peak << "," << totalUsage.allocations << "\n";
+    return static_cast<bool>(file);
+}
+
+
+/**
+ * @brief Allocates memory tagged with the innermost MemoryScope of this thread.
+ * @details Behaves like the standard operator new: calls the new handler
+ * until the allocation succeeds and throws if there is none.
+ * @throw std::bad_alloc if the memory cannot be allocated.
+ * @param size - the bytes to allocate.
+ * @return void* - the memory, after its header
+ */
+void* MemoryTracker::allocate(std::size_t size)
+{
+    FrameStats::countAllocation(size);
+    while (true)
+    {
+        if (void* block = std::malloc(size + HEADER_SIZE))
+        {
+            Header* header = static_cast<Header*>(block);
+            header->size = size;
+            header->tag = t_tag;
+            std::size_t index = static_cast<std::size_t>(t_tag);
+            s_allocations[index].fetch_add(1, std::memory_order_relaxed);
+            add(t_tag, size);
+            return static_cast<char*>(block) + HEADER_SIZE;
+        }
+        std::new_handler handler = std::get_new_handler();
+        if (!handler)
+        {
+            throw std::bad_alloc();
+        }
+        handler();
+    }
+}
+
+
+/**
+ * @brief Frees memory from allocate(), taking it off the tag it was made with.
+ * @throw None
+ * @param memory - the memory, or nullptr to do nothing.
+ * @return None
+ */
+void MemoryTracker::deallocate(void* memory) noexcept
+{
+    if (!memory)
+    {
+        return;
+    }
+    void* block = static_cast<char*>(memory) - HEADER_SIZE;
+    const Header* header = static_cast<const Header*>(block);
+    remove(header->tag, header->size);
+    std::free(block);
+}
+
+
+// The global allocation functions tag and count every allocation.
+void* operator new(std::size_t size)
+{
+    return MemoryTracker::allocate(size);
+}
+
+
+void* operator new[](std::size_t size)
+{
+    return MemoryTracker::allocate(size);
+}
+
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept
+{
+    try
+    {
+        return MemoryTracker::allocate(size);
+    }
+    catch (const std::bad_alloc&)
+    {
+        return nullptr;
+    }
+}
+
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept
+{
+    return operator new(size, std::nothrow);
+}
+
+
+void operator delete(void* memory) noexcept
+{
+    MemoryTracker::deallocate(memory);
+}
+
+
+void operator delete[](void* memory) noexcept
+{
+    MemoryTracker::deallocate(memory);
+}
+
+
+void operator delete(void* memory, std::size_t) noexcept
+{
+    MemoryTracker::deallocate(memory);
+}
+
+
+void operator delete[](void* memory, std::size_t) noexcept
+{
+    MemoryTracker::deallocate(memory);
+}
+
+
+void operator delete(void* memory, const std::nothrow_t&) noexcept
+{
+    MemoryTracker::deallocate(memory);
+}
+
+
+void operator delete[](void* memory, const std::nothrow_t&) noexcept
+{
+    MemoryTracker::deallocate(memory);
+}
@@ -0,0 +1,141 @@
+#pragma once
+
+
+// Included C++11 Libraries
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <fstream>
+
+
+// Included Graphics Library Dependencies
+#include <SFML/Graphics.hpp>
+
+
+// What the memory is used for. Other is anything allocated outside of a MemoryScope.
+enum class MemoryTag : unsigned char
+{
+    Grid, Textures, Audio, UI, Transient, Other
+};
+
+
+/**
+ * Class Name: MemoryTracker
+ * Brief: Keeps the live and peak bytes of every MemoryTag.
+ * Description:
+ *  The global operator new in memoryTracker.cpp puts a small header in front
+ *  of every allocation with its size and the tag of the innermost MemoryScope
+ *  of the thread making it, so operator delete takes it off the same tag,
+ *  whichever scope frees it. Memory that is not on the heap, such as the
+ *  pixels of textures, is added and removed by its owner through a
+ *  TrackedBytes. Every tag keeps its live bytes, its high-water mark and the
+ *  number of allocations made with it, with relaxed atomics, so tracking
+ *  costs a few uncontended atomic adds per allocation.
+ */
+class MemoryTracker
+{
+public:
+    static constexpr std::size_t TAG_COUNT = 6;
+
+    // The bytes of a tag
+    struct Usage
+    {
+        std::uint64_t live;
+        std::uint64_t peak;
+        std::uint64_t allocations;
+    };
+
+    // Public Member Functions for MemoryTracker Processes
+    static Usage usage(MemoryTag tag);
+    static Usage total();       // Usage of every tag together; its peak is the highest total, not the sum of the peaks.
+    static const char* tagName(MemoryTag tag);
+    static MemoryTag currentTag() {return t_tag;}           // Tag of the innermost MemoryScope of the calling thread.
+    static void add(MemoryTag tag, std::size_t bytes);      // Counts memory that is not on the heap.
+    static void remove(MemoryTag tag, std::size_t bytes);
+    static std::size_t textureBytes(const sf::Texture& texture, bool mipmapped = false);   // Estimates the video memory of a texture.
+    static bool writeReport(const std::string& fileName);  // Writes the usage of every tag as a .csv file.
+
+    // Used by the global operator new and delete
+    static void* allocate(std::size_t size);
+    static void deallocate(void* memory) noexcept;
+
+
+private:
+    friend class MemoryScope;
+
+    // Stored in front of every allocation
+    struct Header
+    {
+        std::size_t size;
+        MemoryTag tag;
+    };
+    static constexpr std::size_t HEADER_SIZE = alignof(std::max_align_t);  // Keeps allocations aligned like malloc's.
+    static_assert(sizeof(Header) <= HEADER_SIZE, "the header must fit in front of an allocation");
+
+    // Private Member Variables
+    static inline thread_local MemoryTag t_tag = MemoryTag::Other;    // Tag of the innermost MemoryScope of this thread.
+    static std::atomic<std::uint64_t> s_live[TAG_COUNT];
+    static std::atomic<std::uint64_t> s_peak[TAG_COUNT];
+    static std::atomic<std::uint64_t> s_allocations[TAG_COUNT];
+    static std::atomic<std::uint64_t> s_totalLive;
+    static std::atomic<std::uint64_t> s_totalPeak;
+};
+
+
+/**
+ * Class Name: MemoryScope
+ * Brief: Tags the heap allocations made by its thread while it lives.
+ * Description:
+ *  Scopes nest; the innermost one wins, and the tag of the enclosing one is
+ *  put back when it ends.
+ */
+class MemoryScope
+{
+public:
+    MemoryScope(MemoryTag tag) : m_previous(MemoryTracker::t_tag) {MemoryTracker::t_tag = tag;}
+    ~MemoryScope() {MemoryTracker::t_tag = m_previous;}
+    MemoryScope(const MemoryScope&) = delete;            // copy constructor
+    MemoryScope& operator=(const MemoryScope&) = delete; // copy assignment
+
+
+private:
+    MemoryTag m_previous;
+};
+
+
+/**
+ * Class Name: TrackedBytes
+ * Brief: Memory outside of the heap that counts towards a tag while it lives.
+ * Description:
+ *  Owned next to whatever holds the memory, such as a section's textures,
+ *  and set to its current size whenever that changes. The bytes are taken
+ *  off the tag when it is destroyed.
+ */
+class TrackedBytes
+{
+public:
+    TrackedBytes(MemoryTag tag) : m_tag(tag), m_bytes(0) {}
+    ~TrackedBytes() {set(0);}
+    TrackedBytes(const TrackedBytes&) = delete;            // copy constructor
+    TrackedBytes& operator=(const TrackedBytes&) = delete; // copy assignment
+
+    void set(std::size_t bytes)
+    {
+        if (bytes > m_bytes)
+        {
+            MemoryTracker::add(m_tag, bytes - m_bytes);
+        }
+        else
+        {
+            MemoryTracker::remove(m_tag, m_bytes - bytes);
+        }
+        m_bytes = bytes;
+    }
+    std::size_t bytes() const {return m_bytes;}
+
+
+private:
+    MemoryTag m_tag;
+    std::size_t m_bytes;
+};
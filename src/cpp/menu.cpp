@@ -10,21 +10,26 @@
  * frame of the game.
  * @param settings - a pointer to an instance of the Settings struct. It
  * contains all user preferences in relation to the game.
+ * @param jobs - a pointer to the game's JobSystem, used for indexing the
+ * level library.
  * @param music - a pointer to an instance of sf::Music. It holds the music that
  * is played throughout the game.
  * @param width - a float containing the starting width of the game window.
  * @param height - a float containing the starting height of the game window.
  */
-Menu::Menu(std::shared_ptr<sf::RenderWindow> window, std::shared_ptr<Settings> settings,
+Menu::Menu(std::shared_ptr<sf::RenderWindow> window, std::shared_ptr<Settings> settings, std::shared_ptr<JobSystem> jobs,
            std::shared_ptr<sf::Music> music, float width, float height)
 {
     m_window = window;
     m_settings = settings;
+    m_jobs = jobs;
     m_music = music;
     m_width = width;
     m_height = height;
     m_screenName = "title_screen";
     m_sectionName = SectionName::Menu;
+    m_librarySlot = 1;
+    m_libraryRow = 0;
     m_backgroundTexture = std::make_unique<sf::Texture>();
     m_soundBuffer = std::make_unique<sf::SoundBuffer>();
     load();
@@ -52,6 +57,7 @@ Menu::~Menu()
  */
 void Menu::load()
 {
+    PROFILE_ZONE("Menu::load");
     if (m_screenName == "title_screen")
     {
 
@@ -75,6 +81,7 @@ void Menu::load()
             std::exit(1);
         }
     }
+    m_textureMemory.set(MemoryTracker::textureBytes(*m_backgroundTexture));
 
     if (!m_font.loadFromFile("../assets/rm_typerighter.ttf"))
     {
@@ -87,6 +94,12 @@ void Menu::load()
     m_backgroundSprite.setScale(m_width / m_backgroundSprite.getLocalBounds().width,
                                 m_height / m_backgroundSprite.getLocalBounds().height);
 
+    // box drawn around the chosen settings
+    m_settingRect.setSize(sf::Vector2f(m_width * 0.09, m_height * 0.05));
+    m_settingRect.setFillColor(sf::Color(0, 0, 0, 0));
+    m_settingRect.setOutlineColor(sf::Color(255, 255, 255));
+    m_settingRect.setOutlineThickness(2);
+
     m_saveSlot1Text.setFont(m_font);
     m_saveSlot1Text.setCharacterSize(32);
     m_saveSlot1Text.setFillColor(sf::Color::White);
@@ -101,19 +114,34 @@ void Menu::load()
     m_saveSlot3Text.setCharacterSize(32);
     m_saveSlot3Text.setFillColor(sf::Color::White);
     m_saveSlot3Text.setPosition(0.76 * m_width, 0.5 * m_height);
+
+    m_libraryText.setFont(m_font);
+    m_libraryText.setFillColor(sf::Color::White);
 }
 
 
 /**
- * @brief Dummy function for updating the Menu.
- * @details No updating is needed for the Menus, but as a child of Section the
- * update function is called so must still exist.
+ * @brief Picks up level library entries that finished indexing.
+ * @details Levels are indexed on background threads while the library is
+ * open. The thumbnail textures of entries that were filled in are dropped,
+ * so they are created again from the new thumbnails when next drawn.
  * @throw None
  * @param None
  * @return None
  */
 void Menu::update()
 {
+    if (m_library)
+    {
+        for (std::size_t index : m_library->update())
+        {
+            if (m_thumbnails[index])
+            {
+                m_thumbnails[index].reset();
+                m_thumbnailMemory.set(m_thumbnailMemory.bytes() - THUMBNAIL_BYTES);
+            }
+        }
+    }
 }
 
 
@@ -138,6 +166,10 @@ void Menu::handleInput()
     {
         settingsScreenInput();
     }
+    else if (m_screenName == "library_screen")
+    {
+        libraryScreenInput();
+    }
 }
 
 
@@ -151,7 +183,10 @@ void Menu::handleInput()
  */
 void Menu::render()
 {
-    m_window->draw(m_backgroundSprite);
+    if (m_screenName != "library_screen")
+    {
+        draw(m_backgroundSprite);
+    }
     if (m_screenName == "settings_screen")
     {
         renderSettingsScreen();
@@ -160,6 +195,10 @@ void Menu::render()
     {
         renderPlayScreen();
     }
+    if (m_screenName == "library_screen")
+    {
+        renderLibraryScreen();
+    }
 }
 
 
@@ -174,68 +213,64 @@ void Menu::render()
  */
 void Menu::renderSettingsScreen()
 {
-    sf::RectangleShape rectangle(sf::Vector2f(m_width * 0.09, m_height * 0.05));
-    rectangle.setFillColor(sf::Color(0, 0, 0, 0));
-    rectangle.setOutlineColor(sf::Color(255, 255, 255));
-    rectangle.setOutlineThickness(2);
     if (m_settings->playMusic)
     {
-        rectangle.setPosition(m_width * 0.3, m_height * 0.25);
-        m_window->draw(rectangle);
+        m_settingRect.setPosition(m_width * 0.3, m_height * 0.25);
+        draw(m_settingRect);
     }
     else
     {
-        rectangle.setPosition(m_width * 0.4, m_height * 0.25);
-        m_window->draw(rectangle);
+        m_settingRect.setPosition(m_width * 0.4, m_height * 0.25);
+        draw(m_settingRect);
     }
 
     if (m_settings->playAudio)
     {
-        rectangle.setPosition(m_width * 0.3, m_height * 0.35);
-        m_window->draw(rectangle);
+        m_settingRect.setPosition(m_width * 0.3, m_height * 0.35);
+        draw(m_settingRect);
     }
     else
     {
-        rectangle.setPosition(m_width * 0.4, m_height * 0.35);
-        m_window->draw(rectangle);
+        m_settingRect.setPosition(m_width * 0.4, m_height * 0.35);
+        draw(m_settingRect);
     }
 
     if (m_settings->difficulty)
     {
-        rectangle.setPosition(m_width * 0.4, m_height * 0.45);
-        m_window->draw(rectangle);
+        m_settingRect.setPosition(m_width * 0.4, m_height * 0.45);
+        draw(m_settingRect);
     }
     else
     {
-        rectangle.setPosition(m_width * 0.3, m_height * 0.45);
-        m_window->draw(rectangle);
+        m_settingRect.setPosition(m_width * 0.3, m_height * 0.45);
+        draw(m_settingRect);
     }
 
     if (m_settings->frameRate == 30)
     {
-        rectangle.setPosition(m_width * 0.3, m_height * 0.55);
-        m_window->draw(rectangle);
+        m_settingRect.setPosition(m_width * 0.3, m_height * 0.55);
+        draw(m_settingRect);
     }
     else if (m_settings->frameRate == 60)
     {
-        rectangle.setPosition(m_width * 0.4, m_height * 0.55);
-        m_window->draw(rectangle);
+        m_settingRect.setPosition(m_width * 0.4, m_height * 0.55);
+        draw(m_settingRect);
     }
     else if (m_settings->frameRate == 120)
     {
-        rectangle.setPosition(m_width * 0.5, m_height * 0.55);
-        m_window->draw(rectangle);
+        m_settingRect.setPosition(m_width * 0.5, m_height * 0.55);
+        draw(m_settingRect);
     }
 
     if (m_settings->showFps)
     {
-        rectangle.setPosition(m_width * 0.3, m_height * 0.65);
-        m_window->draw(rectangle);
+        m_settingRect.setPosition(m_width * 0.3, m_height * 0.65);
+        draw(m_settingRect);
     }
     else
     {
-        rectangle.setPosition(m_width * 0.4, m_height * 0.65);
-        m_window->draw(rectangle);
+        m_settingRect.setPosition(m_width * 0.4, m_height * 0.65);
+        draw(m_settingRect);
     }
 }
 
@@ -257,9 +292,9 @@ void Menu::renderPlayScreen()
     m_saveSlot1Text.setString(slot1String);
     m_saveSlot2Text.setString(slot2String);
     m_saveSlot3Text.setString(slot3String);
-    m_window->draw(m_saveSlot1Text);
-    m_window->draw(m_saveSlot2Text);
-    m_window->draw(m_saveSlot3Text);
+    draw(m_saveSlot1Text);
+    draw(m_saveSlot2Text);
+    draw(m_saveSlot3Text);
 }
 
 
@@ -300,7 +335,7 @@ void Menu::titleScreenInput()
     float width = m_window->getSize().x;
     float height = m_window->getSize().y;
     sf::Event event;
-    while(m_window->pollEvent(event))
+    while(pollEvent(event))
     {
         if (event.type == sf::Event::Closed)    // Close window button clicked.
         {
@@ -352,7 +387,7 @@ void Menu::titleScreenInput()
 /**
  * @brief Handles input related to the play screen.
  * @details Input for the play screen includes left-clicking to play a level and
- * right-clicking to load a new level.
+ * right-clicking to pick a new level from the level library.
  * @throw None
  * @param None
  * @return None
@@ -362,7 +397,7 @@ void Menu::playScreenInput()
     float width = m_window->getSize().x;
     float height = m_window->getSize().y;
     sf::Event event;
-    while(m_window->pollEvent(event))
+    while(pollEvent(event))
     {
         if (event.type == sf::Event::Closed)
         {
@@ -416,20 +451,20 @@ void Menu::playScreenInput()
                     if (event.mouseButton.x >= width * 0.09 &&
                         event.mouseButton.x <= width * 0.31)
                     {
-                        // std::cout << "Menu: 'Save Slot 1' open-file button pressed\n";
-                        loadFileToSaveSlot(1);
+                        // std::cout << "Menu: 'Save Slot 1' library button pressed\n";
+                        openLibrary(1);
                     }
                     else if (event.mouseButton.x >= width * 0.39 &&
                              event.mouseButton.x <= width * 0.61)
                     {
-                        // std::cout << "Menu: 'Save Slot 2' open-file button pressed\n";
-                        loadFileToSaveSlot(2);
+                        // std::cout << "Menu: 'Save Slot 2' library button pressed\n";
+                        openLibrary(2);
                     }
                     else if (event.mouseButton.x >= width * 0.69 &&
                              event.mouseButton.x <= width * 0.91)
                     {
-                        // std::cout << "Menu: 'Save Slot 3' open-file button pressed\n";
-                        loadFileToSaveSlot(3);
+                        // std::cout << "Menu: 'Save Slot 3' library button pressed\n";
+                        openLibrary(3);
                     }
                 }
             }
@@ -460,7 +495,7 @@ void Menu::settingsScreenInput()
     float width = m_window->getSize().x;
     float height = m_window->getSize().y;
     sf::Event event;
-    while(m_window->pollEvent(event))
+    while(pollEvent(event))
     {
         if (event.type == sf::Event::Closed)
         {
@@ -503,7 +538,6 @@ void Menu::settingsScreenInput()
                              event.mouseButton.y <= height * 0.60)
                     {
                         m_settings->frameRate = 30;
-                        m_window->setFramerateLimit(m_settings->frameRate);
                         playClicked();
 
                     }
@@ -545,7 +579,6 @@ void Menu::settingsScreenInput()
                              event.mouseButton.y <= height * 0.60)
                     {
                         m_settings->frameRate = 60;
-                        m_window->setFramerateLimit(m_settings->frameRate);
                         playClicked();
 
                     }
@@ -564,7 +597,6 @@ void Menu::settingsScreenInput()
                         event.mouseButton.y <= height * 0.6)
                     {
                         m_settings->frameRate = 120;
-                        m_window->setFramerateLimit(m_settings->frameRate);
                         playClicked();
 
                     }
@@ -642,3 +674,212 @@ void Menu::loadFileToSaveSlot(int saveSlot)
     updateSettingsStruct();
 }
 
+
+/**
+ * @brief Shows the level library to pick the level of a save slot.
+ * @details The library is created the first time it is opened and kept for
+ * as long as the menu is, so levels keep being indexed in the background
+ * while the user moves between screens. Opening it only reads the index
+ * file and lists the level directory.
+ * @throw std::system_error if the indexing threads cannot be started.
+ * @param saveSlot - the save slot the picked level is put into, between 1-3.
+ * @return None
+ */
+void Menu::openLibrary(int saveSlot)
+{
+    if (!m_library)
+    {
+        m_library = std::make_unique<LevelLibrary>(LIBRARY_DIRECTORY, m_jobs);
+        m_thumbnails.resize(m_library->entries().size());
+    }
+    m_librarySlot = saveSlot;
+    m_libraryRow = 0;
+    m_screenName = "library_screen";
+}
+
+
+/**
+ * @brief Handles input related to the level library screen.
+ * @details Left-clicking a level puts it into the save slot the library was
+ * opened for, the mouse wheel scrolls through the levels, O opens a level
+ * from anywhere with the file explorer instead, and Escape goes back to the
+ * play screen.
+ * @throw Both C++ and Python errors can be thrown during fatal errors.
+ * @param None
+ * @return None
+ */
+void Menu::libraryScreenInput()
+{
+    float width = m_window->getSize().x;
+    float height = m_window->getSize().y;
+    int rows = (static_cast<int>(m_library->entries().size()) + LIBRARY_COLUMNS - 1) / LIBRARY_COLUMNS;
+    sf::Event event;
+    while(pollEvent(event))
+    {
+        if (event.type == sf::Event::Closed)
+        {
+            m_window->close();
+        }
+        else if (event.type == sf::Event::MouseWheelScrolled)
+        {
+            m_libraryRow -= static_cast<int>(event.mouseWheelScroll.delta);
+            m_libraryRow = std::max(0, std::min(m_libraryRow, rows - LIBRARY_ROWS));
+        }
+        else if (event.type == sf::Event::MouseButtonPressed && event.mouseButton.button == sf::Mouse::Left)
+        {
+            float x = (event.mouseButton.x / width - 0.1f) / 0.16f;
+            float y = (event.mouseButton.y / height - 0.15f) / 0.24f;
+            if (x >= 0 && x < LIBRARY_COLUMNS && y >= 0 && y < LIBRARY_ROWS)
+            {
+                std::size_t index = (m_libraryRow + static_cast<int>(y)) * LIBRARY_COLUMNS + static_cast<int>(x);
+                if (index < m_library->entries().size())
+                {
+                    playClicked();
+                    std::string path = m_library->path(index);
+                    if (m_librarySlot == 1)
+                    {
+                        m_settings->saveSlot1 = path;
+                    }
+                    else if (m_librarySlot == 2)
+                    {
+                        m_settings->saveSlot2 = path;
+                    }
+                    else if (m_librarySlot == 3)
+                    {
+                        m_settings->saveSlot3 = path;
+                    }
+                    updateSettingsStruct();
+                    m_screenName = "play_screen";
+                    load();
+                }
+            }
+        }
+        else if (event.type == sf::Event::KeyPressed)
+        {
+            if (event.key.code == sf::Keyboard::O)
+            {
+                playClicked();
+                loadFileToSaveSlot(m_librarySlot);
+                m_screenName = "play_screen";
+                load();
+            }
+            else if (event.key.code == sf::Keyboard::Escape)
+            {
+                m_screenName = "play_screen";
+                load();
+            }
+        }
+    }
+}
+
+
+/**
+ * @brief Displays the levels of the level library.
+ * @details Only the rows on screen are drawn, so only their thumbnails ever
+ * become textures. Levels that are still being indexed are drawn as an empty
+ * frame until their entry is filled in.
+ * @throw SFML exceptions may be thrown during fatal errors.
+ * @param None
+ * @return None
+ */
+void Menu::renderLibraryScreen()
+{
+    const std::vector<LevelLibrary::Entry>& entries = m_library->entries();
+
+    m_libraryText.setCharacterSize(32);
+    m_libraryText.setString("Level Library - Save Slot " + std::to_string(m_librarySlot));
+    m_libraryText.setPosition(0.1 * m_width, 0.05 * m_height);
+    draw(m_libraryText);
+
+    std::string hint = "Left click: choose level   Mouse wheel: scroll   O: open another file   Escape: back";
+    if (entries.empty())
+    {
+        hint = "There are no levels in user_data/levels yet.   O: open another file   Escape: back";
+    }
+    if (m_library->pending() != 0)
+    {
+        hint += "   (indexing " + std::to_string(m_library->pending()) + " levels)";
+    }
+    m_libraryText.setCharacterSize(20);
+    m_libraryText.setString(hint);
+    m_libraryText.setPosition(0.1 * m_width, 0.92 * m_height);
+    draw(m_libraryText);
+
+    float thumbnailSize = std::min(0.14f * m_width, 0.16f * m_height);
+    sf::RectangleShape frame(sf::Vector2f(thumbnailSize, thumbnailSize));
+    frame.setFillColor(sf::Color(0, 0, 0, 0));
+    frame.setOutlineColor(sf::Color(230, 230, 220, 150));
+    frame.setOutlineThickness(2);
+    sf::Sprite thumbnail;
+    m_libraryText.setCharacterSize(18);
+    for (int row = 0; row < LIBRARY_ROWS; ++row)
+    {
+        for (int column = 0; column < LIBRARY_COLUMNS; ++column)
+        {
+            std::size_t index = (m_libraryRow + row) * LIBRARY_COLUMNS + column;
+            if (index >= entries.size())
+            {
+                return;
+            }
+            const LevelLibrary::Entry& entry = entries[index];
+            sf::Vector2f position((0.1f + 0.16f * column) * m_width, (0.15f + 0.24f * row) * m_height);
+
+            frame.setPosition(position);
+            draw(frame);
+            if (!entry.thumbnail.empty())
+            {
+                thumbnail.setTexture(thumbnailTexture(index), true);
+                thumbnail.setScale(thumbnailSize / LevelLibrary::THUMBNAIL_SIZE, thumbnailSize / LevelLibrary::THUMBNAIL_SIZE);
+                thumbnail.setPosition(position);
+                draw(thumbnail);
+            }
+
+            std::string details = "Indexing...";
+            if (entry.indexed && entry.gridSize == 0)
+            {
+                details = "Unreadable";
+            }
+            else if (entry.indexed)
+            {
+                std::uint64_t painted = entry.gridSize * static_cast<std::uint64_t>(entry.gridSize) - entry.typeCounts[TileGrid::WALL];
+                details = std::to_string(entry.gridSize) + "x" + std::to_string(entry.gridSize)
+                          + ", " + std::to_string(painted) + " tiles";
+            }
+            m_libraryText.setString(entry.fileName.substr(0, entry.fileName.size() - 5) + "\n" + details);
+            m_libraryText.setPosition(position.x, position.y + thumbnailSize + 0.01f * m_height);
+            draw(m_libraryText);
+        }
+    }
+}
+
+
+/**
+ * @brief Returns the thumbnail of a library entry, creating its texture if needed.
+ * @details Thumbnails are stored as tile types, which are turned into
+ * colors here, once per entry.
+ * @throw SFML exceptions may be thrown during fatal errors.
+ * @param index - the index of an entry that has a thumbnail.
+ * @return const sf::Texture& - the thumbnail texture
+ */
+const sf::Texture& Menu::thumbnailTexture(std::size_t index)
+{
+    std::unique_ptr<sf::Texture>& texture = m_thumbnails[index];
+    if (!texture)
+    {
+        const std::vector<unsigned char>& types = m_library->entries()[index].thumbnail;
+        std::vector<sf::Uint8> pixels(types.size() * 4);
+        for (std::size_t i = 0; i < types.size(); ++i)
+        {
+            sf::Color color = TileGrid::mapColor(types[i]);
+            pixels[4 * i] = color.r;
+            pixels[4 * i + 1] = color.g;
+            pixels[4 * i + 2] = color.b;
+            pixels[4 * i + 3] = color.a;
+        }
+        texture = std::make_unique<sf::Texture>();
+        texture->create(LevelLibrary::THUMBNAIL_SIZE, LevelLibrary::THUMBNAIL_SIZE);
+        texture->update(pixels.data());
+        m_thumbnailMemory.set(m_thumbnailMemory.bytes() + THUMBNAIL_BYTES);
+    }
+    return *texture;
+}
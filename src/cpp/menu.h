@@ -8,6 +8,8 @@
 #include <fstream>
 #include <cstdio>
 #include <iostream>
+#include <memory>
+#include <algorithm>
 
 
 // Included Graphics Library Dependencies
@@ -18,6 +20,7 @@
 // Included Local Dependencies
 #include "settings.h"
 #include "section.h"
+#include "levelLibrary.h"
 
 
 /**
@@ -25,13 +28,14 @@
  * Brief: Manages Menu processes
  * Description:
  *  The Menu class contains all genral functions required to the menu that
- *  appears upon the launch of the game.
+ *  appears upon the launch of the game. Levels are put into the save slots
+ *  from a library screen listing every level in user_data/levels.
  */
 class Menu: public Section
 {
 public:
     // Constructor and Destructor
-    Menu(std::shared_ptr<sf::RenderWindow> window, std::shared_ptr<Settings> settings,
+    Menu(std::shared_ptr<sf::RenderWindow> window, std::shared_ptr<Settings> settings, std::shared_ptr<JobSystem> jobs,
          std::shared_ptr<sf::Music> music, float width, float height);
     ~Menu();
     Menu(const Menu&) = delete;            // copy constructor
@@ -41,9 +45,10 @@ public:
 
     // Public Member Functions for General Menu Processes
     virtual void load();            // Manages the loading of all Menu assets.
-    virtual void update();          // Dummy function for updating the Menu.
+    virtual void update();          // Picks up level library entries that finished indexing.
     virtual void handleInput();     // Manages Menu input and calls the relevant input handler.
     virtual void render();          // Displays all Menu assets to the screen.
+    virtual bool isIdle() const {return !m_library || m_library->pending() == 0;}  // idle unless levels are being indexed
 
 private:
     // Private Member Functions for General Menu Processes
@@ -54,14 +59,33 @@ private:
     void playScreenInput();                 // Handles input related to the play screen.
     void settingsScreenInput();             // Handles input related to the settings screen.
     void loadFileToSaveSlot(int saveSlot);  // Loads a .maze file to one of the three save slots.
+    void openLibrary(int saveSlot);         // Shows the level library to pick the level of a save slot.
+    void libraryScreenInput();              // Handles input related to the level library screen.
+    void renderLibraryScreen();             // Displays the levels of the level library.
+    const sf::Texture& thumbnailTexture(std::size_t index);    // Returns the thumbnail of a library entry, creating its texture if needed.
+
+    // Private Member Constants
+    static constexpr const char* LIBRARY_DIRECTORY = "../user_data/levels";
+    static const int LIBRARY_COLUMNS = 5;   // Levels shown side by side on the library screen.
+    static const int LIBRARY_ROWS = 3;      // Rows of levels shown at once on the library screen.
+    static constexpr std::size_t THUMBNAIL_BYTES = LevelLibrary::THUMBNAIL_SIZE * LevelLibrary::THUMBNAIL_SIZE * 4;
 
     // Private SFML Member Variables
     sf::Sprite m_backgroundSprite;
+    sf::RectangleShape m_settingRect;   // box around a chosen setting, moved to each one in turn
     std::unique_ptr<sf::Texture> m_backgroundTexture;
     std::shared_ptr<sf::Music> m_music;
     sf::Font m_font;
     sf::Text m_saveSlot1Text;
     sf::Text m_saveSlot2Text;
     sf::Text m_saveSlot3Text;
+    sf::Text m_libraryText;         // reused for every label on the library screen
+
+    // Private Level Library Member Variables
+    std::unique_ptr<LevelLibrary> m_library;    // created the first time the library is opened
+    std::vector<std::unique_ptr<sf::Texture>> m_thumbnails;     // one per library entry, created when first drawn
+    TrackedBytes m_thumbnailMemory{MemoryTag::Textures};        // video memory of the created thumbnails
+    int m_librarySlot;              // the save slot a level is being picked for
+    int m_libraryRow;               // the first row of levels shown
 };
 
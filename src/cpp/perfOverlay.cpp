@@ -0,0 +1,228 @@
+#include "perfOverlay.h"
+
+
+/**
+ * @brief PerfOverlay class constructor
+ * @details Starts with an empty graph. The text shows nothing until a font
+ * is set and TEXT_INTERVAL frames were added.
+ * @throw std::bad_alloc if the sample ring cannot be allocated.
+ */
+PerfOverlay::PerfOverlay() :
+m_samples(HISTORY, Sample{0.0f, 0.0f, 0.0f}),
+m_next(0),
+m_sampleCount(0),
+m_bars(sf::Quads, HISTORY * 12),
+m_guides(sf::Lines, 4),
+m_pacer(nullptr),
+m_pending(0),
+m_frameTotal(0.0),
+m_updateTotal(0.0),
+m_renderTotal(0.0),
+m_drawCallTotal(0),
+m_textureBindTotal(0),
+m_lastAllocations(FrameStats::allocations()),
+m_lastAllocatedBytes(FrameStats::allocatedBytes()),
+m_allocationTotal(0),
+m_allocatedByteTotal(0),
+m_gridBytes(0)
+{
+    m_background.setFillColor(sf::Color(0, 0, 0, 180));
+    m_text.setCharacterSize(14);
+    m_text.setFillColor(sf::Color::White);
+}
+
+
+/**
+ * @brief Sets the font of the overlay's text.
+ * @throw None
+ * @param font - the font, which must outlive the overlay.
+ * @return None
+ */
+void PerfOverlay::setFont(const sf::Font& font)
+{
+    m_text.setFont(font);
+}
+
+
+/**
+ * @brief Sets the frame pacer whose pacing is shown.
+ * @throw None
+ * @param pacer - the pacer, which must outlive the overlay.
+ * @return None
+ */
+void PerfOverlay::setPacer(const FramePacer& pacer)
+{
+    m_pacer = &pacer;
+}
+
+
+/**
+ * @brief Records a frame along with the FrameStats counters.
+ * @details Reads the draw calls and texture binds of the frame, so it must
+ * be called after the frame was drawn and before FrameStats::startFrame().
+ * The allocations of the frame are those made since the previous call.
+ * @throw std::bad_alloc if the text is rebuilt and its string cannot be
+ * allocated.
+ * @param frameMs - the time between the start of the previous frame and the
+ * start of this one.
+ * @param updateMs - the time spent in Game::update().
+ * @param renderMs - the time spent drawing the current section.
+ * @param gridBytes - the memory held by the maze grid of the current section.
+ * @return None
+ */
+void PerfOverlay::addFrame(float frameMs, float updateMs, float renderMs, std::size_t gridBytes)
+{
+    m_samples[m_next] = Sample{frameMs, updateMs, renderMs};
+    m_next = (m_next + 1) % HISTORY;
+    m_sampleCount = std::min(m_sampleCount + 1, HISTORY);
+
+    std::uint64_t allocations = FrameStats::allocations();
+    std::uint64_t allocatedBytes = FrameStats::allocatedBytes();
+    m_allocationTotal += allocations - m_lastAllocations;
+    m_allocatedByteTotal += allocatedBytes - m_lastAllocatedBytes;
+    m_lastAllocations = allocations;
+    m_lastAllocatedBytes = allocatedBytes;
+
+    m_frameTotal += frameMs;
+    m_updateTotal += updateMs;
+    m_renderTotal += renderMs;
+    m_drawCallTotal += FrameStats::drawCalls();
+    m_textureBindTotal += FrameStats::textureBinds();
+    m_gridBytes = gridBytes;
+    if (++m_pending == TEXT_INTERVAL)
+    {
+        updateText();
+    }
+}
+
+
+/**
+ * @brief Draws the overlay in the top right corner of the target.
+ * @details Drawn with the target's default view, so it stays put whatever
+ * view the section uses, and the section's view is put back afterwards.
+ * @throw SFML exceptions may be thrown during fatal errors.
+ * @param target - the target to draw on, normally the window.
+ * @return None
+ */
+void PerfOverlay::draw(sf::RenderTarget& target)
+{
+    sf::View view = target.getView();
+    target.setView(target.getDefaultView());
+
+    float textHeight = m_text.getLocalBounds().top + m_text.getLocalBounds().height;
+    sf::Vector2f corner(target.getSize().x - PANEL_WIDTH - MARGIN, MARGIN);
+    m_background.setPosition(corner);
+    m_background.setSize(sf::Vector2f(PANEL_WIDTH, GRAPH_HEIGHT + textHeight + 3 * MARGIN));
+    buildGraph(sf::Vector2f(corner.x + MARGIN, corner.y + MARGIN));
+    m_text.setPosition(corner.x + MARGIN, corner.y + GRAPH_HEIGHT + 2 * MARGIN);
+
+    target.draw(m_background);
+    target.draw(m_bars);
+    target.draw(m_guides);
+    target.draw(m_text);
+    target.setView(view);
+}
+
+
+/**
+ * @brief Rebuilds the text from the frames added since it was last rebuilt.
+ * @details Shows per-frame averages, so a single slow frame shows up in the
+ * graph and the worst frame rather than in the averages, then the pacing of
+ * the last frames, followed by the live and peak memory of every MemoryTag.
+ * @throw std::bad_alloc if the string cannot be allocated.
+ * @param None
+ * @return None
+ */
+void PerfOverlay::updateText()
+{
+    float worst = 0.0f;
+    for (std::size_t i = 0; i < m_sampleCount; ++i)
+    {
+        worst = std::max(worst, m_samples[i].frame);
+    }
+
+    double frames = m_pending;
+    std::ostringstream text;
+    text << std::fixed << std::setprecision(1);
+    text << "frame " << m_frameTotal / frames << " ms (" << (m_frameTotal > 0.0 ? 1000.0 * frames / m_frameTotal : 0.0)
+         << " fps), worst " << worst << " ms\n";
+    text << "update " << m_updateTotal / frames << " ms, render " << m_renderTotal / frames << " ms\n";
+    text << "draw calls " << m_drawCallTotal / m_pending << ", texture binds " << m_textureBindTotal / m_pending << "\n";
+    text << "allocations " << m_allocationTotal / m_pending << " (" << m_allocatedByteTotal / frames / 1024.0 << " KB)\n";
+    if (m_pacer)
+    {
+        FramePacer::Stats pacing = m_pacer->stats();
+        text << "pacing " << pacing.meanMs << " / " << pacing.targetMs << " ms, jitter " << std::setprecision(2) << pacing.jitterMs
+             << std::setprecision(1) << " ms, spin " << pacing.spinMs << " ms\n";
+        text << "late frames " << pacing.lateFrames << ", skipped " << pacing.skippedFrames << "\n";
+    }
+    text << "maze grid " << m_gridBytes / (1024.0 * 1024.0) << " MB\n";
+    text << std::setprecision(2) << "memory live / peak MB";
+    for (std::size_t i = 0; i <= MemoryTracker::TAG_COUNT; ++i)
+    {
+        bool isTotal = i == MemoryTracker::TAG_COUNT;
+        MemoryTracker::Usage usage = isTotal ? MemoryTracker::total() : MemoryTracker::usage(static_cast<MemoryTag>(i));
+        text << "\n  " << (isTotal ? "total" : MemoryTracker::tagName(static_cast<MemoryTag>(i))) << " "
+             << usage.live / (1024.0 * 1024.0) << " / " << usage.peak / (1024.0 * 1024.0);
+    }
+    m_text.setString(text.str());
+
+    m_pending = 0;
+    m_frameTotal = 0.0;
+    m_updateTotal = 0.0;
+    m_renderTotal = 0.0;
+    m_drawCallTotal = 0;
+    m_textureBindTotal = 0;
+    m_allocationTotal = 0;
+    m_allocatedByteTotal = 0;
+}
+
+
+/**
+ * @brief Fills the bars and guide lines with the graph at origin.
+ * @details The newest frame is on the right. Each bar is three quads
+ * stacked from the bottom: update (blue), render (green) and the rest of the
+ * frame (grey). Frames longer than GRAPH_MILLISECONDS are cut off at the top
+ * and drawn red.
+ * @throw None
+ * @param origin - the top left corner of the graph.
+ * @return None
+ */
+void PerfOverlay::buildGraph(sf::Vector2f origin)
+{
+    const float scale = GRAPH_HEIGHT / GRAPH_MILLISECONDS;
+    const float bottom = origin.y + GRAPH_HEIGHT;
+    for (std::size_t i = 0; i < HISTORY; ++i)
+    {
+        // bar i shows the frame HISTORY - i frames ago
+        Sample sample = i + m_sampleCount >= HISTORY ? m_samples[(m_next + i) % HISTORY] : Sample{0.0f, 0.0f, 0.0f};
+        float update = std::min(sample.update * scale, GRAPH_HEIGHT);
+        float render = std::min(sample.render * scale, GRAPH_HEIGHT - update);
+        float frame = std::min(sample.frame * scale, GRAPH_HEIGHT);
+        float rest = std::max(frame - update - render, 0.0f);
+        sf::Color restColor = sample.frame > GRAPH_MILLISECONDS ? sf::Color::Red : sf::Color(128, 128, 128);
+
+        float left = origin.x + i;
+        float heights[3] = {update, render, rest};
+        sf::Color colors[3] = {sf::Color(80, 140, 255), sf::Color(80, 220, 100), restColor};
+        float top = bottom;
+        for (std::size_t part = 0; part < 3; ++part)
+        {
+            sf::Vertex* quad = &m_bars[(i * 3 + part) * 4];
+            quad[0] = sf::Vertex(sf::Vector2f(left, top), colors[part]);
+            quad[1] = sf::Vertex(sf::Vector2f(left + 1.0f, top), colors[part]);
+            top -= heights[part];
+            quad[2] = sf::Vertex(sf::Vector2f(left + 1.0f, top), colors[part]);
+            quad[3] = sf::Vertex(sf::Vector2f(left, top), colors[part]);
+        }
+    }
+
+    // 60 and 30 FPS
+    float guides[2] = {1000.0f / 60.0f, 1000.0f / 30.0f};
+    for (std::size_t i = 0; i < 2; ++i)
+    {
+        float y = bottom - guides[i] * scale;
+        m_guides[i * 2] = sf::Vertex(sf::Vector2f(origin.x, y), sf::Color::Yellow);
+        m_guides[i * 2 + 1] = sf::Vertex(sf::Vector2f(origin.x + HISTORY, y), sf::Color::Yellow);
+    }
+}
@@ -0,0 +1,95 @@
+#pragma once
+
+
+// Included C++11 Libraries
+#include <vector>
+#include <string>
+#include <sstream>
+#include <iomanip>
+#include <algorithm>
+#include <cstdint>
+
+
+// Included Graphics Library Dependencies
+#include <SFML/Graphics.hpp>
+
+
+// Included Local Dependencies
+#include "frameStats.h"
+#include "memoryTracker.h"
+#include "framePacer.h"
+
+
+/**
+ * Class Name: PerfOverlay
+ * Brief: Draws frame times and per-frame counters over the game.
+ * Description:
+ *  Keeps the last HISTORY frames and draws them as a scrolling bar graph,
+ *  each bar split into update time, render time and the rest of the frame
+ *  (input, display and waiting for the frame limit), with guide lines at 60
+ *  and 30 FPS. Next to it are the averages of the last TEXT_INTERVAL frames:
+ *  frame, update and render time, draw calls, texture binds, heap
+ *  allocations and bytes, along with the worst frame in the graph, the
+ *  pacing of the FramePacer, the memory of the maze grid and the live and
+ *  peak memory of every MemoryTag.
+ *  The text is only rebuilt every TEXT_INTERVAL frames, and the graph is a
+ *  single vertex array, so the overlay costs a handful of draw calls; its
+ *  own draws are not counted.
+ */
+class PerfOverlay
+{
+public:
+    // Constructor
+    PerfOverlay();
+
+    // Public Member Functions for PerfOverlay Processes
+    void setFont(const sf::Font& font);
+    void setPacer(const FramePacer& pacer);
+    void addFrame(float frameMs, float updateMs, float renderMs, std::size_t gridBytes);   // Records a frame along with the FrameStats counters.
+    void draw(sf::RenderTarget& target);    // Draws the overlay in the top right corner of the target.
+
+
+private:
+    // The times of one frame, in milliseconds
+    struct Sample
+    {
+        float frame;
+        float update;
+        float render;
+    };
+
+    // Private Member Functions for PerfOverlay Processes
+    void updateText();      // Rebuilds the text from the frames added since it was last rebuilt.
+    void buildGraph(sf::Vector2f origin);   // Fills the bars and guide lines with the graph at origin.
+
+    // Private Member Constants
+    static constexpr std::size_t HISTORY = 240;         // Frames in the graph, one pixel wide each.
+    static constexpr unsigned int TEXT_INTERVAL = 15;   // Frames between rebuilding the text.
+    static constexpr float GRAPH_HEIGHT = 100.0f;       // In pixels.
+    static constexpr float GRAPH_MILLISECONDS = 50.0f;  // Frame time at the top of the graph.
+    static constexpr float PANEL_WIDTH = 250.0f;
+    static constexpr float MARGIN = 5.0f;
+
+    // Private Member Variables
+    std::vector<Sample> m_samples;  // Ring of the last HISTORY frames.
+    std::size_t m_next;             // Where the next frame goes in m_samples.
+    std::size_t m_sampleCount;      // Frames in m_samples, up to HISTORY.
+    sf::VertexArray m_bars;
+    sf::VertexArray m_guides;
+    sf::RectangleShape m_background;
+    sf::Text m_text;
+    const FramePacer* m_pacer;      // nullptr until setPacer() is called.
+
+    // Totals of the frames added since the text was last rebuilt
+    unsigned int m_pending;
+    double m_frameTotal;
+    double m_updateTotal;
+    double m_renderTotal;
+    std::uint64_t m_drawCallTotal;
+    std::uint64_t m_textureBindTotal;
+    std::uint64_t m_lastAllocations;    // FrameStats::allocations() when the last frame ended.
+    std::uint64_t m_lastAllocatedBytes;
+    std::uint64_t m_allocationTotal;
+    std::uint64_t m_allocatedByteTotal;
+    std::size_t m_gridBytes;
+};
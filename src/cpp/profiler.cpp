@@ -0,0 +1,173 @@
+#include "profiler.h"
+
+
+std::atomic<bool> Profiler::s_enabled(false);
+std::mutex Profiler::s_ringsMutex;
+std::vector<std::unique_ptr<Profiler::Ring>> Profiler::s_rings;
+
+
+/**
+ * @brief Starts or stops recording zones.
+ * @details Zones recorded before the profiler was stopped are kept, so a
+ * trace can still be written afterwards.
+ * @throw None
+ * @param enabled - true to record zones, false to stop.
+ * @return None
+ */
+void Profiler::setEnabled(bool enabled)
+{
+    s_enabled.store(enabled, std::memory_order_relaxed);
+}
+
+
+/**
+ * @brief Returns the nanoseconds since the profiler clock started.
+ * @details Measured with the steady clock from the first call, so only
+ * differences between the times mean anything.
+ * @throw None
+ * @param None
+ * @return std::int64_t - the nanoseconds since the first call
+ */
+std::int64_t Profiler::now()
+{
+    static const std::chrono::steady_clock::time_point epoch = std::chrono::steady_clock::now();
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - epoch).count();
+}
+
+
+/**
+ * @brief Adds a zone to the ring of this thread.
+ * @details The zone is written before the head is moved past it, so
+ * writeTrace() never reads a zone that is only partly written without
+ * noticing.
+ * @throw std::bad_alloc if this is the first zone of the thread and its ring
+ * cannot be allocated.
+ * @param name - the name of the zone, a string literal.
+ * @param start - when the zone started, from now().
+ * @param end - when the zone ended, from now().
+ * @return None
+ */
+void Profiler::record(const char* name, std::int64_t start, std::int64_t end)
+{
+    Ring& ring = threadRing();
+    std::uint64_t head = ring.head.load(std::memory_order_relaxed);
+    Zone& zone = ring.zones[head % RING_SIZE];
+    zone.name.store(name, std::memory_order_relaxed);
+    zone.start.store(start, std::memory_order_relaxed);
+    zone.end.store(end, std::memory_order_relaxed);
+    ring.head.store(head + 1, std::memory_order_release);
+}
+
+
+/**
+ * @brief Writes the zones that ended in the last seconds as a Chrome trace.
+ * @details The rings are copied while their threads keep recording. After a
+ * ring is copied its head is read again, and the zones its thread could have
+ * overwritten in the meantime are dropped. Zones are written as complete
+ * ("X") events in microseconds, with the ring id as the thread id.
+ * @throw std::bad_alloc if the zones cannot be copied.
+ * @param fileName - the .json file to write.
+ * @param seconds - how far back to go.
+ * @return bool - true if the file was written, false if not
+ */
+bool Profiler::writeTrace(const std::string& fileName, double seconds)
+{
+    struct Copy
+    {
+        const char* name;
+        std::int64_t start;
+        std::int64_t end;
+        unsigned int thread;
+    };
+    std::vector<Copy> zones;
+    std::int64_t cutoff = now() - static_cast<std::int64_t>(seconds * 1e9);
+    {
+        std::lock_guard<std::mutex> lock(s_ringsMutex);
+        for (const std::unique_ptr<Ring>& ring : s_rings)
+        {
+            std::uint64_t head = ring->head.load(std::memory_order_acquire);
+            std::uint64_t first = head > RING_SIZE ? head - RING_SIZE : 0;
+            std::size_t copied = zones.size();
+            for (std::uint64_t i = first; i < head; ++i)
+            {
+                const Zone& zone = ring->zones[i % RING_SIZE];
+                zones.push_back(Copy{zone.name.load(std::memory_order_relaxed), zone.start.load(std::memory_order_relaxed),
+                                     zone.end.load(std::memory_order_relaxed), ring->id});
+            }
+
+            // zone i may have been overwritten by zone i + RING_SIZE, which is being written once head reaches it
+            std::atomic_thread_fence(std::memory_order_acquire);
+            std::uint64_t newHead = ring->head.load(std::memory_order_relaxed);
+            std::uint64_t firstIntact = newHead + 1 > RING_SIZE ? newHead + 1 - RING_SIZE : 0;
+            if (firstIntact > first)
+            {
+                zones.erase(zones.begin() + copied, zones.begin() + copied + std::min<std::uint64_t>(firstIntact - first, head - first));
+            }
+        }
+    }
+    zones.erase(std::remove_if(zones.begin(), zones.end(), [cutoff](const Copy& zone) {return zone.end < cutoff;}), zones.end());
+    std::sort(zones.begin(), zones.end(), [](const Copy& a, const Copy& b) {return a.start < b.start;});
+
+    std::ofstream file(fileName);
+    file << std::fixed;
+    file.precision(3);
+    file << "{\"traceEvents\": [\n";
+    for (std::size_t i = 0; i < zones.size(); ++i)
+    {
+        file << "{\"name\": \"" << zones[i].name << "\", \"ph\": \"X\", \"pid\": 1, \"tid\": " << zones[i].thread
+             << ", \"ts\": " << zones[i].start / 1000.0 << ", \"dur\": " << (zones[i].end - zones[i].start) / 1000.0
+             << "}" << (i + 1 < zones.size() ? ",\n" : "\n");
+    }
+    file << "], \"displayTimeUnit\": \"ms\"}\n";
+    return static_cast<bool>(file);
+}
+
+
+/**
+ * @brief Returns the ring of this thread, taking one on first use.
+ * @details A thread takes the ring of a thread that ended if there is one,
+ * and hands it back when it ends itself.
+ * @throw std::bad_alloc if a new ring cannot be allocated.
+ * @param None
+ * @return Ring& - the ring of the calling thread
+ */
+Profiler::Ring& Profiler::threadRing()
+{
+    // hands the ring back when the thread ends
+    struct Owner
+    {
+        Ring* ring = nullptr;
+        ~Owner()
+        {
+            if (ring)
+            {
+                std::lock_guard<std::mutex> lock(s_ringsMutex);
+                ring->inUse = false;
+            }
+        }
+    };
+    thread_local Owner owner;
+
+    if (!owner.ring)
+    {
+        std::lock_guard<std::mutex> lock(s_ringsMutex);
+        for (const std::unique_ptr<Ring>& ring : s_rings)
+        {
+            if (!ring->inUse)
+            {
+                owner.ring = ring.get();
+                break;
+            }
+        }
+        if (!owner.ring)
+        {
+            s_rings.push_back(std::make_unique<Ring>());
+            owner.ring = s_rings.back().get();
+            owner.ring->zones = std::make_unique<Zone[]>(RING_SIZE);
+            owner.ring->head.store(0, std::memory_order_relaxed);
+            owner.ring->id = s_rings.size();
+        }
+        owner.ring->inUse = true;
+    }
+    return *owner.ring;
+}
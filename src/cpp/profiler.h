@@ -0,0 +1,106 @@
+#pragma once
+
+
+// Included C++11 Libraries
+#include <vector>
+#include <string>
+#include <memory>
+#include <atomic>
+#include <mutex>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <algorithm>
+
+
+/**
+ * Class Name: Profiler
+ * Brief: Records timed zones of every thread and exports them as a Chrome trace.
+ * Description:
+ *  A zone is a scope marked with PROFILE_ZONE("name"). While the profiler is
+ *  enabled, every zone that ends is written into a ring buffer owned by the
+ *  thread it ran on, so recording never takes a lock or waits on another
+ *  thread; the oldest zones are overwritten once a ring is full. While it is
+ *  disabled a zone costs a single relaxed load and branch, and building with
+ *  NO_PROFILER defined removes the zones entirely. writeTrace() exports the
+ *  last seconds of every ring in the Chrome trace event format, which can be
+ *  opened in chrome://tracing or Perfetto.
+ *  Rings are never freed; the ring of a thread that ended is reused by the
+ *  next new thread, so threads that come and go do not add up.
+ */
+class Profiler
+{
+public:
+    static constexpr std::size_t RING_SIZE = 65536;     // Zones kept per thread.
+
+    // Public Member Functions for Profiler Processes
+    static bool enabled() {return s_enabled.load(std::memory_order_relaxed);}
+    static void setEnabled(bool enabled);   // Starts or stops recording zones.
+    static std::int64_t now();              // Returns the nanoseconds since the profiler clock started.
+    static void record(const char* name, std::int64_t start, std::int64_t end);     // Adds a zone to the ring of this thread.
+    static bool writeTrace(const std::string& fileName, double seconds);   // Writes the zones that ended in the last seconds as a Chrome trace.
+
+
+private:
+    // A zone in a ring, read by writeTrace() while its thread may be overwriting it
+    struct Zone
+    {
+        std::atomic<const char*> name;
+        std::atomic<std::int64_t> start;
+        std::atomic<std::int64_t> end;
+    };
+
+    // The zones of one thread
+    struct Ring
+    {
+        std::unique_ptr<Zone[]> zones;
+        std::atomic<std::uint64_t> head;    // Zones ever written, the next one goes at head % RING_SIZE.
+        unsigned int id;                    // Shown as the thread id in traces.
+        bool inUse;                         // Owned by a running thread, guarded by s_ringsMutex.
+    };
+
+    // Private Member Functions for Profiler Processes
+    static Ring& threadRing();      // Returns the ring of this thread, taking one on first use.
+
+    // Private Member Variables
+    static std::atomic<bool> s_enabled;
+    static std::mutex s_ringsMutex;
+    static std::vector<std::unique_ptr<Ring>> s_rings;
+};
+
+
+/**
+ * Class Name: ProfileZone
+ * Brief: Times the scope it lives in, see PROFILE_ZONE.
+ * Description:
+ *  Takes the start time if the profiler is enabled when the scope starts,
+ *  and records the zone when the scope ends. Zones that started while the
+ *  profiler was disabled are not recorded.
+ */
+class ProfileZone
+{
+public:
+    ProfileZone(const char* name) : m_name(Profiler::enabled() ? name : nullptr), m_start(m_name ? Profiler::now() : 0) {}
+    ~ProfileZone()
+    {
+        if (m_name)
+        {
+            Profiler::record(m_name, m_start, Profiler::now());
+        }
+    }
+    ProfileZone(const ProfileZone&) = delete;            // copy constructor
+    ProfileZone& operator=(const ProfileZone&) = delete; // copy assignment
+
+
+private:
+    const char* m_name;     // nullptr if the profiler was disabled, must be a string literal otherwise.
+    std::int64_t m_start;
+};
+
+
+// Times the rest of the enclosing scope. The name must be a string literal.
+#ifdef NO_PROFILER
+#define PROFILE_ZONE(name)
+#else
+#define PROFILE_ZONE(name) ProfileZone profileZone(name)
+#endif
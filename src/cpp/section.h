@@ -3,8 +3,13 @@
 
 // Included C++ Libraries
 #include <string>
+#include <vector>
+#include <utility>
+#include <initializer_list>
 #include <memory>
 #include <iostream>
+#include <ctime>
+#include <optional>
 
 
 // Included Graphics Library Dependencies
@@ -14,11 +19,16 @@
 
 // Included Local Dependencies
 #include "settings.h"
+#include "eventScript.h"
+#include "profiler.h"
+#include "frameStats.h"
+#include "memoryTracker.h"
+#include "jobSystem.h"
 
 
 enum class SectionName
 {
-    Menu, MazeBuilder, SaveSlot1, SaveSlot2, SaveSlot3
+    Menu, MazeBuilder, SaveSlot1, SaveSlot2, SaveSlot3, Playtest
 };
 
 
@@ -37,9 +47,13 @@ public:
     virtual void handleInput() = 0;
     virtual void update() = 0;
     virtual void render() = 0;
+    virtual std::size_t gridMemory() const {return 0;}     // bytes held by the maze grid, shown by the performance overlay
+    virtual bool isIdle() const {return false;}     // true while the screen only changes in response to input, see Game::isIdle()
     Section() {}
     SectionName getSectionName() const {return m_sectionName;}
     sf::Sound::Status soundStatus() const {return m_sound.getStatus();}
+    void setEventScript(std::shared_ptr<EventScript> script) {m_eventScript = script;}
+    void holdEvent(const sf::Event& event) {m_heldEvent = event;}  // gives pollEvent() an event already taken from the window
 
 
 protected:
@@ -49,12 +63,18 @@ protected:
     std::string m_screenName;       // string of the current screen name
     SectionName m_sectionName;      // string of the current Section name 
     std::shared_ptr<Settings> m_settings;           // ptr to Settings struct (show fps, play audio, etc)
+    std::shared_ptr<JobSystem> m_jobs;              // background workers owned by Game, shared by every section
     float m_width;                  // starting width of window
     float m_height;                 // starting height of window
+    std::shared_ptr<EventScript> m_eventScript;     // replaces the window's input when set, see pollEvent()
+    std::optional<sf::Event> m_heldEvent;           // taken from the window while the game was idle, polled first
+    TrackedBytes m_textureMemory{MemoryTag::Textures};  // video memory of the textures loaded by load()
+    static constexpr double PROFILER_TRACE_SECONDS = 10;    // how far back a trace written with F10 goes
 
 
     void loadSound()
     {
+        MemoryScope memoryScope(MemoryTag::Audio);
         m_soundBuffer = std::make_unique<sf::SoundBuffer>();
         if (!m_soundBuffer->loadFromFile("../assets/clicked.wav"))
         {
@@ -65,6 +85,116 @@ protected:
     }
 
 
+    // Loads textures from the assets directory, returning the file that failed or nullptr. The files are decoded
+    // in parallel on the job system; the textures are created on this thread, which owns the OpenGL context.
+    const char* loadTextures(std::initializer_list<std::pair<sf::Texture*, const char*>> textures)
+    {
+        std::vector<std::pair<sf::Texture*, const char*>> files(textures);
+        std::vector<sf::Image> images(files.size());
+        std::vector<char> decoded(files.size(), false);     // not vector<bool>, the jobs write next to each other
+        m_jobs->parallelFor("Section::loadTextures", files.size(), 1, [&files, &images, &decoded](std::size_t first, std::size_t last)
+        {
+            for (std::size_t i = first; i < last; ++i)
+            {
+                decoded[i] = images[i].loadFromFile(std::string("../assets/") + files[i].second);
+            }
+        });
+        for (std::size_t i = 0; i < files.size(); ++i)
+        {
+            if (!decoded[i] || !files[i].first->loadFromImage(images[i]))
+            {
+                return files[i].second;
+            }
+        }
+        return nullptr;
+    }
+
+
+    // Takes the next input event, from the event script if there is one. The profiler keys are handled here, in every section.
+    bool pollEvent(sf::Event& event)
+    {
+        if (m_eventScript)
+        {
+            sf::Event ignored;
+            while (m_window->pollEvent(ignored)) {} // the window still has to be emptied
+            return m_eventScript->poll(event);
+        }
+        if (m_heldEvent)
+        {
+            event = *m_heldEvent;
+            m_heldEvent.reset();
+            if (event.type != sf::Event::KeyPressed || !handleProfilerKey(event.key.code))
+            {
+                return true;
+            }
+        }
+        while (m_window->pollEvent(event))
+        {
+            if (event.type != sf::Event::KeyPressed || !handleProfilerKey(event.key.code))
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+
+    // F3 shows and hides the performance overlay, F4 writes a memory report to user_data,
+    // F9 starts and stops the profiler, F10 writes the last PROFILER_TRACE_SECONDS of it to user_data
+    bool handleProfilerKey(sf::Keyboard::Key key)
+    {
+        if (key == sf::Keyboard::F3)
+        {
+            m_settings->showPerfOverlay = !m_settings->showPerfOverlay;
+            return true;
+        }
+        if (key == sf::Keyboard::F4)
+        {
+            std::string fileName = "../user_data/memory_" + std::to_string(std::time(nullptr)) + ".csv";
+            if (MemoryTracker::writeReport(fileName))
+            {
+                std::cout << "Section: Wrote memory report '" << fileName << "'\n";
+            }
+            return true;
+        }
+        if (key == sf::Keyboard::F9)
+        {
+            Profiler::setEnabled(!Profiler::enabled());
+            std::cout << "Section: Profiler " << (Profiler::enabled() ? "started" : "stopped") << "\n";
+            return true;
+        }
+        if (key == sf::Keyboard::F10)
+        {
+            std::string fileName = "../user_data/trace_" + std::to_string(std::time(nullptr)) + ".json";
+            if (Profiler::writeTrace(fileName, PROFILER_TRACE_SECONDS))
+            {
+                std::cout << "Section: Wrote profiler trace '" << fileName << "'\n";
+            }
+            return true;
+        }
+        return false;
+    }
+
+
+    // Draws onto the window, counting the draw call for the performance overlay
+    template <typename Drawable>
+    void draw(const Drawable& drawable, const sf::RenderStates& states = sf::RenderStates::Default)
+    {
+        FrameStats::draw(*m_window, drawable, states);
+    }
+
+
+    // Returns the mouse position in window pixels, from the event script if there is one
+    sf::Vector2i mouseOnWindow() const
+    {
+        if (m_eventScript)
+        {
+            return m_eventScript->mousePosition();
+        }
+        return sf::Mouse::getPosition(*m_window);
+    }
+
+
     void playClicked()
     {
         if (m_settings->playAudio)
@@ -18,6 +18,7 @@ struct Settings
     unsigned int difficulty;
     unsigned int frameRate;
     bool showFps;
+    bool showPerfOverlay = false;   // Toggled with F3, not saved.
     std::string saveSlot1;
     std::string saveSlot2;
     std::string saveSlot3;
@@ -0,0 +1,598 @@
+#include "soakTest.h"
+
+
+/**
+ * @brief SoakTest class constructor
+ * @details Nothing is set up until run() is called.
+ * @throw None
+ * @param minutes - how long to keep playing the scenario.
+ * @param checkAllocations - whether to fail if a steady frame allocates.
+ */
+SoakTest::SoakTest(double minutes, bool checkAllocations) :
+m_minutes(minutes),
+m_checkAllocations(checkAllocations),
+m_step(0),
+m_frameStep(0),
+m_waited(0),
+m_frameSteady(false),
+m_rounds(0),
+m_steadyFrames(0),
+m_allocatingFrameCount(0)
+{
+}
+
+
+/**
+ * @brief Runs the scenario until the time is up and prints the report.
+ * @details Must be started from the build directory like the game, since
+ * the assets are found through it. The loop is the one in main(), with every
+ * call timed, except that frames are not paced. The sandbox is deleted once the game has shut down.
+ * Allocations are counted from clearing the screen to displaying it, on
+ * this thread, plus those of the gameplay ticks that finished meanwhile. The
+ * level watcher and the maze saver are left out.
+ * @throw SFML exceptions may be thrown during fatal errors.
+ * @param None
+ * @return int - 0 if the scenario ran until the time was up, 1 if the sandbox
+ * could not be set up, the scenario got stuck or a steady frame allocated
+ */
+int SoakTest::run()
+{
+    if (!makeSandbox())
+    {
+        return 1;
+    }
+    buildScenario();
+
+    bool stuck = false;
+    {
+        std::shared_ptr<sf::RenderWindow> window = std::make_shared<sf::RenderWindow>(sf::VideoMode(WIDTH, HEIGHT), "Out of the Dark - soak test");
+        window->setVisible(false);
+        Game game(window);
+        m_script = std::make_shared<EventScript>();
+        game.setEventScript(m_script);
+
+        typedef std::chrono::steady_clock Clock;
+        auto milliseconds = [](Clock::time_point from, Clock::time_point to)
+        {
+            return std::chrono::duration<float, std::milli>(to - from).count();
+        };
+        Clock::time_point end = Clock::now() + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(m_minutes * 60));
+        while (!game.isDone() && Clock::now() < end)
+        {
+            if (!advance(game.sectionName()))
+            {
+                stuck = true;
+                break;
+            }
+
+            std::uint64_t allocations = FrameStats::threadAllocations() + FrameStats::tickAllocations();
+            Clock::time_point start = Clock::now();
+            game.clearScreen();
+            game.handleInput();
+            Clock::time_point input = Clock::now();
+            game.update();
+            Clock::time_point updated = Clock::now();
+            game.render();
+            Clock::time_point rendered = Clock::now();
+            window->display();
+            Clock::time_point displayed = Clock::now();
+            allocations = FrameStats::threadAllocations() + FrameStats::tickAllocations() - allocations;
+
+            m_inputTimes.push_back(milliseconds(start, input));
+            m_updateTimes.push_back(milliseconds(input, updated));
+            m_renderTimes.push_back(milliseconds(updated, rendered));
+            m_displayTimes.push_back(milliseconds(rendered, displayed));
+            m_frameTimes.push_back(milliseconds(start, displayed));
+            recordSlowFrame(m_frameTimes.back());
+            if (m_checkAllocations && m_frameSteady)
+            {
+                recordAllocations(allocations);
+            }
+        }
+    }
+
+    report();
+    if (stuck)
+    {
+        std::cout << "SoakTest: the scenario got stuck at '" << m_steps[m_step].label << "'\n";
+    }
+    bool allocated = m_allocatingFrameCount > 0;
+
+    std::error_code error;
+    std::filesystem::current_path(m_sandbox.parent_path(), error);
+    std::filesystem::remove_all(m_sandbox, error);
+    return (stuck || allocated) ? 1 : 0;
+}
+
+
+/**
+ * @brief Sets up the temporary user_data directory and moves into it.
+ * @details The game finds everything through paths starting with "../", so
+ * it is run from a directory next to a fresh user_data and the real assets.
+ * The user_data holds a settings file with sound off and the soak level in
+ * save slot 1. The level has a band of traps to the right of the start that
+ * kills anyone walking across it, fire and disease to the left, and a few
+ * walls to cast shadows.
+ * @throw std::bad_alloc if the level cannot be allocated.
+ * @param None
+ * @return bool - true if the sandbox is ready, false if not
+ */
+bool SoakTest::makeSandbox()
+{
+    std::error_code error;
+    std::filesystem::path assets = std::filesystem::canonical("../assets", error);
+    if (error)
+    {
+        std::cout << "SoakTest: Failed to find the assets, run from the build directory\n";
+        return false;
+    }
+    m_sandbox = std::filesystem::temp_directory_path(error) / "out_of_the_dark_soak";
+    std::filesystem::remove_all(m_sandbox, error);
+    std::filesystem::create_directories(m_sandbox / "run", error);
+    std::filesystem::create_directories(m_sandbox / "user_data" / "levels", error);
+    std::filesystem::create_directory_symlink(assets, m_sandbox / "assets", error);
+    if (error) // symbolic links may need privileges on Windows
+    {
+        error.clear();
+        std::filesystem::copy(assets, m_sandbox / "assets", std::filesystem::copy_options::recursive, error);
+    }
+    if (error)
+    {
+        std::cout << "SoakTest: Failed to set up '" << m_sandbox.string() << "'\n";
+        return false;
+    }
+
+    const unsigned int size = 64;
+    TileGrid level(size, 0);
+    for (unsigned int i = 0; i < size; ++i)
+    {
+        level.set(i, 0, TileGrid::WALL);
+        level.set(i, size - 1, TileGrid::WALL);
+        level.set(0, i, TileGrid::WALL);
+        level.set(size - 1, i, TileGrid::WALL);
+    }
+    for (unsigned int y = 1; y < size - 1; ++y)
+    {
+        for (unsigned int x = 22; x < 30; ++x)
+        {
+            level.set(x, y, 1);
+        }
+    }
+    for (unsigned int x = 8; x < 13; ++x)
+    {
+        for (unsigned int y = 0; y < 3; ++y)
+        {
+            level.set(x, 28 + y, 2);
+            level.set(x, 34 + y, 5);
+        }
+    }
+    for (unsigned int y = 20; y < 27; ++y)
+    {
+        level.set(15, y, TileGrid::WALL);
+        level.set(16, y, 3);
+    }
+    level.set(20, 32, 6);
+    level.set(60, 32, 7);
+
+    std::ofstream settings(m_sandbox / "user_data" / "settings.csv");
+    settings << "PLAY_MUSIC, 0\nPLAY_AUDIO, 0\nDIFFICULTY, 0\nFRAME_RATE, 60\nSHOW_FPS, 1\n"
+             << "SAVESLOT_1, ../user_data/levels/soak.maze\nSAVESLOT_2, \nSAVESLOT_3, \n";
+    settings.close();
+    if (!settings || !level.saveToFile((m_sandbox / "user_data" / "levels" / "soak.maze").string()))
+    {
+        std::cout << "SoakTest: Failed to write the soak level\n";
+        return false;
+    }
+
+    std::filesystem::current_path(m_sandbox / "run", error);
+    return !error;
+}
+
+
+/**
+ * @brief Fills m_steps with one round of the scenario.
+ * @details Positions are fractions of the window size, matching the buttons
+ * the sections check for. Every round starts and ends in the menu, so the
+ * scenario can be repeated. The MazeBuilder asks to recover the autosave
+ * left behind by the previous round, which is declined. Walks in the level
+ * are waited for in seconds, as long as they took at 60 frames per second
+ * before the level had its own thread. Looking around the
+ * level, the playtest and the editor after erasing are idle steps, whose
+ * frames are checked for allocations.
+ * @throw std::bad_alloc if the steps cannot be allocated.
+ * @param None
+ * @return None
+ */
+void SoakTest::buildScenario()
+{
+    waitFor("start in the menu", SectionName::Menu);
+    wait("title screen", 30);
+    click("open the play screen", 0.19f, 0.275f);
+    wait("play screen", 30);
+    click("open save slot 1", 0.2f, 0.45f);
+    waitFor("load save slot 1", SectionName::SaveSlot1);
+    idle("look around", 120);
+
+    click("walk up", 0.45f, 0.3f);
+    waitSeconds("walk up", 1.5);
+    click("walk left", 0.3f, 0.4f);
+    waitSeconds("walk left", 1.5);
+    click("walk down", 0.45f, 0.7f);
+    waitSeconds("walk down", 1.5);
+    click("walk into the traps", 0.97f, 0.5f);
+    waitSeconds("walk into the traps", 5);
+    click("reset after dying", 0.5f, 0.5f);
+    waitSeconds("reset after dying", 1);
+
+    press("pause", sf::Keyboard::Escape);
+    wait("paused", 20);
+    click("leave the level", 0.19f, 0.375f);
+    waitFor("load the menu", SectionName::Menu);
+    wait("title screen", 30);
+    click("open the maze builder", 0.19f, 0.475f);
+    waitFor("load the maze builder", SectionName::MazeBuilder);
+    press("decline recovering the autosave", sf::Keyboard::N);
+    press("pick the brush", sf::Keyboard::B);
+    click("pick the fire tile", 0.1f, 0.35f);
+    drag("paint", sf::Vector2f(0.45f, 0.3f), sf::Vector2f(0.9f, 0.8f), sf::Mouse::Left);
+
+    press("start a playtest", sf::Keyboard::P);
+    waitFor("load the playtest", SectionName::Playtest);
+    idle("playtest", 120);
+    press("stop the playtest", sf::Keyboard::P);
+    waitFor("resume the maze builder", SectionName::MazeBuilder);
+    drag("erase", sf::Vector2f(0.45f, 0.8f), sf::Vector2f(0.9f, 0.3f), sf::Mouse::Right);
+    idle("editor idle", 120);
+    click("leave the maze builder", 0.945f, 0.05f);
+}
+
+
+/**
+ * @brief Adds a step that presses and releases a mouse button in one frame.
+ * @throw std::bad_alloc if the step cannot be allocated.
+ * @param label - what the click is for.
+ * @param x - the x position as a fraction of the window width.
+ * @param y - the y position as a fraction of the window height.
+ * @param button - the button to click.
+ * @return None
+ */
+void SoakTest::click(const std::string& label, float x, float y, sf::Mouse::Button button)
+{
+    Step step;
+    step.kind = Step::Input;
+    step.label = label;
+    step.mouse = pixel(sf::Vector2f(x, y));
+
+    sf::Event event{};
+    event.mouseButton.button = button;
+    event.mouseButton.x = step.mouse.x;
+    event.mouseButton.y = step.mouse.y;
+    event.type = sf::Event::MouseButtonPressed;
+    step.events.push_back(event);
+    event.type = sf::Event::MouseButtonReleased;
+    step.events.push_back(event);
+    m_steps.push_back(step);
+}
+
+
+/**
+ * @brief Adds a step that presses and releases a key in one frame.
+ * @throw std::bad_alloc if the step cannot be allocated.
+ * @param label - what the key is for.
+ * @param key - the key to press.
+ * @return None
+ */
+void SoakTest::press(const std::string& label, sf::Keyboard::Key key)
+{
+    Step step;
+    step.kind = Step::Input;
+    step.label = label;
+    for (auto previous = m_steps.rbegin(); previous != m_steps.rend(); ++previous)
+    {
+        if (previous->kind == Step::Input)
+        {
+            step.mouse = previous->mouse; // the mouse stays where it was
+            break;
+        }
+    }
+
+    sf::Event event{};
+    event.key.code = key;
+    event.type = sf::Event::KeyPressed;
+    step.events.push_back(event);
+    event.type = sf::Event::KeyReleased;
+    step.events.push_back(event);
+    m_steps.push_back(step);
+}
+
+
+/**
+ * @brief Adds steps that drag the mouse in a straight line with a button held.
+ * @details The mouse moves a little every frame, for half a second at 60
+ * frames per second, like a hand would.
+ * @throw std::bad_alloc if the steps cannot be allocated.
+ * @param label - what the drag is for.
+ * @param from - where the button is pressed, as fractions of the window size.
+ * @param to - where the button is released, as fractions of the window size.
+ * @param button - the button to hold.
+ * @return None
+ */
+void SoakTest::drag(const std::string& label, sf::Vector2f from, sf::Vector2f to, sf::Mouse::Button button)
+{
+    const int moves = 30;
+    Step step;
+    step.kind = Step::Input;
+    step.label = label;
+    sf::Event event{};
+    for (int i = 0; i <= moves + 1; ++i)
+    {
+        step.mouse = pixel(from + (to - from) * (std::min(i, moves) / static_cast<float>(moves)));
+        step.events.clear();
+        if (i == 0 || i == moves + 1)
+        {
+            event.type = (i == 0) ? sf::Event::MouseButtonPressed : sf::Event::MouseButtonReleased;
+            event.mouseButton.button = button;
+            event.mouseButton.x = step.mouse.x;
+            event.mouseButton.y = step.mouse.y;
+        }
+        else
+        {
+            event.type = sf::Event::MouseMoved;
+            event.mouseMove.x = step.mouse.x;
+            event.mouseMove.y = step.mouse.y;
+        }
+        step.events.push_back(event);
+        m_steps.push_back(step);
+    }
+}
+
+
+/**
+ * @brief Adds a step that waits for a number of frames without input.
+ * @throw std::bad_alloc if the step cannot be allocated.
+ * @param label - what is being waited for.
+ * @param frames - the number of frames to wait.
+ * @return None
+ */
+void SoakTest::wait(const std::string& label, int frames)
+{
+    Step step;
+    step.kind = Step::WaitFrames;
+    step.label = label;
+    step.frames = frames;
+    m_steps.push_back(step);
+}
+
+
+/**
+ * @brief Adds a step that waits for a number of seconds without input.
+ * @throw std::bad_alloc if the step cannot be allocated.
+ * @param label - what is being waited for.
+ * @param seconds - how long to wait.
+ * @return None
+ */
+void SoakTest::waitSeconds(const std::string& label, double seconds)
+{
+    Step step;
+    step.kind = Step::WaitSeconds;
+    step.label = label;
+    step.seconds = seconds;
+    m_steps.push_back(step);
+}
+
+
+/**
+ * @brief Adds a step that waits for a number of frames without input, in
+ * which the game should not allocate.
+ * @details Only the frames after the first STEADY_WARMUP are checked, to
+ * leave time for whatever the previous input started to settle.
+ * @throw std::bad_alloc if the step cannot be allocated.
+ * @param label - what is being waited for.
+ * @param frames - the number of frames to wait.
+ * @return None
+ */
+void SoakTest::idle(const std::string& label, int frames)
+{
+    wait(label, frames);
+    m_steps.back().steady = true;
+}
+
+
+/**
+ * @brief Adds a step that waits until the game switches to a section.
+ * @throw std::bad_alloc if the step cannot be allocated.
+ * @param label - what is being waited for.
+ * @param section - the section to wait for.
+ * @return None
+ */
+void SoakTest::waitFor(const std::string& label, SectionName section)
+{
+    Step step;
+    step.kind = Step::WaitForSection;
+    step.label = label;
+    step.section = section;
+    m_steps.push_back(step);
+}
+
+
+/**
+ * @brief Converts a fraction of the window size to pixels.
+ * @throw None
+ * @param fraction - the position as fractions of the window width and height.
+ * @return sf::Vector2i - the position in window pixels
+ */
+sf::Vector2i SoakTest::pixel(sf::Vector2f fraction) const
+{
+    return sf::Vector2i(fraction.x * WIDTH, fraction.y * HEIGHT);
+}
+
+
+/**
+ * @brief Feeds the input of the current step, returning false if it is stuck.
+ * @details Called once before every frame. An input step sends its events
+ * and moves on; waiting steps move on once their frames or seconds have
+ * passed or their section is running. After the last step the scenario starts over.
+ * @throw std::bad_alloc if the events cannot be queued.
+ * @param section - the section the game is running.
+ * @return bool - false if a section did not start within SECTION_TIMEOUT frames
+ */
+bool SoakTest::advance(SectionName section)
+{
+    const Step& step = m_steps[m_step];
+    m_frameStep = m_step;
+    m_frameSteady = step.steady && m_waited >= STEADY_WARMUP;
+    bool done = true;
+    if (step.kind == Step::Input)
+    {
+        m_script->setMousePosition(step.mouse);
+        for (const sf::Event& event : step.events)
+        {
+            m_script->push(event);
+        }
+    }
+    else if (step.kind == Step::WaitFrames)
+    {
+        done = ++m_waited >= step.frames;
+    }
+    else if (step.kind == Step::WaitSeconds)
+    {
+        if (m_waited++ == 0)
+        {
+            m_waitStart = std::chrono::steady_clock::now();
+        }
+        done = std::chrono::steady_clock::now() - m_waitStart >= std::chrono::duration<double>(step.seconds);
+    }
+    else if (section != step.section)
+    {
+        if (++m_waited > SECTION_TIMEOUT)
+        {
+            return false;
+        }
+        done = false;
+    }
+
+    if (done)
+    {
+        m_waited = 0;
+        m_step = (m_step + 1) % m_steps.size();
+        m_rounds += (m_step == 0);
+    }
+    return true;
+}
+
+
+/**
+ * @brief Keeps the frame if it is one of the SLOW_FRAMES slowest so far.
+ * @throw std::bad_alloc if the frame cannot be kept.
+ * @param milliseconds - how long the frame took.
+ * @return None
+ */
+void SoakTest::recordSlowFrame(float milliseconds)
+{
+    if (m_slowFrames.size() == SLOW_FRAMES && milliseconds <= m_slowFrames.back().milliseconds)
+    {
+        return;
+    }
+    auto position = std::find_if(m_slowFrames.begin(), m_slowFrames.end(),
+                                 [milliseconds](const SlowFrame& frame) {return frame.milliseconds < milliseconds;});
+    m_slowFrames.insert(position, SlowFrame{milliseconds, m_steps[m_frameStep].label});
+    if (m_slowFrames.size() > SLOW_FRAMES)
+    {
+        m_slowFrames.pop_back();
+    }
+}
+
+
+/**
+ * @brief Counts a steady frame, keeping it if it allocated and fewer than
+ * SLOW_FRAMES allocating frames were kept so far.
+ * @throw std::bad_alloc if the frame cannot be kept.
+ * @param allocations - the allocations the frame made on this thread.
+ * @return None
+ */
+void SoakTest::recordAllocations(std::uint64_t allocations)
+{
+    ++m_steadyFrames;
+    if (allocations == 0)
+    {
+        return;
+    }
+    ++m_allocatingFrameCount;
+    if (m_allocatingFrames.size() < SLOW_FRAMES)
+    {
+        m_allocatingFrames.push_back(AllocatingFrame{allocations, m_steps[m_frameStep].label});
+    }
+}
+
+
+/**
+ * @brief Prints the percentiles and the slowest frames.
+ * @details When allocations are checked, the number of steady frames that
+ * allocated follows, with the first of them. Ends with the memory of every
+ * MemoryTag, whose peaks cover the whole run.
+ * @throw None
+ * @param None
+ * @return None
+ */
+void SoakTest::report() const
+{
+    std::cout << "Soak test: " << m_frameTimes.size() << " frames, " << m_rounds << " rounds of the scenario\n";
+    std::cout << "                    p50 ms    p95 ms    p99 ms    max ms\n";
+    printRow("frame", m_frameTimes);
+    printRow("handleInput", m_inputTimes);
+    printRow("update", m_updateTimes);
+    printRow("render", m_renderTimes);
+    printRow("display", m_displayTimes);
+    std::cout << "Slowest frames:\n";
+    for (const SlowFrame& frame : m_slowFrames)
+    {
+        char line[128];
+        std::snprintf(line, sizeof(line), "%10.2f ms  %s\n", frame.milliseconds, frame.label.c_str());
+        std::cout << line;
+    }
+    if (m_checkAllocations)
+    {
+        std::cout << "Steady frames: " << m_steadyFrames << " checked, " << m_allocatingFrameCount << " allocated\n";
+        for (const AllocatingFrame& frame : m_allocatingFrames)
+        {
+            char line[128];
+            std::snprintf(line, sizeof(line), "%10llu allocations  %s\n", static_cast<unsigned long long>(frame.allocations), frame.label.c_str());
+            std::cout << line;
+        }
+    }
+    std::cout << "Memory:            live MB   peak MB\n";
+    for (std::size_t i = 0; i <= MemoryTracker::TAG_COUNT; ++i)
+    {
+        bool isTotal = i == MemoryTracker::TAG_COUNT;
+        MemoryTracker::Usage usage = isTotal ? MemoryTracker::total() : MemoryTracker::usage(static_cast<MemoryTag>(i));
+        char line[128];
+        std::snprintf(line, sizeof(line), "%-16s%10.2f%10.2f\n", isTotal ? "total" : MemoryTracker::tagName(static_cast<MemoryTag>(i)),
+                      usage.live / (1024.0 * 1024.0), usage.peak / (1024.0 * 1024.0));
+        std::cout << line;
+    }
+}
+
+
+/**
+ * @brief Prints one row of percentiles.
+ * @throw None
+ * @param name - the name of the row.
+ * @param samples - the times in milliseconds, sorted in a copy.
+ * @return None
+ */
+void SoakTest::printRow(const std::string& name, std::vector<float> samples)
+{
+    if (samples.empty())
+    {
+        return;
+    }
+    std::sort(samples.begin(), samples.end());
+    auto percentile = [&samples](double fraction)
+    {
+        return samples[std::min(samples.size() - 1, static_cast<std::size_t>(samples.size() * fraction))];
+    };
+    char line[128];
+    std::snprintf(line, sizeof(line), "%-16s%10.2f%10.2f%10.2f%10.2f\n", name.c_str(),
+                  percentile(0.5), percentile(0.95), percentile(0.99), samples.back());
+    std::cout << line;
+}
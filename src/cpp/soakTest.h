@@ -0,0 +1,135 @@
+#pragma once
+
+
+// Included C++11 Libraries
+#include <vector>
+#include <string>
+#include <memory>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <cstdio>
+#include <cstdint>
+#include <algorithm>
+#include <filesystem>
+
+
+// Included Graphics Library Dependencies
+#include <SFML/Graphics.hpp>
+
+
+// Included Local Dependencies
+#include "game.h"
+#include "eventScript.h"
+#include "tileGrid.h"
+#include "memoryTracker.h"
+#include "frameStats.h"
+
+
+/**
+ * Class Name: SoakTest
+ * Brief: Plays a scripted scenario in the real game loop and reports frame times.
+ * Description:
+ *  Runs the same loop as main() in a hidden window for a number of minutes,
+ *  driven by an EventScript instead of a user. The scenario goes from the
+ *  menu into a level, walks around, walks over traps until the player dies,
+ *  resets, goes to the MazeBuilder, paints, playtests, erases and goes back
+ *  to the menu, over and over. The frame rate is not limited, so the times
+ *  are of the game's own work. A level is simulated on its own thread in
+ *  real time however fast frames are drawn, so the waits while walking are
+ *  timed in seconds rather than counted in frames. At the end the 50th, 95th and 99th percentile
+ *  and the worst time of whole frames and of handleInput(), update(),
+ *  render() and display() are printed, along with the steps of the
+ *  scenario the slowest frames happened in.
+ *  With checkAllocations, the idle steps of the scenario, where the game
+ *  only redraws the same screen, are also checked for heap allocations on
+ *  the game thread and in gameplay ticks once they have settled, and the
+ *  test fails if any frame in them allocated.
+ *  The game runs next to a fresh user_data directory in a temporary folder,
+ *  with its own settings and level, so the player's saves are never touched. Steps
+ *  that open Python file dialogs are left out, since they wait for a user.
+ */
+class SoakTest
+{
+public:
+    // Constructor
+    SoakTest(double minutes, bool checkAllocations = false);
+
+    // Public Member Functions for SoakTest Processes
+    int run();          // Runs the scenario until the time is up and prints the report.
+
+
+private:
+    // One step of the scenario, taking at least one frame
+    struct Step
+    {
+        enum {Input, WaitFrames, WaitSeconds, WaitForSection} kind;
+        std::string label;              // What the scenario is doing, shown next to slow frames.
+        std::vector<sf::Event> events;  // Input: sent in a single frame.
+        sf::Vector2i mouse = sf::Vector2i(0, 0);    // Input: where the mouse is during the frame, in window pixels.
+        int frames = 0;                 // WaitFrames: how many frames to wait.
+        double seconds = 0;             // WaitSeconds: how long to wait.
+        SectionName section = SectionName::Menu;    // WaitForSection: the section to wait for.
+        bool steady = false;            // WaitFrames: frames after STEADY_WARMUP must not allocate.
+    };
+
+    // A slow frame and where in the scenario it happened
+    struct SlowFrame
+    {
+        float milliseconds;
+        std::string label;
+    };
+
+    // A steady frame that allocated and where in the scenario it happened
+    struct AllocatingFrame
+    {
+        std::uint64_t allocations;
+        std::string label;
+    };
+
+    // Private Member Functions for SoakTest Processes
+    bool makeSandbox();         // Sets up the temporary user_data directory and moves into it.
+    void buildScenario();       // Fills m_steps with one round of the scenario.
+    void click(const std::string& label, float x, float y, sf::Mouse::Button button = sf::Mouse::Left);
+    void press(const std::string& label, sf::Keyboard::Key key);
+    void drag(const std::string& label, sf::Vector2f from, sf::Vector2f to, sf::Mouse::Button button);
+    void wait(const std::string& label, int frames);
+    void waitSeconds(const std::string& label, double seconds);
+    void idle(const std::string& label, int frames);
+    void waitFor(const std::string& label, SectionName section);
+    sf::Vector2i pixel(sf::Vector2f fraction) const;   // Converts a fraction of the window size to pixels.
+    bool advance(SectionName section);  // Feeds the input of the current step, returning false if it is stuck.
+    void recordSlowFrame(float milliseconds);
+    void recordAllocations(std::uint64_t allocations);
+    void report() const;        // Prints the percentiles, the slowest frames and the memory of every tag.
+    static void printRow(const std::string& name, std::vector<float> samples);
+
+    // Private Member Constants
+    static constexpr unsigned int WIDTH = 1000;     // Same size as the window in main().
+    static constexpr unsigned int HEIGHT = 600;
+    static constexpr int SECTION_TIMEOUT = 600;     // Frames to wait for a section before the scenario is stuck.
+    static constexpr std::size_t SLOW_FRAMES = 10;  // Slowest frames listed in the report.
+    static constexpr int STEADY_WARMUP = 30;        // Frames an idle step waits before its frames are checked.
+
+    // Private Member Variables
+    double m_minutes;
+    bool m_checkAllocations;
+    std::filesystem::path m_sandbox;
+    std::vector<Step> m_steps;
+    std::size_t m_step;         // Index of the current step in m_steps.
+    std::size_t m_frameStep;    // The step the current frame was given input or waited for.
+    int m_waited;               // Frames the current step has waited.
+    std::chrono::steady_clock::time_point m_waitStart;  // When the current step started waiting.
+    bool m_frameSteady;         // Whether the current frame must not allocate.
+    unsigned long m_rounds;     // Times the whole scenario was played.
+    std::shared_ptr<EventScript> m_script;
+    std::vector<float> m_frameTimes;    // In milliseconds, like the other times.
+    std::vector<float> m_inputTimes;
+    std::vector<float> m_updateTimes;
+    std::vector<float> m_renderTimes;
+    std::vector<float> m_displayTimes;
+    std::vector<SlowFrame> m_slowFrames;    // Slowest first.
+    unsigned long m_steadyFrames;           // Frames checked for allocations.
+    unsigned long m_allocatingFrameCount;
+    std::vector<AllocatingFrame> m_allocatingFrames;    // The first SLOW_FRAMES of them.
+};
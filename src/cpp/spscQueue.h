@@ -0,0 +1,60 @@
+#pragma once
+
+
+// Included C++11 Libraries
+#include <array>
+#include <atomic>
+#include <cstddef>
+
+
+/**
+ * Class Name: SpscQueue
+ * Brief: Fixed size queue between one producing and one consuming thread.
+ * Description:
+ *  A ring of CAPACITY items with a head that only the consumer moves and a
+ *  tail that only the producer moves, so neither side ever takes a lock or
+ *  waits for the other. Each index is published with a release store and
+ *  read with an acquire load, which is all the ordering the items need. The
+ *  indices only grow and are wrapped when used, so CAPACITY must be a power
+ *  of two. The indices sit on separate cache lines, so the two threads do
+ *  not keep taking the line from each other.
+ */
+template <typename T, std::size_t CAPACITY>
+class SpscQueue
+{
+    static_assert(CAPACITY != 0 && (CAPACITY & (CAPACITY - 1)) == 0, "CAPACITY must be a power of two");
+
+public:
+    // Adds an item at the back, returning false if the queue is full. Only called by the producer.
+    bool push(const T& item)
+    {
+        std::size_t tail = m_tail.load(std::memory_order_relaxed);
+        if (tail - m_head.load(std::memory_order_acquire) == CAPACITY)
+        {
+            return false;
+        }
+        m_items[tail & (CAPACITY - 1)] = item;
+        m_tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Takes the item at the front, returning false if the queue is empty. Only called by the consumer.
+    bool pop(T& item)
+    {
+        std::size_t head = m_head.load(std::memory_order_relaxed);
+        if (head == m_tail.load(std::memory_order_acquire))
+        {
+            return false;
+        }
+        item = m_items[head & (CAPACITY - 1)];
+        m_head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+
+private:
+    // Private Member Variables
+    std::array<T, CAPACITY> m_items;
+    alignas(64) std::atomic<std::size_t> m_head{0};     // Next item to pop.
+    alignas(64) std::atomic<std::size_t> m_tail{0};     // Next free slot to push into.
+};
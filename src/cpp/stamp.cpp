@@ -0,0 +1,155 @@
+#include "stamp.h"
+
+
+namespace
+{
+    const char STAMP_MAGIC[4] = {'S', 'T', 'P', '1'};
+}
+
+
+/**
+ * @brief Stamp class constructor
+ * @details Creates a stamp of the given size filled with a single tile type.
+ * @throw std::bad_alloc if the stamp cannot be allocated.
+ * @param width - the width of the stamp in tiles.
+ * @param height - the height of the stamp in tiles.
+ * @param fill - the type every tile starts as.
+ */
+Stamp::Stamp(unsigned int width, unsigned int height, unsigned char fill)
+{
+    resize(width, height, fill);
+}
+
+
+/**
+ * @brief Resizes the stamp and fills it with a single type.
+ * @throw std::bad_alloc if the stamp cannot be allocated.
+ * @param width - the new width of the stamp in tiles.
+ * @param height - the new height of the stamp in tiles.
+ * @param fill - the type every tile is set to.
+ * @return None
+ */
+void Stamp::resize(unsigned int width, unsigned int height, unsigned char fill)
+{
+    m_width = width;
+    m_height = height;
+    m_tiles.assign(static_cast<std::size_t>(width) * height, fill);
+}
+
+
+/**
+ * @brief Rotates the stamp a quarter turn clockwise.
+ * @details The tile at (x, y) moves to (height - 1 - y, x), and the width
+ * and height are swapped.
+ * @throw std::bad_alloc if the rotated tiles cannot be allocated.
+ * @param None
+ * @return None
+ */
+void Stamp::rotate()
+{
+    std::vector<unsigned char> rotated(m_tiles.size());
+    for (unsigned int x = 0; x < m_width; ++x)
+    {
+        for (unsigned int y = 0; y < m_height; ++y)
+        {
+            // the new stamp is m_height wide and m_width high
+            rotated[static_cast<std::size_t>(m_height - 1 - y) * m_width + x] = get(x, y);
+        }
+    }
+    m_tiles.swap(rotated);
+    std::swap(m_width, m_height);
+}
+
+
+/**
+ * @brief Mirrors the stamp from left to right.
+ * @details Columns are stored contiguously, so this only swaps whole columns.
+ * @throw None
+ * @param None
+ * @return None
+ */
+void Stamp::mirror()
+{
+    for (unsigned int x = 0; x < m_width / 2; ++x)
+    {
+        std::swap_ranges(column(x), column(x) + m_height, column(m_width - 1 - x));
+    }
+}
+
+
+/**
+ * @brief Reads a run-length encoded stamp file.
+ * @details See saveToFile() for the format. The stamp is left unchanged if
+ * the file cannot be read, or if it holds a tile type the grid does not know,
+ * since pasting one would index past the grid's per type counts.
+ * @throw std::bad_alloc if the stamp cannot be allocated.
+ * @param fileName - the path of the stamp file.
+ * @return bool - true if the file could be read, false if not
+ */
+bool Stamp::loadFromFile(const std::string& fileName)
+{
+    PROFILE_ZONE("Stamp::loadFromFile");
+    std::fstream file(fileName, std::ios::in | std::ios::binary);
+    char magic[4];
+    std::uint16_t width = 0;
+    std::uint16_t height = 0;
+    file.read(magic, sizeof(magic));
+    file.read(reinterpret_cast<char*>(&width), sizeof(width));
+    file.read(reinterpret_cast<char*>(&height), sizeof(height));
+    if (!file || !std::equal(magic, magic + 4, STAMP_MAGIC))
+    {
+        return false;
+    }
+
+    std::size_t count = static_cast<std::size_t>(width) * height;
+    std::vector<unsigned char> tiles;
+    tiles.reserve(count);
+    while (tiles.size() < count)
+    {
+        unsigned char run[2]; // length, type
+        if (!file.read(reinterpret_cast<char*>(run), sizeof(run)) || run[0] == 0 ||
+            tiles.size() + run[0] > count || run[1] >= TileGrid::TYPE_COUNT)
+        {
+            return false;
+        }
+        tiles.insert(tiles.end(), run[0], run[1]);
+    }
+
+    m_tiles.swap(tiles);
+    m_width = width;
+    m_height = height;
+    return true;
+}
+
+
+/**
+ * @brief Writes the stamp run-length encoded.
+ * @details The file starts with a magic and the 16 bit width and height,
+ * followed by (length, type) byte pairs covering the tiles column by column.
+ * @throw None
+ * @param fileName - the path of the stamp file.
+ * @return bool - true if the file was written, false if not
+ */
+bool Stamp::saveToFile(const std::string& fileName) const
+{
+    PROFILE_ZONE("Stamp::saveToFile");
+    std::fstream file(fileName, std::ios::out | std::ios::binary | std::ios::trunc);
+    std::uint16_t width = m_width;
+    std::uint16_t height = m_height;
+    file.write(STAMP_MAGIC, sizeof(STAMP_MAGIC));
+    file.write(reinterpret_cast<const char*>(&width), sizeof(width));
+    file.write(reinterpret_cast<const char*>(&height), sizeof(height));
+
+    std::size_t i = 0;
+    while (i < m_tiles.size())
+    {
+        unsigned char run[2] = {1, m_tiles[i]};
+        while (i + run[0] < m_tiles.size() && m_tiles[i + run[0]] == run[1] && run[0] < UINT8_MAX)
+        {
+            ++run[0];
+        }
+        file.write(reinterpret_cast<const char*>(run), sizeof(run));
+        i += run[0];
+    }
+    return static_cast<bool>(file);
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+
+// Included C++11 Libraries
+#include <vector>
+#include <string>
+#include <fstream>
+#include <cstdint>
+#include <algorithm>
+
+
+// Included Local Dependencies
+#include "profiler.h"
+#include "tileGrid.h"
+
+
+/**
+ * Class Name: Stamp
+ * Brief: A rectangular block of tiles that can be pasted into a maze.
+ * Description:
+ *  Holds the tile types of a copied region, column by column like TileGrid,
+ *  so a column of the stamp can be copied to or from a column of the grid in
+ *  one operation. Stamps can be rotated and mirrored, and are saved to disk
+ *  run-length encoded, since most stamps are made of long runs of floor and
+ *  wall.
+ */
+class Stamp
+{
+public:
+    // Constructor
+    Stamp(unsigned int width = 0, unsigned int height = 0, unsigned char fill = 0);
+
+    // Public Member Functions for Stamp Processes
+    void resize(unsigned int width, unsigned int height, unsigned char fill = 0);  // Resizes the stamp and fills it with a single type.
+    unsigned int width() const {return m_width;}
+    unsigned int height() const {return m_height;}
+    bool empty() const {return m_tiles.empty();}
+    unsigned char get(unsigned int x, unsigned int y) const {return m_tiles[index(x, y)];}
+    void set(unsigned int x, unsigned int y, unsigned char type) {m_tiles[index(x, y)] = type;}
+    unsigned char* column(unsigned int x) {return m_tiles.data() + index(x, 0);}
+    const unsigned char* column(unsigned int x) const {return m_tiles.data() + index(x, 0);}
+    void rotate();          // Rotates the stamp a quarter turn clockwise.
+    void mirror();          // Mirrors the stamp from left to right.
+    bool loadFromFile(const std::string& fileName);     // Reads a run-length encoded stamp file.
+    bool saveToFile(const std::string& fileName) const; // Writes the stamp run-length encoded.
+
+
+private:
+    // Private Member Functions for Stamp Processes
+    std::size_t index(unsigned int x, unsigned int y) const {return static_cast<std::size_t>(x) * m_height + y;}
+
+    // Private Member Variables
+    std::vector<unsigned char> m_tiles;
+    unsigned int m_width;
+    unsigned int m_height;
+};
@@ -0,0 +1,454 @@
+#include "tileGrid.h"
+
+
+/**
+ * @brief TileGrid class constructor
+ * @details Creates a grid of the given size filled with a single tile type.
+ * @throw std::bad_alloc if the grid cannot be allocated.
+ * @param size - the width and height of the grid in tiles.
+ * @param fill - the type every tile starts as.
+ */
+TileGrid::TileGrid(unsigned int size, unsigned char fill) :
+m_tiles(std::make_shared<std::vector<unsigned char>>()),
+m_revision(0)
+{
+    resize(size, fill);
+}
+
+
+/**
+ * @brief Resizes the grid and fills every tile with a single type.
+ * @throw std::bad_alloc if the grid cannot be allocated.
+ * @param size - the new width and height of the grid in tiles.
+ * @param fill - the type every tile is set to.
+ * @return None
+ */
+void TileGrid::resize(unsigned int size, unsigned char fill)
+{
+    MemoryScope memoryScope(MemoryTag::Grid);
+    m_size = size;
+    m_tiles = std::make_shared<std::vector<unsigned char>>(static_cast<std::size_t>(size) * size, fill);
+    recount();
+    markAllChanged();
+}
+
+
+/**
+ * @brief Replaces the whole grid with a copy of packed tiles.
+ * @throw std::bad_alloc if the grid cannot be allocated.
+ * @param size - the new width and height of the grid in tiles.
+ * @param tiles - size * size tile types, column by column.
+ * @return None
+ */
+void TileGrid::assign(unsigned int size, const unsigned char* tiles)
+{
+    MemoryScope memoryScope(MemoryTag::Grid);
+    m_size = size;
+    m_tiles = std::make_shared<std::vector<unsigned char>>(tiles, tiles + static_cast<std::size_t>(size) * size);
+    recount();
+    markAllChanged();
+}
+
+/**
+ * @brief Changes a tile and returns its old type.
+ * @details The counts are adjusted for the one tile. The bounding box grows
+ * straight away when a tile is painted outside of it, and only shrinks when
+ * the last non-wall tile of an edge row or column is erased, by walking the
+ * row and column counts rather than the tiles.
+ * @throw None
+ * @param x - the x index of the tile.
+ * @param y - the y index of the tile.
+ * @param type - the new texture index of the tile.
+ * @return unsigned char - the texture index the tile had before
+ */
+unsigned char TileGrid::set(unsigned int x, unsigned int y, unsigned char type)
+{
+    unsigned char old = (*m_tiles)[index(x, y)];
+    if (old == type)
+    {
+        return old;
+    }
+    writableTiles()[index(x, y)] = type;
+    markChanged(x, y, y);
+
+    --m_typeCounts[old];
+    ++m_typeCounts[type];
+    if (old == WALL) // painted
+    {
+        ++m_columnCounts[x];
+        ++m_rowCounts[y];
+        if (m_left == -1)
+        {
+            m_left = m_right = x;
+            m_top = m_bottom = y;
+        }
+        m_left = std::min<int>(m_left, x);
+        m_right = std::max<int>(m_right, x);
+        m_top = std::min<int>(m_top, y);
+        m_bottom = std::max<int>(m_bottom, y);
+    }
+    else if (type == WALL) // erased
+    {
+        --m_columnCounts[x];
+        --m_rowCounts[y];
+        shrinkBounds();
+    }
+    return old;
+}
+
+
+/**
+ * @brief Copies part of a column out of the grid.
+ * @details Columns are contiguous in the grid, so this is a single copy.
+ * @throw None
+ * @param x - the x index of the column.
+ * @param y - the y index of the first tile.
+ * @param length - the number of tiles to copy. They must all be inside the grid.
+ * @param types - where the tile types are copied to.
+ * @return None
+ */
+void TileGrid::readColumn(unsigned int x, unsigned int y, unsigned int length, unsigned char* types) const
+{
+    std::memcpy(types, &(*m_tiles)[index(x, y)], length);
+}
+
+
+/**
+ * @brief Replaces part of a column, returning the old types.
+ * @details The column is swapped in with a single copy, and the counts and
+ * bounding box are then updated for the whole span at once.
+ * @throw None
+ * @param x - the x index of the column.
+ * @param y - the y index of the first tile.
+ * @param length - the number of tiles to replace. They must all be inside the grid.
+ * @param types - the new tile types.
+ * @param oldTypes - where the replaced tile types are copied to.
+ * @return None
+ */
+void TileGrid::writeColumn(unsigned int x, unsigned int y, unsigned int length, const unsigned char* types,
+                           unsigned char* oldTypes)
+{
+    if (length == 0)
+    {
+        return;
+    }
+    std::memcpy(oldTypes, &(*m_tiles)[index(x, y)], length);
+    if (std::memcmp(oldTypes, types, length) == 0)
+    {
+        return;
+    }
+    std::memcpy(&writableTiles()[index(x, y)], types, length);
+    markChanged(x, y, y + length - 1);
+
+    bool erased = false;
+    int firstPainted = -1, lastPainted = -1;
+    for (unsigned int i = 0; i < length; ++i)
+    {
+        if (oldTypes[i] == types[i])
+        {
+            continue;
+        }
+        --m_typeCounts[oldTypes[i]];
+        ++m_typeCounts[types[i]];
+        if (oldTypes[i] == WALL)
+        {
+            ++m_columnCounts[x];
+            ++m_rowCounts[y + i];
+            firstPainted = (firstPainted == -1) ? y + i : firstPainted;
+            lastPainted = y + i;
+        }
+        else if (types[i] == WALL)
+        {
+            --m_columnCounts[x];
+            --m_rowCounts[y + i];
+            erased = true;
+        }
+    }
+
+    if (firstPainted != -1)
+    {
+        if (m_left == -1)
+        {
+            m_left = m_right = x;
+            m_top = firstPainted;
+            m_bottom = lastPainted;
+        }
+        m_left = std::min<int>(m_left, x);
+        m_right = std::max<int>(m_right, x);
+        m_top = std::min(m_top, firstPainted);
+        m_bottom = std::max(m_bottom, lastPainted);
+    }
+    if (erased)
+    {
+        shrinkBounds();
+    }
+}
+
+
+/**
+ * @brief Finds the first tile of a type.
+ * @details Tiles are searched column by column. Types that are not in the
+ * grid are known from the counts without searching.
+ * @throw None
+ * @param type - the texture index to look for.
+ * @param x - set to the x index of the tile if one was found.
+ * @param y - set to the y index of the tile if one was found.
+ * @return bool - true if the grid holds a tile of the type, false if not
+ */
+bool TileGrid::find(unsigned char type, unsigned int& x, unsigned int& y) const
+{
+    if (type >= TYPE_COUNT || m_typeCounts[type] == 0)
+    {
+        return false;
+    }
+    std::size_t i = std::find(m_tiles->begin(), m_tiles->end(), type) - m_tiles->begin();
+    x = i / m_size;
+    y = i % m_size;
+    return true;
+}
+
+
+/**
+ * @brief Reads a .maze file, resizing the grid to fit it.
+ * @details A .maze file holds the grid size followed by the texture index of
+ * every tile, one per line, column by column.
+ * @throw std::bad_alloc if the grid cannot be allocated.
+ * @param fileName - the path of the .maze file.
+ * @return bool - true if the file could be read, false if not
+ */
+bool TileGrid::loadFromFile(const std::string& fileName)
+{
+    PROFILE_ZONE("TileGrid::loadFromFile");
+    MemoryScope memoryScope(MemoryTag::Grid);
+    std::fstream file(fileName, std::ios::in);
+    unsigned int size = 0;
+    if (!(file >> size))
+    {
+        return false;
+    }
+
+    resize(size);
+    std::vector<unsigned char>& tiles = writableTiles();
+    for (std::size_t i = 0; i < tiles.size(); ++i)
+    {
+        unsigned int type = WALL;
+        file >> type;
+        tiles[i] = type < TYPE_COUNT ? type : WALL;
+    }
+    recount();
+    return static_cast<bool>(file);
+}
+
+
+/**
+ * @brief Writes the grid in the .maze file format.
+ * @throw None
+ * @param fileName - the path of the .maze file.
+ * @return bool - true if the file was written, false if not
+ */
+bool TileGrid::saveToFile(const std::string& fileName) const
+{
+    PROFILE_ZONE("TileGrid::saveToFile");
+    std::fstream file(fileName, std::ios::out);
+    file << m_size << '\n';
+    for (std::size_t i = 0; i < m_tiles->size(); ++i)
+    {
+        file << static_cast<unsigned int>((*m_tiles)[i]) << '\n';
+    }
+    return static_cast<bool>(file);
+}
+
+
+/**
+ * @brief Returns the color a tile type is drawn with on minimaps and thumbnails.
+ * @details The game's minimap and the level library's thumbnails both use
+ * it, so the two always agree.
+ * @throw None
+ * @param type - the texture index of the tile.
+ * @return sf::Color - the color of the tile type, transparent for an unknown type
+ */
+sf::Color TileGrid::mapColor(unsigned char type)
+{
+    switch (type)
+    {
+        case 0:     // path
+            return sf::Color(60, 80, 140);
+        case 1:     // trap
+            return sf::Color(150, 70, 40);
+        case 2:     // fire
+            return sf::Color(230, 120, 20);
+        case 3:     // bloodied path
+            return sf::Color(120, 20, 20);
+        case 4:     // stone wall
+            return sf::Color(110, 110, 110);
+        case 5:     // diseased path
+            return sf::Color(70, 160, 60);
+        case 6:     // maze start
+            return sf::Color(220, 40, 40);
+        case 7:     // maze end
+            return sf::Color(240, 220, 80);
+    };
+    return sf::Color::Transparent;
+}
+
+
+/**
+ * @brief Rebuilds every count and the bounding box from the tiles.
+ * @details Only needed when the whole grid changes at once.
+ * @throw std::bad_alloc if the count tables cannot be allocated.
+ * @param None
+ * @return None
+ */
+void TileGrid::recount()
+{
+    m_typeCounts.fill(0);
+    m_columnCounts.assign(m_size, 0);
+    m_rowCounts.assign(m_size, 0);
+    for (unsigned int x = 0; x < m_size; ++x)
+    {
+        for (unsigned int y = 0; y < m_size; ++y)
+        {
+            unsigned char type = (*m_tiles)[index(x, y)];
+            ++m_typeCounts[type];
+            if (type != WALL)
+            {
+                ++m_columnCounts[x];
+                ++m_rowCounts[y];
+            }
+        }
+    }
+
+    m_left = m_top = 0;
+    m_right = m_bottom = static_cast<int>(m_size) - 1;
+    shrinkBounds();
+}
+
+
+/**
+ * @brief Moves the bounding box edges inwards past empty rows and columns.
+ * @details Sets every edge to -1 when there is no non-wall tile left.
+ * @throw None
+ * @param None
+ * @return None
+ */
+void TileGrid::shrinkBounds()
+{
+    if (!hasContent())
+    {
+        m_left = m_right = m_top = m_bottom = -1;
+        return;
+    }
+    while (m_columnCounts[m_left] == 0)
+    {
+        ++m_left;
+    }
+    while (m_columnCounts[m_right] == 0)
+    {
+        --m_right;
+    }
+    while (m_rowCounts[m_top] == 0)
+    {
+        ++m_top;
+    }
+    while (m_rowCounts[m_bottom] == 0)
+    {
+        --m_bottom;
+    }
+}
+
+
+/**
+ * @brief Returns which blocks changed since the last call, and clears the flags.
+ * @details Block (chunkX, chunkY) is at index chunkX * chunksPerSide + chunkY,
+ * where each block is CHANGE_CHUNK tiles wide and high.
+ * @throw std::bad_alloc if the flags cannot be allocated.
+ * @param None
+ * @return std::vector<bool> - the changed blocks
+ */
+std::vector<bool> TileGrid::takeChangedChunks()
+{
+    MemoryScope memoryScope(MemoryTag::Grid);
+    std::vector<bool> changed(m_changedChunks.size(), false);
+    changed.swap(m_changedChunks);
+    return changed;
+}
+
+
+/**
+ * @brief Flags every block as changed.
+ * @details Used when the whole grid is replaced, or when a save that took
+ * the flags failed.
+ * @throw std::bad_alloc if the flags cannot be allocated.
+ * @param None
+ * @return None
+ */
+void TileGrid::markAllChanged()
+{
+    MemoryScope memoryScope(MemoryTag::Grid);
+    unsigned int chunksPerSide = (m_size + CHANGE_CHUNK - 1) / CHANGE_CHUNK;
+    m_changedChunks.assign(static_cast<std::size_t>(chunksPerSide) * chunksPerSide, true);
+    ++m_revision;
+}
+
+
+/**
+ * @brief Returns the bytes allocated for the grid.
+ * @details Counts the capacity of the tiles, the change flags and the row
+ * and column counts. Tiles shared with a snapshot or another grid are
+ * counted by every grid sharing them, unless countTiles is false.
+ * @throw None
+ * @param countTiles - false to leave out the tiles, when another grid already
+ * counted them.
+ * @return std::size_t - the bytes in use
+ */
+std::size_t TileGrid::memoryUsage(bool countTiles) const
+{
+    std::size_t bytes = sizeof(TileGrid) + m_changedChunks.capacity() / 8
+                      + (m_columnCounts.capacity() + m_rowCounts.capacity()) * sizeof(unsigned int);
+    if (countTiles)
+    {
+        bytes += m_tiles->capacity();
+    }
+    return bytes;
+}
+
+
+/**
+ * @brief Returns the tiles for writing, copying them first if a snapshot shares them.
+ * @details The copy happens at most once per snapshot, on the first change
+ * made while it is alive. A snapshot may have been let go of on another
+ * thread that was reading it; the fence orders its reads before the changes
+ * made here.
+ * @throw std::bad_alloc if the tiles cannot be copied.
+ * @param None
+ * @return std::vector<unsigned char>& - the tiles, owned by this grid alone
+ */
+std::vector<unsigned char>& TileGrid::writableTiles()
+{
+    MemoryScope memoryScope(MemoryTag::Grid);
+    if (m_tiles.use_count() > 1)
+    {
+        m_tiles = std::make_shared<std::vector<unsigned char>>(*m_tiles);
+    }
+    std::atomic_thread_fence(std::memory_order_acquire); // pairs with the release of the last other owner
+    return *m_tiles;
+}
+
+
+/**
+ * @brief Flags the blocks covering part of a column.
+ * @throw None
+ * @param x - the x index of the column.
+ * @param firstY - the y index of the first changed tile.
+ * @param lastY - the y index of the last changed tile.
+ * @return None
+ */
+void TileGrid::markChanged(unsigned int x, unsigned int firstY, unsigned int lastY)
+{
+    unsigned int chunksPerSide = (m_size + CHANGE_CHUNK - 1) / CHANGE_CHUNK;
+    for (unsigned int chunkY = firstY / CHANGE_CHUNK; chunkY <= lastY / CHANGE_CHUNK; ++chunkY)
+    {
+        m_changedChunks[static_cast<std::size_t>(x / CHANGE_CHUNK) * chunksPerSide + chunkY] = true;
+    }
+    ++m_revision;
+}
@@ -0,0 +1,102 @@
+#pragma once
+
+
+// Included C++11 Libraries
+#include <vector>
+#include <string>
+#include <fstream>
+#include <array>
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <atomic>
+
+
+// Included Graphics Library Dependencies
+#include <SFML/Graphics.hpp>
+
+
+// Included Local Dependencies
+#include "profiler.h"
+#include "memoryTracker.h"
+
+
+/**
+ * Class Name: TileGrid
+ * Brief: Stores the tile types of a square maze.
+ * Description:
+ *  Each tile is a single byte holding its texture index (0-7), stored column
+ *  by column in the same order as the .maze file format, so reading and
+ *  writing files walks the grid sequentially. Sprites are not stored per
+ *  tile; whoever draws the grid uses one sprite per tile type instead.
+ *  The number of tiles of each type, the number of non-wall tiles in every
+ *  row and column, and the bounding box of the non-wall tiles are kept up to
+ *  date as tiles change, so they can be read without scanning the grid.
+ *  The tiles are copy-on-write: snapshot() shares them without copying, and
+ *  the grid only copies them if it is changed while a snapshot is alive, so
+ *  another thread can read a snapshot while the grid keeps being edited.
+ *  detach() makes that copy up front, for a grid that is about to be
+ *  changed where a copy would be too slow.
+ *  Blocks of CHANGE_CHUNK x CHANGE_CHUNK tiles are flagged as they change,
+ *  so a save can rewrite only the parts of a file that are out of date.
+ */
+class TileGrid
+{
+public:
+    static const unsigned char WALL = 4;    // Texture index of the stone wall, the default tile.
+    static const unsigned int TYPE_COUNT = 8;   // Number of tile types.
+    static const unsigned int CHANGE_CHUNK = 32;    // Width and height of the blocks flagged by changedChunks().
+    typedef std::shared_ptr<const std::vector<unsigned char>> Snapshot;
+
+    // Constructor
+    TileGrid(unsigned int size = 0, unsigned char fill = WALL);
+
+    // Public Member Functions for TileGrid Processes
+    void resize(unsigned int size, unsigned char fill = WALL);     // Resizes the grid and fills every tile with a single type.
+    void assign(unsigned int size, const unsigned char* tiles);   // Replaces the whole grid with a copy of packed tiles.
+    unsigned int size() const {return m_size;}
+    const unsigned char* data() const {return m_tiles->data();}
+    unsigned char get(unsigned int x, unsigned int y) const {return (*m_tiles)[index(x, y)];}
+    unsigned char set(unsigned int x, unsigned int y, unsigned char type);  // Changes a tile and returns its old type.
+    void readColumn(unsigned int x, unsigned int y, unsigned int length, unsigned char* types) const;  // Copies part of a column out of the grid.
+    void writeColumn(unsigned int x, unsigned int y, unsigned int length, const unsigned char* types,
+                     unsigned char* oldTypes);  // Replaces part of a column, returning the old types.
+    std::size_t index(unsigned int x, unsigned int y) const {return static_cast<std::size_t>(x) * m_size + y;}
+    bool find(unsigned char type, unsigned int& x, unsigned int& y) const;  // Finds the first tile of a type.
+    bool loadFromFile(const std::string& fileName);         // Reads a .maze file, resizing the grid to fit it.
+    bool saveToFile(const std::string& fileName) const;     // Writes the grid in the .maze file format.
+    static sf::Color mapColor(unsigned char type);          // Returns the color a tile type is drawn with on minimaps and thumbnails.
+    std::size_t count(unsigned char type) const {return m_typeCounts[type];}
+    std::size_t contentCount() const {return m_tiles->size() - m_typeCounts[WALL];}
+    bool hasContent() const {return contentCount() != 0;}
+    Snapshot snapshot() const {return m_tiles;}
+    void detach() {writableTiles();}    // Gives the grid its own copy of tiles it shares, so changing it never copies them.
+    unsigned long revision() const {return m_revision;}
+    std::vector<bool> takeChangedChunks();  // Returns which blocks changed since the last call, and clears the flags.
+    void markAllChanged();      // Flags every block as changed.
+    std::size_t memoryUsage(bool countTiles = true) const;  // Returns the bytes allocated for the grid.
+
+    // Bounding box of the non-wall tiles (inclusive), -1 when there are none
+    int contentLeft() const {return m_left;}
+    int contentRight() const {return m_right;}
+    int contentTop() const {return m_top;}
+    int contentBottom() const {return m_bottom;}
+
+
+private:
+    // Private Member Functions for TileGrid Processes
+    void recount();     // Rebuilds every count and the bounding box from the tiles.
+    void shrinkBounds();    // Moves the bounding box edges inwards past empty rows and columns.
+    std::vector<unsigned char>& writableTiles();  // Returns the tiles for writing, copying them first if a snapshot shares them.
+    void markChanged(unsigned int x, unsigned int firstY, unsigned int lastY);  // Flags the blocks covering part of a column.
+
+    // Private Member Variables
+    std::shared_ptr<std::vector<unsigned char>> m_tiles;
+    unsigned int m_size;
+    unsigned long m_revision;           // Incremented on every change.
+    std::vector<bool> m_changedChunks;  // Column by column, like the tiles.
+    std::array<std::size_t, TYPE_COUNT> m_typeCounts;
+    std::vector<unsigned int> m_columnCounts;   // Non-wall tiles in each column (x).
+    std::vector<unsigned int> m_rowCounts;      // Non-wall tiles in each row (y).
+    int m_left, m_right, m_top, m_bottom;
+};
@@ -0,0 +1,165 @@
+#include "tileImage.h"
+
+
+/**
+ * @brief TileImage class constructor
+ * @details Creates an empty image. create() must be called before use.
+ * @throw None
+ */
+TileImage::TileImage() :
+m_textureMemory(MemoryTag::Textures),
+m_dirty(0, 0, 0, 0),
+m_size(0),
+m_valid(false)
+{
+}
+
+
+/**
+ * @brief Creates the image and texture, filled with a single color.
+ * @details The whole texture is uploaded once here. Mazes that are larger
+ * than the biggest texture the graphics card supports cannot be displayed, in
+ * which case false is returned and the image stays invalid.
+ * @throw std::bad_alloc if the image cannot be allocated.
+ * @param gridSize - the width and height of the maze in tiles.
+ * @param color - the initial color of every tile.
+ * @return bool - true if the texture was created, false if not
+ */
+bool TileImage::create(unsigned int gridSize, const sf::Color& color)
+{
+    MemoryScope memoryScope(MemoryTag::Textures);
+    m_valid = false;
+    m_size = gridSize;
+    m_dirty = sf::IntRect(0, 0, 0, 0);
+    if (gridSize == 0 || gridSize > sf::Texture::getMaximumSize())
+    {
+        return false;
+    }
+
+    m_image.create(gridSize, gridSize, color);
+    if (!m_texture.create(gridSize, gridSize))
+    {
+        return false;
+    }
+    m_texture.update(m_image);
+    m_textureMemory.set(MemoryTracker::textureBytes(m_texture));
+    m_valid = true;
+    return true;
+}
+
+
+/**
+ * @brief Changes the color of a single tile.
+ * @details The pixel is only changed in the image; the dirty rectangle is
+ * grown to include it so that the next flush() uploads it.
+ * @throw None
+ * @param x - the x index of the tile.
+ * @param y - the y index of the tile.
+ * @param color - the new color of the tile.
+ * @return None
+ */
+void TileImage::setPixel(unsigned int x, unsigned int y, const sf::Color& color)
+{
+    if (!m_valid || x >= m_size || y >= m_size || m_image.getPixel(x, y) == color)
+    {
+        return;
+    }
+    m_image.setPixel(x, y, color);
+    markDirty(sf::IntRect(x, y, 1, 1));
+}
+
+
+/**
+ * @brief Changes the color of part of a column.
+ * @details The dirty rectangle is grown once for the whole run, so filling
+ * a long column costs about as much as writing its pixels. The part outside
+ * the image is ignored.
+ * @throw None
+ * @param x - the x index of the column.
+ * @param y - the y index of the first tile.
+ * @param length - the number of tiles.
+ * @param color - the new color of the tiles.
+ * @return None
+ */
+void TileImage::fillColumn(unsigned int x, unsigned int y, unsigned int length, const sf::Color& color)
+{
+    if (!m_valid || x >= m_size || y >= m_size)
+    {
+        return;
+    }
+    length = std::min(length, m_size - y);
+    for (unsigned int i = 0; i < length; ++i)
+    {
+        m_image.setPixel(x, y + i, color);
+    }
+    markDirty(sf::IntRect(x, y, 1, length));
+}
+
+
+/**
+ * @brief Grows the dirty rectangle to cover a block of pixels.
+ * @throw None
+ * @param pixels - the pixels that changed.
+ * @return None
+ */
+void TileImage::markDirty(const sf::IntRect& pixels)
+{
+    if (m_dirty.width == 0)
+    {
+        m_dirty = pixels;
+        return;
+    }
+    int left = std::min(m_dirty.left, pixels.left);
+    int top = std::min(m_dirty.top, pixels.top);
+    int right = std::max(m_dirty.left + m_dirty.width, pixels.left + pixels.width);
+    int bottom = std::max(m_dirty.top + m_dirty.height, pixels.top + pixels.height);
+    m_dirty = sf::IntRect(left, top, right - left, bottom - top);
+}
+
+
+/**
+ * @brief Uploads the changed pixels to the texture.
+ * @details The dirty rectangle is copied row by row into a contiguous buffer
+ * and uploaded with a single partial texture update. Nothing happens if no
+ * pixel changed.
+ * @throw None
+ * @param None
+ * @return None
+ */
+void TileImage::flush()
+{
+    if (!m_valid || m_dirty.width == 0)
+    {
+        return;
+    }
+
+    const sf::Uint8* pixels = m_image.getPixelsPtr();
+    std::size_t rowBytes = static_cast<std::size_t>(m_dirty.width) * 4;
+    m_uploadBuffer.resize(rowBytes * m_dirty.height);
+    for (int row = 0; row < m_dirty.height; ++row)
+    {
+        const sf::Uint8* source = pixels + (static_cast<std::size_t>(m_dirty.top + row) * m_size + m_dirty.left) * 4;
+        std::copy(source, source + rowBytes, m_uploadBuffer.begin() + row * rowBytes);
+    }
+    m_texture.update(m_uploadBuffer.data(), m_dirty.width, m_dirty.height, m_dirty.left, m_dirty.top);
+    m_dirty = sf::IntRect(0, 0, 0, 0);
+}
+
+
+/**
+ * @brief Uploads the whole image to the texture.
+ * @details Used after writePixel(), which does not track what changed.
+ * Pending setPixel() changes are uploaded too.
+ * @throw None
+ * @param None
+ * @return None
+ */
+void TileImage::upload()
+{
+    if (!m_valid)
+    {
+        return;
+    }
+    m_texture.update(m_image);
+    m_dirty = sf::IntRect(0, 0, 0, 0);
+}
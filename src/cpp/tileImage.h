@@ -0,0 +1,59 @@
+#pragma once
+
+
+// Included C++11 Libraries
+#include <vector>
+#include <algorithm>
+
+
+// Included Graphics Library Dependencies
+#include <SFML/Graphics.hpp>
+
+
+// Included Local Dependencies
+#include "memoryTracker.h"
+
+
+/**
+ * Class Name: TileImage
+ * Brief: An image of a maze with a single pixel per tile.
+ * Description:
+ *  Keeps a CPU side sf::Image and a GPU side sf::Texture of the same size.
+ *  Pixels are changed in the image, and flush() only uploads the rectangle
+ *  of pixels that changed since the previous flush instead of the whole
+ *  texture, so keeping the texture up to date is cheap even for big mazes.
+ *  When every pixel is rewritten, writePixel() skips the dirty tracking, so
+ *  several threads can write different pixels at once, and upload() sends
+ *  the whole image afterwards.
+ */
+class TileImage
+{
+public:
+    // Constructor
+    TileImage();
+
+    // Public Member Functions for TileImage Processes
+    bool create(unsigned int gridSize, const sf::Color& color);    // Creates the image and texture, filled with a single color.
+    void setPixel(unsigned int x, unsigned int y, const sf::Color& color);   // Changes the color of a single tile.
+    void fillColumn(unsigned int x, unsigned int y, unsigned int length, const sf::Color& color);   // Changes the color of part of a column.
+    void writePixel(unsigned int x, unsigned int y, const sf::Color& color) {m_image.setPixel(x, y, color);}   // Changes a tile in the image only, see upload().
+    void flush();                               // Uploads the changed pixels to the texture.
+    void upload();                              // Uploads the whole image to the texture.
+    bool isValid() const {return m_valid;}      // Returns whether the texture could be created.
+    unsigned int getSize() const {return m_size;}
+    const sf::Texture& getTexture() const {return m_texture;}
+
+
+private:
+    // Private Member Functions for TileImage Processes
+    void markDirty(const sf::IntRect& pixels);  // Grows the dirty rectangle to cover a block of pixels.
+
+    // Private Member Variables
+    sf::Image m_image;
+    sf::Texture m_texture;
+    TrackedBytes m_textureMemory;               // Video memory of m_texture.
+    std::vector<sf::Uint8> m_uploadBuffer;      // Reused buffer for copying the dirty rectangle.
+    sf::IntRect m_dirty;                        // Pixels changed since the last flush (empty if width is 0).
+    unsigned int m_size;
+    bool m_valid;
+};
@@ -0,0 +1,253 @@
+#include "visibility.h"
+
+
+/**
+ * @brief Visibility class constructor
+ * @details Creates an empty opacity map. setSize() must be called before
+ * tiles can be marked as opaque.
+ * @throw None
+ */
+Visibility::Visibility() :
+m_gridSize(0),
+m_wordsPerRow(0),
+m_originX(0),
+m_originY(0),
+m_radius(0)
+{
+    for (int i = 0; i < 2 * MAX_RADIUS + 1; ++i)
+    {
+        m_visible[i] = 0;
+    }
+}
+
+
+/**
+ * @brief Resizes the opacity map and marks every tile as transparent.
+ * @details Each row of the maze is stored as a run of 64 bit words so that a
+ * 8192x8192 maze only needs 8MB.
+ * @throw std::bad_alloc if the map cannot be allocated.
+ * @param gridSize - the width and height of the maze in tiles.
+ * @return None
+ */
+void Visibility::setSize(unsigned int gridSize)
+{
+    MemoryScope memoryScope(MemoryTag::Grid);
+    m_gridSize = gridSize;
+    m_wordsPerRow = (gridSize + 63) / 64;
+    m_opaque.assign(static_cast<std::size_t>(m_wordsPerRow) * gridSize, 0);
+}
+
+
+/**
+ * @brief Sets whether a single tile blocks light.
+ * @details Tiles outside of the maze are ignored.
+ * @throw None
+ * @param x - the x index of the tile.
+ * @param y - the y index of the tile.
+ * @param opaque - true if the tile blocks light.
+ * @return None
+ */
+void Visibility::setOpaque(unsigned int x, unsigned int y, bool opaque)
+{
+    if (x >= m_gridSize || y >= m_gridSize)
+    {
+        return;
+    }
+    std::uint64_t& word = m_opaque[static_cast<std::size_t>(y) * m_wordsPerRow + x / 64];
+    std::uint64_t bit = std::uint64_t(1) << (x % 64);
+    if (opaque)
+    {
+        word |= bit;
+    }
+    else
+    {
+        word &= ~bit;
+    }
+}
+
+
+/**
+ * @brief Returns whether a tile blocks light.
+ * @details Tiles outside of the maze are treated as walls so light never
+ * leaves the grid.
+ * @throw None
+ * @param x - the x index of the tile.
+ * @param y - the y index of the tile.
+ * @return bool - true if the tile blocks light, false if not
+ */
+bool Visibility::isOpaque(int x, int y) const
+{
+    if (x < 0 || y < 0 || x >= static_cast<int>(m_gridSize) || y >= static_cast<int>(m_gridSize))
+    {
+        return true;
+    }
+    return (m_opaque[static_cast<std::size_t>(y) * m_wordsPerRow + x / 64] >> (x % 64)) & 1;
+}
+
+
+/**
+ * @brief Recalculates the visible tiles around an origin tile.
+ * @details Uses recursive shadowcasting: each of the eight octants around the
+ * origin is scanned row by row, and opaque tiles narrow the range of slopes
+ * that later rows can be seen through. Every tile is visited at most once, so
+ * the cost only depends on the radius and not on the size of the maze.
+ * @throw None
+ * @param originX - the x index of the tile the light comes from.
+ * @param originY - the y index of the tile the light comes from.
+ * @param radius - the light radius in tiles, clamped to MAX_RADIUS.
+ * @return None
+ */
+void Visibility::compute(int originX, int originY, int radius)
+{
+    // Multipliers for transforming coordinates into each of the eight octants
+    static const int multipliers[4][8] = {
+        {1, 0, 0, -1, -1, 0, 0, 1},
+        {0, 1, -1, 0, 0, -1, 1, 0},
+        {0, 1, 1, 0, 0, -1, -1, 0},
+        {1, 0, 0, 1, -1, 0, 0, -1}
+    };
+
+    m_originX = originX;
+    m_originY = originY;
+    m_radius = std::min(std::max(radius, 0), static_cast<int>(MAX_RADIUS));
+    for (int i = 0; i < 2 * MAX_RADIUS + 1; ++i)
+    {
+        m_visible[i] = 0;
+    }
+
+    markVisible(originX, originY);
+    for (int octant = 0; octant < 8; ++octant)
+    {
+        castLight(1, 1.0f, 0.0f, multipliers[0][octant], multipliers[1][octant],
+                  multipliers[2][octant], multipliers[3][octant]);
+    }
+}
+
+
+/**
+ * @brief Returns whether a tile was visible in the last computation.
+ * @throw None
+ * @param x - the x index of the tile.
+ * @param y - the y index of the tile.
+ * @return bool - true if the tile is lit, false if it is in darkness
+ */
+bool Visibility::isVisible(int x, int y) const
+{
+    int dx = x - m_originX + MAX_RADIUS;
+    int dy = y - m_originY + MAX_RADIUS;
+    if (dx < 0 || dy < 0 || dx > 2 * MAX_RADIUS || dy > 2 * MAX_RADIUS)
+    {
+        return false;
+    }
+    return (m_visible[dy] >> dx) & 1;
+}
+
+
+/**
+ * @brief Returns the visible bits of a maze row.
+ * @details Bit 0 of the returned word is the tile at originX - MAX_RADIUS.
+ * Rows outside of the window are entirely dark.
+ * @throw None
+ * @param y - the y index of the maze row.
+ * @return std::uint64_t - the visible bits of the row
+ */
+std::uint64_t Visibility::visibleRow(int y) const
+{
+    int dy = y - m_originY + MAX_RADIUS;
+    if (dy < 0 || dy > 2 * MAX_RADIUS)
+    {
+        return 0;
+    }
+    return m_visible[dy];
+}
+
+
+/**
+ * @brief Scans a single octant.
+ * @details Walks outwards from the origin one row at a time, between the
+ * start and end slopes. When a run of opaque tiles ends, the remaining slopes
+ * continue in this call; when one begins, the slopes before it are scanned by
+ * a recursive call.
+ * @throw None
+ * @param row - the distance of the first row to scan.
+ * @param start - the slope the scan starts at.
+ * @param end - the slope the scan ends at.
+ * @param xx, xy, yx, yy - the octant transformation multipliers.
+ * @return None
+ */
+void Visibility::castLight(int row, float start, float end, int xx, int xy, int yx, int yy)
+{
+    if (start < end)
+    {
+        return;
+    }
+
+    const int radiusSquared = m_radius * m_radius + m_radius;
+    float newStart = 0.0f;
+    for (int distance = row; distance <= m_radius; ++distance)
+    {
+        bool blocked = false;
+        int dy = -distance;
+        for (int dx = -distance; dx <= 0; ++dx)
+        {
+            float leftSlope = (dx - 0.5f) / (dy + 0.5f);
+            float rightSlope = (dx + 0.5f) / (dy - 0.5f);
+            if (start < rightSlope)
+            {
+                continue;
+            }
+            if (end > leftSlope)
+            {
+                break;
+            }
+
+            int x = m_originX + dx * xx + dy * xy;
+            int y = m_originY + dx * yx + dy * yy;
+            if (dx * dx + dy * dy <= radiusSquared)
+            {
+                markVisible(x, y);
+            }
+
+            bool opaque = isOpaque(x, y);
+            if (blocked)
+            {
+                if (opaque)
+                {
+                    newStart = rightSlope;
+                    continue;
+                }
+                blocked = false;
+                start = newStart;
+            }
+            else if (opaque && distance < m_radius)
+            {
+                blocked = true;
+                castLight(distance + 1, start, leftSlope, xx, xy, yx, yy);
+                newStart = rightSlope;
+            }
+        }
+        if (blocked)
+        {
+            break;
+        }
+    }
+}
+
+
+/**
+ * @brief Sets the visible bit of a tile inside the window.
+ * @throw None
+ * @param x - the x index of the tile.
+ * @param y - the y index of the tile.
+ * @return None
+ */
+void Visibility::markVisible(int x, int y)
+{
+    int dx = x - m_originX + MAX_RADIUS;
+    int dy = y - m_originY + MAX_RADIUS;
+    if (dx < 0 || dy < 0 || dx > 2 * MAX_RADIUS || dy > 2 * MAX_RADIUS)
+    {
+        return;
+    }
+    m_visible[dy] |= std::uint64_t(1) << dx;
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+
+// Included C++11 Libraries
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+
+
+// Included Local Dependencies
+#include "memoryTracker.h"
+
+
+/**
+ * Class Name: Visibility
+ * Brief: Calculates which tiles of the maze the player can see.
+ * Description:
+ *  Stores a bit per tile marking whether the tile blocks light (walls) and
+ *  uses recursive shadowcasting to calculate the tiles that are visible from
+ *  a given origin tile. The result is kept in a small window of
+ *  (2 * MAX_RADIUS + 1) rows centered on the origin, where each row is a
+ *  single 64 bit word, so clearing and querying it is very cheap.
+ */
+class Visibility
+{
+public:
+    static const int MAX_RADIUS = 31;   // Largest supported light radius (a window row must fit in 64 bits).
+
+    // Constructor
+    Visibility();
+
+    // Public Member Functions for Visibility Processes
+    void setSize(unsigned int gridSize);                    // Resizes the opacity map and marks every tile as transparent.
+    void setOpaque(unsigned int x, unsigned int y, bool opaque);    // Sets whether a single tile blocks light.
+    bool isOpaque(int x, int y) const;                      // Returns whether a tile blocks light (out of bounds tiles always do).
+    void compute(int originX, int originY, int radius);     // Recalculates the visible tiles around an origin tile.
+    bool isVisible(int x, int y) const;                     // Returns whether a tile was visible in the last computation.
+    std::uint64_t visibleRow(int y) const;                  // Returns the visible bits of a maze row (bit 0 is originX - MAX_RADIUS).
+    int originX() const {return m_originX;}
+    int originY() const {return m_originY;}
+    int radius() const {return m_radius;}
+
+
+private:
+    // Private Member Functions for Visibility Processes
+    void castLight(int row, float start, float end, int xx, int xy, int yx, int yy);   // Scans a single octant.
+    void markVisible(int x, int y);                         // Sets the visible bit of a tile inside the window.
+
+    // Private Member Variables
+    std::vector<std::uint64_t> m_opaque;    // One bit per tile, row major.
+    std::uint64_t m_visible[2 * MAX_RADIUS + 1];            // Visible window, one word per row.
+    unsigned int m_gridSize;
+    unsigned int m_wordsPerRow;
+    int m_originX;
+    int m_originY;
+    int m_radius;
+};